@@ -0,0 +1,94 @@
+// Reverse pass of a sum of log densities, serial and with grad_parallel().
+//
+// Build and run from the Stan Math directory with
+//
+//   make benchmarks/grad_parallel
+//   ./benchmarks/grad_parallel
+//
+// The first argument of every benchmark is the number of observations,
+// the second the number of threads of the task arena running
+// grad_parallel(). Only the reverse pass is timed; the tape is recorded
+// once per benchmark.
+#include <benchmark/benchmark.h>
+#include <stan/math.hpp>
+#include <tbb/task_arena.h>
+#include <chrono>
+#include <vector>
+
+namespace {
+
+constexpr int num_predictors = 5;
+
+/**
+ * Log density of a linear regression with one normal_lpdf term per
+ * observation, joined by a final sum.
+ */
+template <typename T>
+T lpdf_sum(const std::vector<T>& theta, const Eigen::MatrixXd& x,
+           const Eigen::VectorXd& y) {
+  const T sigma = stan::math::exp(theta[1]);
+  std::vector<T> terms(y.size());
+  for (Eigen::Index n = 0; n < y.size(); ++n) {
+    T mu = theta[0];
+    for (int k = 0; k < num_predictors; ++k) {
+      mu += x(n, k) * theta[2 + k];
+    }
+    terms[n] = stan::math::normal_lpdf(y(n), mu, sigma);
+  }
+  return stan::math::sum(terms);
+}
+
+template <typename Sweep>
+void run_reverse_pass(benchmark::State& state, const Sweep& sweep) {
+  const int num_obs = state.range(0);
+  Eigen::MatrixXd x = Eigen::MatrixXd::Random(num_obs, num_predictors);
+  Eigen::VectorXd y = Eigen::VectorXd::Random(num_obs);
+  std::vector<stan::math::var> theta(2 + num_predictors, 0.1);
+  stan::math::var lp = lpdf_sum(theta, x, y);
+  for (auto _ : state) {
+    stan::math::set_zero_all_adjoints();
+    auto start = std::chrono::high_resolution_clock::now();
+
+    sweep(lp);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds
+        = std::chrono::duration_cast<std::chrono::duration<double>>(end
+                                                                    - start);
+    state.SetIterationTime(elapsed_seconds.count());
+    benchmark::DoNotOptimize(theta[2].adj());
+  }
+  stan::math::recover_memory();
+}
+
+static void grad_serial(benchmark::State& state) {
+  run_reverse_pass(state, [](stan::math::var& lp) { lp.grad(); });
+}
+
+static void grad_parallel(benchmark::State& state) {
+  tbb::task_arena arena(state.range(1));
+  run_reverse_pass(state, [&arena](stan::math::var& lp) {
+    arena.execute([&lp] { stan::math::grad_parallel(lp.vi_); });
+  });
+}
+
+static void num_obs_args(benchmark::internal::Benchmark* b) {
+  for (int num_obs : {1 << 12, 1 << 15, 1 << 18}) {
+    b->Args({num_obs, 1});
+  }
+}
+
+static void num_obs_threads_args(benchmark::internal::Benchmark* b) {
+  for (int num_obs : {1 << 12, 1 << 15, 1 << 18}) {
+    for (int threads : {1, 2, 4, 8}) {
+      b->Args({num_obs, threads});
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(grad_serial)->Apply(num_obs_args)->UseManualTime();
+BENCHMARK(grad_parallel)->Apply(num_obs_threads_args)->UseManualTime();
+
+BENCHMARK_MAIN();
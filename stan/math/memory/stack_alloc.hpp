@@ -10,6 +10,9 @@
 #include <sstream>
 #include <stdexcept>
 #include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 namespace stan {
 namespace math {
@@ -32,6 +35,9 @@ bool is_aligned(T* ptr, unsigned int bytes_aligned) {
 
 namespace internal {
 const size_t DEFAULT_INITIAL_NBYTES = 1 << 16;  // 64KB
+const size_t HUGE_PAGE_NBYTES = 1 << 21;        // 2MB
+const size_t PAGE_NBYTES = 1 << 12;             // 4KB
+const size_t SIMD_ALIGNMENT_NBYTES = 64;        // AVX-512 / cache line
 
 // FIXME: enforce alignment
 // big fun to inline, but only called twice
@@ -50,6 +56,128 @@ inline char* eight_byte_aligned_malloc(size_t size) {
 }
 }  // namespace internal
 
+/**
+ * Policy for the blocks of memory allocated by a <code>stack_alloc</code>.
+ *
+ * By default the first block holds 64KB and every new block is twice
+ * as large as the previous one, allocated with <code>malloc()</code>.
+ *
+ * If <code>huge_pages</code> is set, blocks of at least 2MB are rounded
+ * up to a multiple of 2MB and mapped with <code>mmap()</code>, asking for
+ * explicit huge pages first and falling back to transparent huge pages
+ * (<code>madvise(MADV_HUGEPAGE)</code>) and then to <code>malloc()</code>.
+ * This reduces TLB misses when sweeping over large tapes. Huge pages are
+ * only supported on Linux and ignored elsewhere.
+ *
+ * If <code>first_touch</code> is set, every page of a new block is
+ * written once by the thread allocating it. Under the default first-touch
+ * NUMA policy of the operating system the block then resides on the
+ * memory node of the thread owning the allocator, rather than on the
+ * node of whichever thread first writes to it.
+ *
+ * By default all blocks are kept until <code>free_all()</code> is
+ * called. If <code>release_after_recoveries</code> is positive, a block
+ * other than the first one that has not been used for that many calls to
+ * <code>recover_all()</code> is returned to the system. If
+ * <code>max_retained_nbytes</code> is positive, the most recently
+ * allocated blocks are returned to the system on
+ * <code>recover_all()</code> until at most that many bytes are retained,
+ * though the first block is always kept. Blocks are only released when
+ * no nested allocations are active.
+ */
+struct stack_alloc_policy {
+  size_t initial_nbytes_ = internal::DEFAULT_INITIAL_NBYTES;
+  double growth_factor_ = 2.0;
+  bool huge_pages_ = false;
+  bool first_touch_ = false;
+  size_t release_after_recoveries_ = 0;
+  size_t max_retained_nbytes_ = 0;
+};
+
+/**
+ * Return the policy used by allocators constructed without an explicit
+ * policy, including the allocator of the autodiff stack of every thread
+ * started after the policy has been changed.
+ *
+ * Changing the default policy is not thread safe and should happen
+ * before any allocators are constructed.
+ *
+ * @return Reference to the default policy.
+ */
+inline stack_alloc_policy& default_stack_alloc_policy() {
+  static stack_alloc_policy policy;
+  return policy;
+}
+
+namespace internal {
+/**
+ * Allocate a block of memory of at least the specified size according
+ * to the specified policy.
+ *
+ * @param[in, out] size Requested size, set to the size of the block.
+ * @param[in] policy Block policy.
+ * @param[out] mapped Set to true if the block was allocated with mmap.
+ * @return Pointer to the block, or <code>nullptr</code> on failure.
+ */
+inline char* allocate_block(size_t& size, const stack_alloc_policy& policy,
+                            bool& mapped) {
+  char* ptr = nullptr;
+  mapped = false;
+#ifdef __linux__
+  if (policy.huge_pages_ && size >= HUGE_PAGE_NBYTES) {
+    size = (size + HUGE_PAGE_NBYTES - 1) / HUGE_PAGE_NBYTES * HUGE_PAGE_NBYTES;
+    void* map = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    map = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (map == MAP_FAILED) {
+      map = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if (map != MAP_FAILED) {
+        madvise(map, size, MADV_HUGEPAGE);
+      }
+#endif
+    }
+    if (map != MAP_FAILED) {
+      ptr = static_cast<char*>(map);
+      mapped = true;
+    }
+  }
+#endif
+  if (!ptr) {
+    ptr = eight_byte_aligned_malloc(size);
+  }
+  if (ptr && policy.first_touch_) {
+    for (size_t i = 0; i < size; i += PAGE_NBYTES) {
+      ptr[i] = 0;
+    }
+  }
+  return ptr;
+}
+
+/**
+ * Free a block allocated by <code>allocate_block()</code>.
+ *
+ * @param ptr Pointer to the block.
+ * @param size Size of the block.
+ * @param mapped True if the block was allocated with mmap.
+ */
+inline void free_block(char* ptr, size_t size, bool mapped) {
+  if (!ptr) {
+    return;
+  }
+#ifdef __linux__
+  if (mapped) {
+    munmap(ptr, size);
+    return;
+  }
+#endif
+  free(ptr);
+}
+}  // namespace internal
+
 /**
  * An instance of this class provides a memory pool through
  * which blocks of raw memory may be allocated and then collected
@@ -60,7 +188,8 @@ inline char* eight_byte_aligned_malloc(size_t size) {
  * include objects whose destructors have no effect.
  *
  * Memory is allocated on a stack of blocks.  Each block allocated
- * is twice as large as the previous one.  The memory may be
+ * is twice as large as the previous one, unless a different
+ * <code>stack_alloc_policy</code> is used.  The memory may be
  * recovered, with the blocks being reused, or all blocks may be
  * freed, resetting the stack of blocks to its original state.
  *
@@ -74,14 +203,35 @@ class stack_alloc {
   std::vector<char*> blocks_;  // storage for blocks,
                                // may be bigger than cur_block_
   std::vector<size_t> sizes_;  // could store initial & shift for others
+  std::vector<bool> mapped_;   // which blocks were allocated with mmap
+  std::vector<size_t> last_used_;  // recovery in which block was last used
+  size_t num_recoveries_{0};       // calls to recover_all()
+  stack_alloc_policy policy_;
   size_t cur_block_;           // index into blocks_ for next alloc
   char* cur_block_end_;        // ptr to cur_block_ptr_ + sizes_[cur_block_]
   char* next_loc_;             // ptr to next available spot in cur
                                // block
-  // next three for keeping track of nested allocations on top of stack:
+  size_t bytes_before_cur_block_{0};  // sum of sizes_ before cur_block_
+  size_t bytes_retained_{0};          // sum of sizes_
+  size_t peak_bytes_used_{0};         // peak of bytes_used() before
+                                      // the last recovery
+  // next four for keeping track of nested allocations on top of stack:
   std::vector<size_t> nested_cur_blocks_;
   std::vector<char*> nested_next_locs_;
   std::vector<char*> nested_cur_block_ends_;
+  std::vector<size_t> nested_bytes_before_cur_blocks_;
+
+  /**
+   * Update the peak of the bytes in use before they drop. Between
+   * recoveries the bytes in use only grow, so the peak only needs to be
+   * taken when memory is recovered.
+   */
+  inline void update_peak() noexcept {
+    const size_t used = bytes_used();
+    if (used > peak_bytes_used_) {
+      peak_bytes_used_ = used;
+    }
+  }
 
   /**
    * Moves us to the next block of memory, allocating that block
@@ -93,24 +243,33 @@ class stack_alloc {
    */
   char* move_to_next_block(size_t len) {
     char* result;
+    bytes_before_cur_block_ += sizes_[cur_block_];
     ++cur_block_;
     // Find the next block (if any) containing at least len bytes.
     while ((cur_block_ < blocks_.size()) && (sizes_[cur_block_] < len)) {
+      bytes_before_cur_block_ += sizes_[cur_block_];
       ++cur_block_;
     }
     // Allocate a new block if necessary.
     if (unlikely(cur_block_ >= blocks_.size())) {
-      // New block should be max(2*size of last block, len) bytes.
-      size_t newsize = sizes_.back() * 2;
+      // New block should be max(growth * size of last block, len) bytes.
+      size_t newsize = static_cast<size_t>(sizes_.back()
+                                           * policy_.growth_factor_);
       if (newsize < len) {
         newsize = len;
       }
-      blocks_.push_back(internal::eight_byte_aligned_malloc(newsize));
-      if (!blocks_.back()) {
+      bool mapped;
+      char* block = internal::allocate_block(newsize, policy_, mapped);
+      if (!block) {
         throw std::bad_alloc();
       }
+      blocks_.push_back(block);
       sizes_.push_back(newsize);
+      mapped_.push_back(mapped);
+      last_used_.push_back(num_recoveries_);
+      bytes_retained_ += newsize;
     }
+    last_used_[cur_block_] = num_recoveries_;
     result = blocks_[cur_block_];
     // Get the object's state back in order.
     next_loc_ = result + len;
@@ -118,27 +277,115 @@ class stack_alloc {
     return result;
   }
 
+  /**
+   * Return the specified pointer rounded up to the next multiple of the
+   * specified alignment.
+   */
+  template <size_t Alignment>
+  static inline char* align_up(char* ptr) {
+    return reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(ptr) + Alignment - 1)
+        & ~static_cast<uintptr_t>(Alignment - 1));
+  }
+
+  /**
+   * Return the blocks other than the first one to the system that are
+   * unused for the number of recoveries given by the policy, then the
+   * most recently allocated blocks until the retained bytes are within
+   * the cap of the policy.  Must only be called when the allocator
+   * holds no live allocations in blocks other than the first one.
+   */
+  inline void release_blocks() {
+    const size_t max_unused = policy_.release_after_recoveries_;
+    const size_t max_nbytes = policy_.max_retained_nbytes_;
+    if (max_unused == 0 && max_nbytes == 0) {
+      return;
+    }
+    size_t retained = 0;
+    size_t kept = 1;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      if (i > 0 && max_unused > 0
+          && num_recoveries_ - last_used_[i] >= max_unused) {
+        internal::free_block(blocks_[i], sizes_[i], mapped_[i]);
+        continue;
+      }
+      if (i > 0) {
+        blocks_[kept] = blocks_[i];
+        sizes_[kept] = sizes_[i];
+        mapped_[kept] = mapped_[i];
+        last_used_[kept] = last_used_[i];
+        ++kept;
+      }
+      retained += sizes_[i];
+    }
+    while (max_nbytes > 0 && kept > 1 && retained > max_nbytes) {
+      --kept;
+      retained -= sizes_[kept];
+      internal::free_block(blocks_[kept], sizes_[kept], mapped_[kept]);
+    }
+    blocks_.resize(kept);
+    sizes_.resize(kept);
+    mapped_.resize(kept);
+    last_used_.resize(kept);
+    bytes_retained_ = retained;
+  }
+
  public:
   /**
-   * Construct a resizable stack allocator initially holding the
-   * specified number of bytes.
+   * Construct a resizable stack allocator with the specified block
+   * policy.
    *
-   * @param initial_nbytes Initial number of bytes for the
-   * allocator.  Defaults to <code>(1 << 16) = 64KB</code> initial bytes.
+   * @param policy Block policy for the allocator.
    * @throws std::runtime_error if the underlying malloc is not 8-byte
    * aligned.
    */
-  explicit stack_alloc(size_t initial_nbytes = internal::DEFAULT_INITIAL_NBYTES)
-      : blocks_(1, internal::eight_byte_aligned_malloc(initial_nbytes)),
-        sizes_(1, initial_nbytes),
-        cur_block_(0),
-        cur_block_end_(blocks_[0] + initial_nbytes),
-        next_loc_(blocks_[0]) {
-    if (!blocks_[0]) {
+  explicit stack_alloc(const stack_alloc_policy& policy)
+      : policy_(policy), cur_block_(0) {
+    if (!(policy_.growth_factor_ >= 1.0)) {
+      throw std::invalid_argument(
+          "stack_alloc: growth factor must be at least 1");
+    }
+    size_t size = policy_.initial_nbytes_;
+    bool mapped;
+    char* block = internal::allocate_block(size, policy_, mapped);
+    if (!block) {
       throw std::bad_alloc();  // no msg allowed in bad_alloc ctor
     }
+    blocks_.push_back(block);
+    sizes_.push_back(size);
+    mapped_.push_back(mapped);
+    last_used_.push_back(0);
+    bytes_retained_ = size;
+    cur_block_end_ = blocks_[0] + size;
+    next_loc_ = blocks_[0];
   }
 
+  /**
+   * Construct a resizable stack allocator initially holding the
+   * specified number of bytes, using the default policy otherwise.
+   *
+   * @param initial_nbytes Initial number of bytes for the
+   * allocator.
+   * @throws std::runtime_error if the underlying malloc is not 8-byte
+   * aligned.
+   */
+  explicit stack_alloc(size_t initial_nbytes)
+      : stack_alloc([initial_nbytes]() {
+          stack_alloc_policy policy = default_stack_alloc_policy();
+          policy.initial_nbytes_ = initial_nbytes;
+          return policy;
+        }()) {}
+
+  /**
+   * Construct a resizable stack allocator with the default policy,
+   * which initially holds <code>(1 << 16) = 64KB</code> bytes unless
+   * changed through <code>default_stack_alloc_policy()</code>.
+   *
+   * @throws std::runtime_error if the underlying malloc is not 8-byte
+   * aligned.
+   */
+  stack_alloc() : stack_alloc(default_stack_alloc_policy()) {}
+
   /**
    * Destroy this memory allocator.
    *
@@ -147,11 +394,29 @@ class stack_alloc {
    */
   ~stack_alloc() {
     // free ALL blocks
-    for (auto& block : blocks_) {
-      if (block) {
-        free(block);
-      }
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      internal::free_block(blocks_[i], sizes_[i], mapped_[i]);
+    }
+  }
+
+  /**
+   * Return the block policy of this allocator.
+   */
+  inline const stack_alloc_policy& policy() const noexcept { return policy_; }
+
+  /**
+   * Set the block policy of this allocator. The policy applies to
+   * blocks allocated from now on; existing blocks are kept.
+   *
+   * @param policy Block policy for the allocator.
+   * @throws std::invalid_argument if the growth factor is less than 1
+   */
+  inline void set_policy(const stack_alloc_policy& policy) {
+    if (!(policy.growth_factor_ >= 1.0)) {
+      throw std::invalid_argument(
+          "stack_alloc: growth factor must be at least 1");
     }
+    policy_ = policy;
   }
 
   /**
@@ -181,6 +446,50 @@ class stack_alloc {
     return reinterpret_cast<void*>(result);
   }
 
+  /**
+   * Return a newly allocated block of memory of the appropriate size
+   * managed by the stack allocator, aligned on the specified number of
+   * bytes.
+   *
+   * Up to <code>Alignment - 8</code> bytes are skipped to align the
+   * allocation, so this should only be used for allocations that
+   * benefit from the alignment, such as the values of large matrices.
+   * The reserved space is padded up to the next multiple of 8 bytes.
+   *
+   * @tparam Alignment Number of bytes of alignment, a power of 2 that
+   * is at least 8.
+   * @param len Number of bytes to allocate.
+   * @return A pointer to the allocated memory.
+   */
+  template <size_t Alignment>
+  inline void* alloc_aligned(size_t len) {
+    static_assert(Alignment >= 8 && (Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of 2 that is at least 8");
+    size_t pad = len % 8 == 0 ? 0 : 8 - len % 8;
+    char* result = align_up<Alignment>(next_loc_);
+    if (unlikely(result + len + pad >= cur_block_end_)) {
+      move_to_next_block(len + pad + Alignment);
+      result = align_up<Alignment>(blocks_[cur_block_]);
+    }
+    next_loc_ = result + len + pad;
+    return reinterpret_cast<void*>(result);
+  }
+
+  /**
+   * Allocate an array on the arena of the specified size to hold
+   * values of the specified template parameter type, aligned on the
+   * specified number of bytes.
+   *
+   * @tparam T type of entries in allocated array.
+   * @tparam Alignment Number of bytes of alignment.
+   * @param[in] n size of array to allocate.
+   * @return new array allocated on the arena.
+   */
+  template <typename T, size_t Alignment>
+  inline T* alloc_array_aligned(size_t n) {
+    return static_cast<T*>(alloc_aligned<Alignment>(n * sizeof(T)));
+  }
+
   /**
    * Allocate an array on the arena of the specified size to hold
    * values of the specified template parameter type.
@@ -197,10 +506,17 @@ class stack_alloc {
   /**
    * Recover all the memory used by the stack allocator.  The stack
    * of memory blocks allocated so far will be available for further
-   * allocations.  To free memory back to the system, use the
-   * function free_all().
+   * allocations, except for the blocks released according to the
+   * policy of the allocator.  To free memory back to the system, use
+   * the function free_all().
    */
   inline void recover_all() {
+    update_peak();
+    if (nested_cur_blocks_.empty()) {
+      release_blocks();
+      ++num_recoveries_;
+    }
+    bytes_before_cur_block_ = 0;
     cur_block_ = 0;
     next_loc_ = blocks_[0];
     cur_block_end_ = next_loc_ + sizes_[0];
@@ -214,6 +530,7 @@ class stack_alloc {
     nested_cur_blocks_.push_back(cur_block_);
     nested_next_locs_.push_back(next_loc_);
     nested_cur_block_ends_.push_back(cur_block_end_);
+    nested_bytes_before_cur_blocks_.push_back(bytes_before_cur_block_);
   }
 
   /**
@@ -223,6 +540,7 @@ class stack_alloc {
     if (unlikely(nested_cur_blocks_.empty())) {
       recover_all();
     }
+    update_peak();
 
     cur_block_ = nested_cur_blocks_.back();
     nested_cur_blocks_.pop_back();
@@ -232,6 +550,9 @@ class stack_alloc {
 
     cur_block_end_ = nested_cur_block_ends_.back();
     nested_cur_block_ends_.pop_back();
+
+    bytes_before_cur_block_ = nested_bytes_before_cur_blocks_.back();
+    nested_bytes_before_cur_blocks_.pop_back();
   }
 
   /**
@@ -242,12 +563,13 @@ class stack_alloc {
   inline void free_all() {
     // frees all BUT the first (index 0) block
     for (size_t i = 1; i < blocks_.size(); ++i) {
-      if (blocks_[i]) {
-        free(blocks_[i]);
-      }
+      internal::free_block(blocks_[i], sizes_[i], mapped_[i]);
     }
     sizes_.resize(1);
     blocks_.resize(1);
+    mapped_.resize(1);
+    last_used_.resize(1);
+    bytes_retained_ = sizes_[0];
     recover_all();
   }
 
@@ -261,12 +583,65 @@ class stack_alloc {
    *
    * @return number of bytes allocated to this instance
    */
-  inline size_t bytes_allocated() const {
-    size_t sum = 0;
-    for (size_t i = 0; i <= cur_block_; ++i) {
-      sum += sizes_[i];
+  inline size_t bytes_allocated() const noexcept {
+    return bytes_before_cur_block_ + sizes_[cur_block_];
+  }
+
+  /**
+   * Return number of bytes held by this instance, including blocks
+   * that are not in use since the last call to
+   * <code>recover_all()</code>.
+   *
+   * @return number of bytes retained by this instance
+   */
+  inline size_t bytes_retained() const noexcept { return bytes_retained_; }
+
+  /**
+   * Return number of bytes handed out by the stack allocator since
+   * the last call to <code>recover_all()</code>.  Unlike
+   * <code>bytes_allocated()</code>, this does not count the unused
+   * space at the end of the current block, but it does count the
+   * space skipped at the end of earlier blocks.
+   *
+   * @return number of bytes in use
+   */
+  inline size_t bytes_used() const noexcept {
+    return bytes_before_cur_block_ + (next_loc_ - blocks_[cur_block_]);
+  }
+
+  /**
+   * Return the largest number of bytes in use, as returned by
+   * <code>bytes_used()</code>, since this instance was constructed or
+   * since the last call to <code>reset_peak_bytes_used()</code>.
+   *
+   * @return peak number of bytes in use
+   */
+  inline size_t peak_bytes_used() const noexcept {
+    const size_t used = bytes_used();
+    return used > peak_bytes_used_ ? used : peak_bytes_used_;
+  }
+
+  /**
+   * Restart tracking the peak number of bytes in use from the number
+   * of bytes in use now.
+   */
+  inline void reset_peak_bytes_used() noexcept {
+    peak_bytes_used_ = bytes_used();
+  }
+
+  /**
+   * Make sure that the next <code>len</code> bytes can be allocated
+   * without switching blocks.  If the current block does not have
+   * enough free space left, the allocator moves on to (or allocates)
+   * a block holding at least <code>len</code> bytes.  No memory is
+   * handed out by this call.
+   *
+   * @param len Number of bytes to reserve.
+   */
+  inline void reserve(size_t len) {
+    if (static_cast<size_t>(cur_block_end_ - next_loc_) <= len) {
+      next_loc_ = move_to_next_block(len);
     }
-    return sum;
   }
 
   /**
@@ -0,0 +1,383 @@
+#ifndef STAN_MATH_PRIM_CORE_TRACE_EVENTS_HPP
+#define STAN_MATH_PRIM_CORE_TRACE_EVENTS_HPP
+
+#include <stan/math/prim/err/invalid_argument.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Begin or end event of a region of the timeline recorded by
+ * `start_trace()`.
+ */
+struct trace_event {
+  /**
+   * Name of the region.
+   */
+  std::string name_;
+  /**
+   * Category of the region, such as "profile" or "reduce_sum".
+   */
+  const char* category_;
+  /**
+   * 'B' for the beginning and 'E' for the end of the region.
+   */
+  char phase_;
+  /**
+   * Time of the event in microseconds since the trace was started.
+   */
+  double timestamp_;
+  /**
+   * Arguments of the event as the members of a JSON object, or empty.
+   */
+  std::string args_;
+};
+
+namespace internal {
+
+/**
+ * Events recorded by one thread. Only the owning thread appends to
+ * `events_`; the mutex guards the events against the threads clearing
+ * or reading them.
+ */
+struct trace_buffer {
+  int thread_;
+  std::mutex mutex_;
+  /**
+   * Trace the events belong to.
+   */
+  std::uint64_t trace_;
+  std::vector<trace_event> events_;
+};
+
+/**
+ * State of the process wide trace recorder.
+ */
+struct trace_recorder {
+  std::atomic<bool> recording_{false};
+  /**
+   * Identifier of the current trace, counting the calls of
+   * `start_trace()`. Zero before the first trace.
+   */
+  std::atomic<std::uint64_t> trace_{0};
+  /**
+   * Start of the current trace, in nanoseconds since the epoch of the
+   * steady clock.
+   */
+  std::atomic<std::int64_t> start_{0};
+  /**
+   * Guards the list of buffers and serializes the calls of
+   * `start_trace()`.
+   */
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<trace_buffer>> buffers_;
+};
+
+inline trace_recorder& get_trace_recorder() {
+  static trace_recorder recorder;
+  return recorder;
+}
+
+/**
+ * Return the event buffer of the current thread, registering it with
+ * the recorder when the thread records its first event.
+ */
+inline trace_buffer& local_trace_buffer() {
+  static thread_local std::shared_ptr<trace_buffer> buffer = [] {
+    auto& recorder = get_trace_recorder();
+    auto new_buffer = std::make_shared<trace_buffer>();
+    std::lock_guard<std::mutex> lock(recorder.mutex_);
+    new_buffer->thread_ = recorder.buffers_.size() + 1;
+    new_buffer->trace_ = recorder.trace_.load(std::memory_order_relaxed);
+    recorder.buffers_.push_back(new_buffer);
+    return new_buffer;
+  }();
+  return *buffer;
+}
+
+/**
+ * Return the current time in nanoseconds since the epoch of the steady
+ * clock.
+ */
+inline std::int64_t trace_clock_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Append an event to the buffer of the current thread if the specified
+ * trace is still the current one.
+ *
+ * @param trace identifier of the trace to record the event in
+ * @param phase 'B' for the beginning and 'E' for the end of a region
+ * @param name name of the region
+ * @param category category of the region
+ * @param args arguments of the event as the members of a JSON object
+ * @return true if the event was recorded
+ */
+inline bool trace_event_append(std::uint64_t trace, char phase,
+                               std::string&& name, const char* category,
+                               std::string&& args) {
+  const std::int64_t now = trace_clock_now();
+  trace_buffer& buffer = local_trace_buffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex_);
+  // the buffer is moved to a new trace by `start_trace()` while holding
+  // its mutex, after the start of the new trace is set
+  if (trace == 0 || buffer.trace_ != trace) {
+    return false;
+  }
+  const std::int64_t start
+      = get_trace_recorder().start_.load(std::memory_order_relaxed);
+  buffer.events_.push_back({std::move(name), category, phase,
+                            (now - start) / 1000.0, std::move(args)});
+  return true;
+}
+
+/**
+ * Write the string as a JSON string literal.
+ */
+inline void write_json_string(std::ostream& os, const std::string& s) {
+  os << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (c == '\n') {
+      os << "\\n";
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+}  // namespace internal
+
+/**
+ * Return true if a trace is being recorded.
+ */
+inline bool is_tracing() noexcept {
+  return internal::get_trace_recorder().recording_.load(
+      std::memory_order_relaxed);
+}
+
+/**
+ * Start recording a timeline of the profile regions, the `reduce_sum`
+ * chunks, the `map_rect` jobs and the reverse passes run by all threads,
+ * discarding the events recorded before. Regions which begin before the
+ * trace is started are not recorded, and neither are the ends of
+ * regions which began in an earlier trace.
+ */
+inline void start_trace() {
+  auto& recorder = internal::get_trace_recorder();
+  std::lock_guard<std::mutex> lock(recorder.mutex_);
+  const std::uint64_t trace
+      = recorder.trace_.load(std::memory_order_relaxed) + 1;
+  recorder.start_.store(internal::trace_clock_now(),
+                        std::memory_order_relaxed);
+  recorder.trace_.store(trace, std::memory_order_release);
+  for (auto& buffer : recorder.buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex_);
+    buffer->events_.clear();
+    buffer->trace_ = trace;
+  }
+  recorder.recording_.store(true, std::memory_order_release);
+}
+
+/**
+ * Stop recording the timeline. The recorded events are kept until the
+ * next call to `start_trace()`. The ends of the regions recorded so far
+ * are still recorded, so that every recorded region is closed.
+ */
+inline void stop_trace() {
+  internal::get_trace_recorder().recording_.store(false,
+                                                  std::memory_order_release);
+}
+
+/**
+ * Record an event on the timeline of the current thread if a trace is
+ * being recorded.
+ *
+ * @param phase 'B' for the beginning and 'E' for the end of a region
+ * @param name name of the region
+ * @param category category of the region
+ * @param args arguments of the event as the members of a JSON object
+ * @return identifier of the trace the event was recorded in, to record
+ * the end of the region with `trace_event_record_in()`, or zero if the
+ * event was not recorded
+ */
+inline std::uint64_t trace_event_record(char phase, std::string name,
+                                        const char* category,
+                                        std::string args = std::string()) {
+  if (!is_tracing()) {
+    return 0;
+  }
+  const std::uint64_t trace = internal::get_trace_recorder().trace_.load(
+      std::memory_order_acquire);
+  return internal::trace_event_append(trace, phase, std::move(name),
+                                      category, std::move(args))
+             ? trace
+             : 0;
+}
+
+/**
+ * Record an event on the timeline of the current thread if the
+ * specified trace is still the current one, even if it was stopped.
+ * This records the end of a region whose beginning was recorded by
+ * `trace_event_record()`, so that the regions stay balanced when the
+ * trace is stopped or restarted in between.
+ *
+ * @param trace identifier of the trace returned by `trace_event_record()`
+ * @param phase 'B' for the beginning and 'E' for the end of a region
+ * @param name name of the region
+ * @param category category of the region
+ * @param args arguments of the event as the members of a JSON object
+ * @return true if the event was recorded
+ */
+inline bool trace_event_record_in(std::uint64_t trace, char phase,
+                                  std::string name, const char* category,
+                                  std::string args = std::string()) {
+  return internal::trace_event_append(trace, phase, std::move(name),
+                                      category, std::move(args));
+}
+
+namespace internal {
+/**
+ * Return a copy of the events recorded by every thread, each in the
+ * order in which they were recorded, with the number of the thread.
+ */
+inline std::vector<std::pair<int, std::vector<trace_event>>>
+copy_trace_buffers() {
+  auto& recorder = internal::get_trace_recorder();
+  std::lock_guard<std::mutex> lock(recorder.mutex_);
+  std::vector<std::pair<int, std::vector<trace_event>>> events;
+  events.reserve(recorder.buffers_.size());
+  for (const auto& buffer : recorder.buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex_);
+    events.emplace_back(buffer->thread_, buffer->events_);
+  }
+  return events;
+}
+}  // namespace internal
+
+/**
+ * Write the recorded timeline in the Chrome Trace Event format, which
+ * can be loaded by `chrome://tracing` and by Perfetto. Every thread which
+ * recorded events is shown as its own track. Regions may be recorded
+ * while the trace is written; the events recorded so far are written.
+ *
+ * @param[in, out] os stream to write to
+ */
+inline void write_trace(std::ostream& os) {
+  const auto buffers = internal::copy_trace_buffers();
+  os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first = true;
+  for (const auto& buffer : buffers) {
+    for (const auto& event : buffer.second) {
+      os << (first ? "\n" : ",\n") << "{\"name\": ";
+      internal::write_json_string(os, event.name_);
+      os << ", \"cat\": \"" << event.category_ << "\", \"ph\": \""
+         << event.phase_ << "\", \"ts\": " << event.timestamp_
+         << ", \"pid\": 1, \"tid\": " << buffer.first;
+      if (!event.args_.empty()) {
+        os << ", \"args\": {" << event.args_ << "}";
+      }
+      os << "}";
+      first = false;
+    }
+  }
+  os << "\n]}\n";
+}
+
+/**
+ * Write the recorded timeline in the Chrome Trace Event format to the
+ * specified file.
+ *
+ * @param file_name name of the file to write
+ * @throw std::invalid_argument if the file cannot be opened
+ */
+inline void write_trace(const std::string& file_name) {
+  std::ofstream file(file_name);
+  if (!file) {
+    invalid_argument("write_trace", "file_name", file_name,
+                     "Cannot open trace file '", "'");
+  }
+  write_trace(file);
+}
+
+/**
+ * Return the events recorded by all threads, ordered by time. Regions
+ * may be recorded while the events are collected; the events recorded
+ * so far are returned.
+ */
+inline std::vector<trace_event> trace_events() {
+  std::vector<trace_event> events;
+  for (auto& buffer : internal::copy_trace_buffers()) {
+    events.insert(events.end(), std::make_move_iterator(buffer.second.begin()),
+                  std::make_move_iterator(buffer.second.end()));
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const trace_event& a, const trace_event& b) {
+                     return a.timestamp_ < b.timestamp_;
+                   });
+  return events;
+}
+
+/**
+ * Region of the timeline which lasts while the object is in scope. The
+ * region is recorded only if a trace is being recorded when the object
+ * is constructed, so the cost is a single relaxed load otherwise. The
+ * end of a recorded region is recorded as long as the trace is not
+ * restarted, even if it is stopped.
+ */
+class trace_region {
+  std::string name_;
+  const char* category_;
+  std::uint64_t trace_{0};
+
+ public:
+  /**
+   * Begin the region.
+   *
+   * @param name name of the region
+   * @param category category of the region
+   * @param args arguments of the begin event as the members of a JSON
+   * object
+   */
+  trace_region(const char* name, const char* category,
+               std::string args = std::string())
+      : category_(category) {
+    if (is_tracing()) {
+      name_ = name;
+      trace_ = trace_event_record('B', name_, category_, std::move(args));
+    }
+  }
+
+  trace_region(const trace_region&) = delete;
+  trace_region& operator=(const trace_region&) = delete;
+
+  /**
+   * End the region.
+   */
+  ~trace_region() {
+    if (trace_ != 0) {
+      trace_event_record_in(trace_, 'E', std::move(name_), category_);
+    }
+  }
+};
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -0,0 +1,102 @@
+#ifndef STAN_MATH_PRIM_FUN_PIN_DATA_HPP
+#define STAN_MATH_PRIM_FUN_PIN_DATA_HPP
+
+#include <stan/math/prim/meta.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace stan {
+namespace math {
+
+/**
+ * Read-only view of an immutable matrix which can be shared by any
+ * number of threads. The matrix is owned through a shared pointer, so
+ * copies of a `pinned_data` share the same memory.
+ *
+ * When a `pinned_data` is stored on the AD tape by `to_arena()` or as
+ * an `arena_t`, the result is a read-only `arena_matrix<const
+ * MatrixType>` referring to the pinned memory instead of holding a
+ * copy. All threads running gradients of the same model therefore
+ * read the same data and no lock is taken. Assigning a `pinned_data`
+ * to a writable `arena_matrix` copies it. The `pinned_data` (or a copy
+ * of it) must outlive every tape using it.
+ *
+ * @tparam MatrixType type of the plain Eigen matrix held
+ */
+template <typename MatrixType>
+class pinned_data : public Eigen::Map<const MatrixType> {
+  std::shared_ptr<const MatrixType> storage_;
+
+ public:
+  using Base = Eigen::Map<const MatrixType>;
+  using PlainObject = MatrixType;
+
+  /**
+   * Construct a view of the matrix held by the shared pointer.
+   *
+   * @param storage matrix to view
+   */
+  explicit pinned_data(std::shared_ptr<const MatrixType> storage)
+      : Base(storage->data(), storage->rows(), storage->cols()),
+        storage_(std::move(storage)) {}
+
+  pinned_data(const pinned_data<MatrixType>& other)
+      : Base(other.data(), other.rows(), other.cols()),
+        storage_(other.storage_) {}
+
+  pinned_data& operator=(const pinned_data<MatrixType>&) = delete;
+
+  /**
+   * Return the shared pointer owning the matrix.
+   */
+  inline const std::shared_ptr<const MatrixType>& storage() const noexcept {
+    return storage_;
+  }
+};
+
+/**
+ * Return a `pinned_data` holding a copy of the specified matrix or
+ * expression. The matrix is copied once here and never again when it
+ * is used on the AD tape of any thread.
+ *
+ * @tparam T type of the matrix or expression
+ * @param x matrix to pin
+ * @return read-only view of the pinned copy
+ */
+template <typename T, require_eigen_dense_base_t<T>* = nullptr>
+inline pinned_data<plain_type_t<T>> pin_data(const T& x) {
+  return pinned_data<plain_type_t<T>>(
+      std::make_shared<const plain_type_t<T>>(x));
+}
+
+/**
+ * Return a `pinned_data` taking over the memory of the specified
+ * matrix, without copying it.
+ *
+ * @tparam T type of the matrix
+ * @param x matrix to pin
+ * @return read-only view of the pinned matrix
+ */
+template <typename T, require_eigen_dense_base_t<T>* = nullptr,
+          require_plain_type_t<T>* = nullptr,
+          require_t<std::is_rvalue_reference<T&&>>* = nullptr>
+inline pinned_data<std::decay_t<T>> pin_data(T&& x) {
+  return pinned_data<std::decay_t<T>>(
+      std::make_shared<const std::decay_t<T>>(std::move(x)));
+}
+
+}  // namespace math
+}  // namespace stan
+
+namespace Eigen {
+namespace internal {
+
+template <typename T>
+struct traits<stan::math::pinned_data<T>> : traits<Eigen::Map<const T>> {};
+
+}  // namespace internal
+}  // namespace Eigen
+
+#endif
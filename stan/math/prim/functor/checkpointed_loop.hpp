@@ -0,0 +1,66 @@
+#ifndef STAN_MATH_PRIM_FUNCTOR_CHECKPOINTED_LOOP_HPP
+#define STAN_MATH_PRIM_FUNCTOR_CHECKPOINTED_LOOP_HPP
+
+#include <stan/math/prim/meta.hpp>
+#include <stan/math/prim/err.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <ostream>
+#include <utility>
+
+namespace stan {
+namespace math {
+
+/**
+ * Return the state reached after applying the step function `f` to the
+ * initial state `num_steps` times, that is `x_{t + 1} = f(x_t, t, msgs,
+ * args...)` for `t = 0, ..., num_steps - 1`.
+ *
+ * The step function must be callable as
+ *
+ * <code>
+ * Eigen::Matrix<T, Eigen::Dynamic, 1> operator()(
+ *     const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, int t,
+ *     std::ostream* msgs, const Args&... args) const
+ * </code>
+ *
+ * for any scalar type `T`, and must return a state of the same size.
+ *
+ * This overload is used when no argument holds reverse mode variables
+ * and simply runs the loop. With reverse mode variables only O(log
+ * num_steps) states are kept for the reverse pass instead of the tape of
+ * every step.
+ *
+ * @tparam F Type of step function
+ * @tparam T_state Type of initial state
+ * @tparam Args Types of shared arguments
+ * @param f step function
+ * @param x0 initial state
+ * @param num_steps number of steps
+ * @param[in, out] msgs the print stream for warning messages
+ * @param args shared arguments passed to every step
+ * @return state after `num_steps` steps
+ * @throw std::domain_error if the number of steps is negative
+ * @throw std::invalid_argument if a step changes the size of the state
+ */
+template <typename F, typename T_state, typename... Args,
+          require_eigen_col_vector_t<T_state>* = nullptr,
+          require_all_not_st_var<T_state, Args...>* = nullptr>
+inline Eigen::Matrix<return_type_t<T_state, Args...>, Eigen::Dynamic, 1>
+checkpointed_loop(const F& f, const T_state& x0, int num_steps,
+                  std::ostream* msgs, const Args&... args) {
+  static constexpr const char* function = "checkpointed_loop";
+  check_nonnegative(function, "number of steps", num_steps);
+  Eigen::Matrix<return_type_t<T_state, Args...>, Eigen::Dynamic, 1> x = x0;
+  for (int t = 0; t < num_steps; ++t) {
+    Eigen::Matrix<return_type_t<T_state, Args...>, Eigen::Dynamic, 1> x_next
+        = f(x, t, msgs, args...);
+    check_size_match(function, "size of the next state", x_next.size(),
+                     "size of the state", x.size());
+    x = std::move(x_next);
+  }
+  return x;
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -0,0 +1,163 @@
+#ifndef STAN_MATH_PRIM_FUNCTOR_COST_PARTITION_HPP
+#define STAN_MATH_PRIM_FUNCTOR_COST_PARTITION_HPP
+
+#include <tbb/blocked_range.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace stan {
+namespace math {
+namespace internal {
+
+/**
+ * Return the bounds of the chunks splitting terms of the specified costs
+ * into at most `num_chunks` consecutive chunks of about equal total
+ * cost. Chunk `c` holds the terms from `bounds[c]` to `bounds[c + 1]`
+ * (exclusive). Every chunk ends at the term boundary closest to its
+ * share of the total cost, so an expensive term tends to get a chunk of
+ * its own, and no chunk is empty. If all costs are zero, the terms are
+ * split by count.
+ *
+ * @param costs non-negative cost of every term
+ * @param num_chunks largest number of chunks, at least one
+ * @return bounds of the chunks, starting at zero and ending at the
+ * number of terms
+ */
+inline std::vector<size_t> partition_by_cost(const std::vector<double>& costs,
+                                             size_t num_chunks) {
+  const size_t num_terms = costs.size();
+  num_chunks = std::max<size_t>(std::min(num_chunks, num_terms), 1);
+  std::vector<double> cumulative(num_terms);
+  std::partial_sum(costs.begin(), costs.end(), cumulative.begin());
+  const double total = num_terms == 0 ? 0.0 : cumulative.back();
+  std::vector<size_t> bounds{0};
+  for (size_t c = 1; c < num_chunks; ++c) {
+    size_t bound;
+    if (total > 0) {
+      // end the chunk before or after the term whose cumulative cost
+      // reaches the target, whichever is closer to the target
+      const double target = total * c / num_chunks;
+      const size_t i = std::lower_bound(cumulative.begin(), cumulative.end(),
+                                        target)
+                       - cumulative.begin();
+      const double before = i == 0 ? 0.0 : cumulative[i - 1];
+      bound = i < num_terms && cumulative[i] - target > target - before
+                  ? i
+                  : i + 1;
+    } else {
+      bound = num_terms * c / num_chunks;
+    }
+    if (bound > bounds.back() && bound < num_terms) {
+      bounds.push_back(bound);
+    }
+  }
+  if (num_terms > 0) {
+    bounds.push_back(num_terms);
+  }
+  return bounds;
+}
+
+/**
+ * TBB range over the chunks of a partition by cost. The range is only
+ * split between chunks, so every call of the body of a reduction with
+ * a simple partitioner sees exactly one chunk, and the chunks and the
+ * order of the reduction depend only on the partition.
+ */
+class cost_range {
+  const std::vector<size_t>* bounds_;
+  size_t first_;
+  size_t last_;
+  double* chunk_seconds_;
+
+ public:
+  /**
+   * Construct the range over all chunks of a partition.
+   *
+   * @param bounds bounds of the chunks, as returned by
+   * `partition_by_cost()`
+   * @param chunk_seconds array receiving the time taken by every chunk,
+   * or `nullptr` if the chunks are not timed
+   */
+  cost_range(const std::vector<size_t>& bounds, double* chunk_seconds)
+      : bounds_(&bounds),
+        first_(0),
+        last_(bounds.size() - 1),
+        chunk_seconds_(chunk_seconds) {}
+
+  /**
+   * Split the chunks of the range in halves, taking the upper half.
+   */
+  cost_range(cost_range& r, tbb::split)
+      : bounds_(r.bounds_),
+        first_(r.first_ + (r.last_ - r.first_) / 2),
+        last_(r.last_),
+        chunk_seconds_(r.chunk_seconds_) {
+    r.last_ = first_;
+  }
+
+  inline bool empty() const noexcept { return first_ == last_; }
+  inline bool is_divisible() const noexcept { return last_ - first_ > 1; }
+
+  /**
+   * Return the first term of the range.
+   */
+  inline size_t begin() const noexcept { return (*bounds_)[first_]; }
+
+  /**
+   * Return one past the last term of the range.
+   */
+  inline size_t end() const noexcept { return (*bounds_)[last_]; }
+
+  inline size_t size() const noexcept { return end() - begin(); }
+
+  /**
+   * Record the time taken by the terms of the range, shared among its
+   * chunks by their number of terms.
+   *
+   * @param seconds wall time
+   */
+  inline void record(double seconds) const noexcept {
+    if (chunk_seconds_ == nullptr || empty()) {
+      return;
+    }
+    for (size_t c = first_; c < last_; ++c) {
+      chunk_seconds_[c] = seconds * ((*bounds_)[c + 1] - (*bounds_)[c])
+                          / static_cast<double>(size());
+    }
+  }
+};
+
+/**
+ * Times the body of a reduction over a range while in scope. Only
+ * ranges over the chunks of a partition by cost are timed.
+ *
+ * @tparam Range type of the range
+ */
+template <typename Range>
+struct chunk_timer {
+  explicit chunk_timer(const Range&) noexcept {}
+};
+
+template <>
+struct chunk_timer<cost_range> {
+  const cost_range& range_;
+  std::chrono::steady_clock::time_point start_;
+
+  explicit chunk_timer(const cost_range& range)
+      : range_(range), start_(std::chrono::steady_clock::now()) {}
+
+  ~chunk_timer() {
+    range_.record(std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start_)
+                      .count());
+  }
+};
+
+}  // namespace internal
+}  // namespace math
+}  // namespace stan
+
+#endif
@@ -3,13 +3,16 @@
 
 #include <stan/math/prim/meta.hpp>
 #include <stan/math/prim/err.hpp>
+#include <stan/math/prim/core/trace_events.hpp>
 #include <stan/math/prim/functor/apply.hpp>
+#include <stan/math/prim/functor/cost_partition.hpp>
 
 #include <tbb/task_arena.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/blocked_range.h>
 
 #include <algorithm>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -22,6 +25,21 @@ template <typename ReduceFunction, typename Enable, typename ReturnType,
           typename Vec, typename... Args>
 struct reduce_sum_impl;
 
+/**
+ * Return the arguments of the trace event of a chunk of `reduce_sum`,
+ * or an empty string if no trace is being recorded.
+ *
+ * @param begin index of the first term of the chunk
+ * @param end index one past the last term of the chunk
+ */
+inline std::string reduce_sum_trace_args(size_t begin, size_t end) {
+  if (!is_tracing()) {
+    return std::string();
+  }
+  return "\"begin\": " + std::to_string(begin)
+         + ", \"end\": " + std::to_string(end);
+}
+
 /**
  * Specialization of reduce_sum_impl for arithmetic types
  *
@@ -68,13 +86,19 @@ struct reduce_sum_impl<ReduceFunction, require_arithmetic_t<ReturnType>,
      *   be called multiple times per object instantiation (so the sum_
      *   must be accumulated, not just assigned).
      *
+     * @tparam Range `tbb::blocked_range<size_t>` or `cost_range`
      * @param r Range over which to compute `ReduceFunction`
      */
-    inline void operator()(const tbb::blocked_range<size_t>& r) {
+    template <typename Range>
+    inline void operator()(const Range& r) {
       if (r.empty()) {
         return;
       }
 
+      const trace_region region("reduce_sum chunk", "reduce_sum",
+                                reduce_sum_trace_args(r.begin(), r.end()));
+      const chunk_timer<Range> timer(r);
+
       std::decay_t<Vec> sub_slice;
       sub_slice.reserve(r.size());
       for (size_t i = r.begin(); i < r.end(); ++i) {
@@ -167,6 +191,40 @@ struct reduce_sum_impl<ReduceFunction, require_arithmetic_t<ReturnType>,
 
     return worker.sum_;
   }
+
+  /**
+   * Call an instance of the function `ReduceFunction` on every chunk of
+   *   the specified partition of an input sequence and sum these terms.
+   *   The chunks and the order in which the partial sums are
+   *   accumulated depend only on the partition.
+   *
+   * @param vmapped Vector containing one element per term of sum
+   * @param bounds Bounds of the chunks, as returned by
+   *   `partition_by_cost()`
+   * @param chunk_seconds Array receiving the time taken by every chunk,
+   *   or `nullptr`
+   * @param[in, out] msgs The print stream for warning messages
+   * @param args Shared arguments used in every sum term
+   * @return Summation of all terms
+   */
+  inline ReturnType operator()(Vec&& vmapped,
+                               const std::vector<size_t>& bounds,
+                               double* chunk_seconds, std::ostream* msgs,
+                               Args&&... args) const {
+    if (vmapped.empty()) {
+      return 0.0;
+    }
+    recursive_reducer worker(std::forward<Vec>(vmapped), msgs,
+                             std::forward<Args>(args)...);
+    tbb::simple_partitioner partitioner;
+    tbb::parallel_deterministic_reduce(cost_range(bounds, chunk_seconds),
+                                       worker, partitioner);
+    if (msgs) {
+      *msgs << worker.msgs_.str();
+    }
+
+    return worker.sum_;
+  }
 };
 
 }  // namespace internal
@@ -213,6 +271,9 @@ inline auto reduce_sum(Vec&& vmapped, int grainsize, std::ostream* msgs,
     return return_type(0.0);
   }
 
+  const trace_region region(
+      "reduce_sum chunk", "reduce_sum",
+      internal::reduce_sum_trace_args(0, vmapped.size()));
   return ReduceFunction()(std::forward<Vec>(vmapped), 0, vmapped.size() - 1,
                           msgs, std::forward<Args>(args)...);
 #endif
@@ -0,0 +1,318 @@
+#ifndef STAN_MATH_PRIM_FUNCTOR_REDUCE_SUM_AUTO_HPP
+#define STAN_MATH_PRIM_FUNCTOR_REDUCE_SUM_AUTO_HPP
+
+#include <stan/math/prim/meta.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/math/prim/functor/reduce_sum.hpp>
+#include <tbb/task_arena.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Tunes the number of chunks a parallel reduction over a fixed number of
+ * terms is split into, by timing the first calls.
+ *
+ * The number of chunks is tuned over powers of two, since the simple
+ * partitioner of the TBB splits ranges in halves. The first calls try
+ * one, four and sixteen chunks per thread, each a few times, and the
+ * fastest time of every candidate is fitted to the cost model
+ *
+ * <code>T(k) = W * ceil(k / P) / k + o * k / P + t0</code>
+ *
+ * where `k` is the number of chunks, `P` the number of threads, `W` the
+ * serial work of all terms, `o` the overhead of a chunk and `t0` the
+ * fixed overhead of a call. The number of chunks minimizing the model
+ * is timed as well, and the fastest of all timed candidates is used from
+ * then on. The tuning is restarted if the number of terms or threads
+ * changes.
+ *
+ * All member functions are thread safe, so the same tuner can be used
+ * by concurrent calls from several chains.
+ */
+class grainsize_tuner {
+  std::mutex mutex_;
+  size_t repetitions_;
+  size_t num_terms_{0};
+  size_t num_threads_{0};
+  std::vector<size_t> candidates_;
+  // number of chunks -> fastest time and number of timings
+  std::map<size_t, std::pair<double, size_t>> timings_;
+  bool predicted_{false};
+  bool converged_{false};
+  size_t best_num_chunks_{1};
+
+  static inline size_t round_down_pow2(size_t x) {
+    size_t p = 1;
+    while (p * 2 <= x) {
+      p *= 2;
+    }
+    return p;
+  }
+
+  static inline size_t round_up_pow2(size_t x) {
+    size_t p = 1;
+    while (p < x) {
+      p *= 2;
+    }
+    return p;
+  }
+
+  inline void restart(size_t num_terms, size_t num_threads) {
+    num_terms_ = num_terms;
+    num_threads_ = num_threads;
+    timings_.clear();
+    candidates_.clear();
+    predicted_ = false;
+    converged_ = false;
+    const size_t max_chunks = round_down_pow2(num_terms);
+    for (size_t per_thread : {1, 4, 16}) {
+      const size_t k
+          = std::min(round_up_pow2(per_thread * num_threads), max_chunks);
+      if (std::find(candidates_.begin(), candidates_.end(), k)
+          == candidates_.end()) {
+        candidates_.push_back(k);
+      }
+    }
+    best_num_chunks_ = candidates_.front();
+  }
+
+  /**
+   * Return the number of chunks minimizing the cost model fitted to the
+   * timings, or zero if the model cannot be fitted.
+   */
+  inline size_t predict() const {
+    if (timings_.size() < 3) {
+      return 0;
+    }
+    const double P = num_threads_;
+    auto features = [P](double k) {
+      return Eigen::Vector3d(std::ceil(k / P) / k, k / P, 1.0);
+    };
+    Eigen::MatrixXd X(timings_.size(), 3);
+    Eigen::VectorXd T(timings_.size());
+    Eigen::Index i = 0;
+    for (const auto& timing : timings_) {
+      X.row(i) = features(timing.first).transpose();
+      T.coeffRef(i) = timing.second.first;
+      ++i;
+    }
+    Eigen::Vector3d theta = X.colPivHouseholderQr().solve(T);
+    if (!theta.allFinite()) {
+      return 0;
+    }
+    // work and overheads are not negative
+    theta = theta.cwiseMax(0.0);
+    size_t best = 0;
+    double best_time = 0.0;
+    for (size_t k = 1; k <= round_down_pow2(num_terms_); k *= 2) {
+      const double t = features(k).dot(theta);
+      if (best == 0 || t < best_time) {
+        best = k;
+        best_time = t;
+      }
+    }
+    return best;
+  }
+
+ public:
+  /**
+   * Construct a tuner.
+   *
+   * @param repetitions number of timings of every candidate, of which
+   * the fastest is used; zero is treated as one
+   */
+  explicit grainsize_tuner(size_t repetitions = 2)
+      : repetitions_(repetitions == 0 ? 1 : repetitions) {}
+
+  grainsize_tuner(const grainsize_tuner&) = delete;
+  grainsize_tuner& operator=(const grainsize_tuner&) = delete;
+
+  /**
+   * Return the number of chunks the next call should use.
+   *
+   * @param num_terms number of terms of the reduction
+   * @param num_threads number of threads available
+   * @return number of chunks, a power of two between 1 and `num_terms`
+   */
+  inline size_t next_num_chunks(size_t num_terms, size_t num_threads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_terms = std::max<size_t>(num_terms, 1);
+    num_threads = std::max<size_t>(num_threads, 1);
+    if (num_terms != num_terms_ || num_threads != num_threads_) {
+      restart(num_terms, num_threads);
+    }
+    while (!converged_) {
+      for (size_t k : candidates_) {
+        auto it = timings_.find(k);
+        if (it == timings_.end() || it->second.second < repetitions_) {
+          return k;
+        }
+      }
+      if (!predicted_) {
+        predicted_ = true;
+        const size_t k = predict();
+        if (k != 0
+            && std::find(candidates_.begin(), candidates_.end(), k)
+                   == candidates_.end()) {
+          candidates_.push_back(k);
+        }
+        continue;
+      }
+      auto fastest = std::min_element(
+          timings_.begin(), timings_.end(), [](const auto& a, const auto& b) {
+            return a.second.first < b.second.first;
+          });
+      best_num_chunks_ = fastest->first;
+      converged_ = true;
+    }
+    return best_num_chunks_;
+  }
+
+  /**
+   * Record the time taken by a call.
+   *
+   * @param num_chunks number of chunks the call used
+   * @param num_terms number of terms of the reduction
+   * @param num_threads number of threads available
+   * @param seconds wall time of the call
+   */
+  inline void record(size_t num_chunks, size_t num_terms, size_t num_threads,
+                     double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_terms = std::max<size_t>(num_terms, 1);
+    num_threads = std::max<size_t>(num_threads, 1);
+    if (converged_ || num_terms != num_terms_ || num_threads != num_threads_) {
+      return;
+    }
+    auto it = timings_.find(num_chunks);
+    if (it == timings_.end()) {
+      timings_.emplace(num_chunks, std::make_pair(seconds, size_t{1}));
+    } else {
+      it->second.first = std::min(it->second.first, seconds);
+      ++it->second.second;
+    }
+  }
+
+  /**
+   * Return true if the tuning is done.
+   */
+  inline bool converged() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return converged_;
+  }
+
+  /**
+   * Return the number of chunks used once the tuning is done.
+   */
+  inline size_t num_chunks() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return best_num_chunks_;
+  }
+
+  /**
+   * Return the grainsize splitting the terms into the specified number
+   * of chunks.
+   *
+   * @param num_terms number of terms of the reduction
+   * @param num_chunks number of chunks
+   */
+  static inline int grainsize(size_t num_terms, size_t num_chunks) {
+    return std::max<size_t>((num_terms + num_chunks - 1) / num_chunks, 1);
+  }
+};
+
+namespace internal {
+
+/**
+ * Return the grainsize tuner of the calls of `reduce_sum_auto` with the
+ * specified reducer, number of terms and number of threads. Call sites
+ * sharing a reducer but reducing different numbers of terms are tuned
+ * separately, so alternating between them does not restart the tuning.
+ * The tuning persists for the rest of the run.
+ *
+ * @tparam ReduceFunction Type of reducer function
+ * @param num_terms number of terms of the reduction
+ * @param num_threads number of threads available
+ */
+template <typename ReduceFunction>
+inline grainsize_tuner& reduce_sum_auto_tuner(size_t num_terms,
+                                              size_t num_threads) {
+  static std::mutex mutex;
+  static std::map<std::pair<size_t, size_t>, grainsize_tuner> tuners;
+  std::lock_guard<std::mutex> lock(mutex);
+  return tuners[std::make_pair(num_terms, num_threads)];
+}
+
+}  // namespace internal
+
+/**
+ * Call an instance of the function `ReduceFunction` on every element
+ * of an input sequence and sum these terms, like `reduce_sum`, with a
+ * grainsize tuned automatically.
+ *
+ * The first calls with the same `ReduceFunction`, number of terms and
+ * number of threads are timed with different grainsizes by a
+ * `grainsize_tuner`, which converges on the grainsize minimizing the
+ * wall time of the call and keeps it for the rest of the run. The terms
+ * are split deterministically, as by `reduce_sum_static`, so that the
+ * timings are comparable. Call sites with the same `ReduceFunction` and
+ * number of terms share the tuning; call sites with different numbers
+ * of terms are tuned independently.
+ *
+ * If STAN_THREADS is not defined, do all the work with one
+ * ReduceFunction call.
+ *
+ * @tparam ReduceFunction Type of reducer function
+ * @tparam Vec Type of sliced argument
+ * @tparam Args Types of shared arguments
+ * @param vmapped Sliced arguments used only in some sum terms
+ * @param[in, out] msgs The print stream for warning messages
+ * @param args Shared arguments used in every sum term
+ * @return Sum of terms
+ */
+template <typename ReduceFunction, typename Vec,
+          typename = require_vector_like_t<Vec>, typename... Args>
+inline auto reduce_sum_auto(Vec&& vmapped, std::ostream* msgs,
+                            Args&&... args) {
+  using return_type = return_type_t<Vec, Args...>;
+
+#ifdef STAN_THREADS
+  if (vmapped.empty()) {
+    return return_type(0.0);
+  }
+  const size_t num_terms = vmapped.size();
+  const size_t num_threads = tbb::this_task_arena::max_concurrency();
+  grainsize_tuner& tuner
+      = internal::reduce_sum_auto_tuner<ReduceFunction>(num_terms, num_threads);
+  const size_t num_chunks = tuner.next_num_chunks(num_terms, num_threads);
+  const auto start = std::chrono::steady_clock::now();
+  return_type sum = internal::reduce_sum_impl<ReduceFunction, void,
+                                              return_type, Vec,
+                                              ref_type_t<Args&&>...>()(
+      std::forward<Vec>(vmapped), false,
+      grainsize_tuner::grainsize(num_terms, num_chunks), msgs,
+      std::forward<Args>(args)...);
+  tuner.record(num_chunks, num_terms, num_threads,
+               std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                             - start)
+                   .count());
+  return sum;
+#else
+  return reduce_sum<ReduceFunction>(std::forward<Vec>(vmapped), 1, msgs,
+                                    std::forward<Args>(args)...);
+#endif
+}
+
+}  // namespace math
+}  // namespace stan
+
+#endif
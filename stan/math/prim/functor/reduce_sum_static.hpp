@@ -58,6 +58,9 @@ auto reduce_sum_static(Vec&& vmapped, int grainsize, std::ostream* msgs,
     return return_type(0);
   }
 
+  const trace_region region(
+      "reduce_sum chunk", "reduce_sum",
+      internal::reduce_sum_trace_args(0, vmapped.size()));
   return ReduceFunction()(std::forward<Vec>(vmapped), 0, vmapped.size() - 1,
                           msgs, std::forward<Args>(args)...);
 #endif
@@ -0,0 +1,254 @@
+#ifndef STAN_MATH_PRIM_FUNCTOR_REDUCE_SUM_WEIGHTED_HPP
+#define STAN_MATH_PRIM_FUNCTOR_REDUCE_SUM_WEIGHTED_HPP
+
+#include <stan/math/prim/meta.hpp>
+#include <stan/math/prim/err.hpp>
+#include <stan/math/prim/functor/cost_partition.hpp>
+#include <stan/math/prim/functor/reduce_sum.hpp>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Learns the cost of every term of a reduction from the time taken by
+ * the chunks of its first calls.
+ *
+ * The time of a chunk is shared evenly among its terms, and the cost of
+ * a term is the mean over the learning calls. Since every call is
+ * partitioned by the costs learned so far, the chunk bounds move and
+ * the costs are resolved more finely with every call. After the
+ * learning calls the costs, and with them the partition and the order
+ * of the reduction, are frozen. The learning is restarted if the number
+ * of terms changes.
+ *
+ * All member functions are thread safe.
+ */
+class term_cost_learner {
+  std::mutex mutex_;
+  size_t learning_calls_;
+  size_t num_calls_{0};
+  std::vector<double> costs_;
+
+ public:
+  /**
+   * Construct a learner.
+   *
+   * @param learning_calls number of calls timed before the costs are
+   * frozen
+   */
+  explicit term_cost_learner(size_t learning_calls = 4)
+      : learning_calls_(learning_calls) {}
+
+  term_cost_learner(const term_cost_learner&) = delete;
+  term_cost_learner& operator=(const term_cost_learner&) = delete;
+
+  /**
+   * Return the partition of the terms by the costs learned so far.
+   *
+   * @param num_terms number of terms of the reduction
+   * @param num_chunks largest number of chunks
+   * @param[out] learning set to true if the call should be timed
+   * @return bounds of the chunks
+   */
+  inline std::vector<size_t> partition(size_t num_terms, size_t num_chunks,
+                                       bool& learning) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (costs_.size() != num_terms) {
+      costs_.assign(num_terms, 1.0);
+      num_calls_ = 0;
+    }
+    learning = num_calls_ < learning_calls_;
+    return internal::partition_by_cost(costs_, num_chunks);
+  }
+
+  /**
+   * Record the time taken by the chunks of a call.
+   *
+   * @param bounds bounds of the chunks of the call
+   * @param chunk_seconds time taken by every chunk
+   */
+  inline void record(const std::vector<size_t>& bounds,
+                     const std::vector<double>& chunk_seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bounds.empty() || costs_.size() != bounds.back()
+        || num_calls_ >= learning_calls_) {
+      return;
+    }
+    const double n = num_calls_;
+    for (size_t c = 0; c + 1 < bounds.size(); ++c) {
+      const double cost = chunk_seconds[c] / (bounds[c + 1] - bounds[c]);
+      for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+        costs_[i] = n == 0 ? cost : (costs_[i] * n + cost) / (n + 1);
+      }
+    }
+    ++num_calls_;
+  }
+
+  /**
+   * Return true if the costs are frozen.
+   */
+  inline bool frozen() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !costs_.empty() && num_calls_ >= learning_calls_;
+  }
+
+  /**
+   * Return the learned cost of every term, in seconds.
+   */
+  inline std::vector<double> costs() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return costs_;
+  }
+};
+
+namespace internal {
+
+/**
+ * Return the learner of the term costs of the calls of
+ * `reduce_sum_weighted` with the specified reducer and number of terms
+ * and without cost weights. Call sites sharing a reducer but reducing
+ * different numbers of terms learn separately, so alternating between
+ * them does not restart the learning. The costs persist for the rest of
+ * the run.
+ *
+ * @tparam ReduceFunction Type of reducer function
+ * @param num_terms number of terms of the reduction
+ */
+template <typename ReduceFunction>
+inline term_cost_learner& reduce_sum_cost_learner(size_t num_terms) {
+  static std::mutex mutex;
+  static std::map<size_t, term_cost_learner> learners;
+  std::lock_guard<std::mutex> lock(mutex);
+  return learners[num_terms];
+}
+
+}  // namespace internal
+
+/**
+ * Call an instance of the function `ReduceFunction` on every element
+ * of an input sequence and sum these terms, like `reduce_sum_static`,
+ * splitting the terms into chunks of about equal total cost rather
+ * than equal count.
+ *
+ * The terms are split into at most `num_chunks` consecutive chunks by
+ * the cumulative weights, so a few expensive terms do not leave most
+ * threads idle. The chunks and the order in which the partial sums are
+ * accumulated depend only on the weights and on `num_chunks`, not on
+ * the number of threads or on the scheduling, as for
+ * `reduce_sum_static`.
+ *
+ * If STAN_THREADS is not defined, do all the work with one
+ * ReduceFunction call.
+ *
+ * @tparam ReduceFunction Type of reducer function
+ * @tparam Vec Type of sliced argument
+ * @tparam Args Types of shared arguments
+ * @param vmapped Sliced arguments used only in some sum terms
+ * @param weights Non-negative cost of every term, in any unit
+ * @param num_chunks Largest number of chunks
+ * @param[in, out] msgs The print stream for warning messages
+ * @param args Shared arguments used in every sum term
+ * @return Sum of terms
+ * @throw std::invalid_argument if the number of weights does not match
+ * the number of terms
+ * @throw std::domain_error if a weight is negative or not finite, or if
+ * the number of chunks is not positive
+ */
+template <typename ReduceFunction, typename Vec,
+          typename = require_vector_like_t<Vec>, typename... Args>
+inline auto reduce_sum_weighted(Vec&& vmapped,
+                                const std::vector<double>& weights,
+                                int num_chunks, std::ostream* msgs,
+                                Args&&... args) {
+  using return_type = return_type_t<Vec, Args...>;
+  static constexpr const char* function = "reduce_sum_weighted";
+  check_size_match(function, "number of weights", weights.size(),
+                   "number of terms", vmapped.size());
+  check_nonnegative(function, "weights", weights);
+  check_finite(function, "weights", weights);
+  check_positive(function, "num_chunks", num_chunks);
+
+#ifdef STAN_THREADS
+  const std::vector<size_t> bounds
+      = internal::partition_by_cost(weights, num_chunks);
+  return internal::reduce_sum_impl<ReduceFunction, void, return_type, Vec,
+                                   ref_type_t<Args&&>...>()(
+      std::forward<Vec>(vmapped), bounds, nullptr, msgs,
+      std::forward<Args>(args)...);
+#else
+  if (vmapped.empty()) {
+    return return_type(0.0);
+  }
+
+  return ReduceFunction()(std::forward<Vec>(vmapped), 0, vmapped.size() - 1,
+                          msgs, std::forward<Args>(args)...);
+#endif
+}
+
+/**
+ * Call an instance of the function `ReduceFunction` on every element
+ * of an input sequence and sum these terms, splitting the terms into
+ * chunks of about equal total cost, where the cost of every term is
+ * learned from the time taken by the chunks of the first calls with the
+ * same `ReduceFunction` and number of terms by a `term_cost_learner`.
+ *
+ * Once the costs are frozen, the chunks and the order in which the
+ * partial sums are accumulated are the same for every call, as for
+ * `reduce_sum_static`.
+ *
+ * If STAN_THREADS is not defined, do all the work with one
+ * ReduceFunction call.
+ *
+ * @tparam ReduceFunction Type of reducer function
+ * @tparam Vec Type of sliced argument
+ * @tparam Args Types of shared arguments
+ * @param vmapped Sliced arguments used only in some sum terms
+ * @param num_chunks Largest number of chunks
+ * @param[in, out] msgs The print stream for warning messages
+ * @param args Shared arguments used in every sum term
+ * @return Sum of terms
+ * @throw std::domain_error if the number of chunks is not positive
+ */
+template <typename ReduceFunction, typename Vec,
+          typename = require_vector_like_t<Vec>, typename... Args>
+inline auto reduce_sum_weighted(Vec&& vmapped, int num_chunks,
+                                std::ostream* msgs, Args&&... args) {
+  using return_type = return_type_t<Vec, Args...>;
+  check_positive("reduce_sum_weighted", "num_chunks", num_chunks);
+
+#ifdef STAN_THREADS
+  term_cost_learner& learner
+      = internal::reduce_sum_cost_learner<ReduceFunction>(vmapped.size());
+  bool learning = false;
+  const std::vector<size_t> bounds
+      = learner.partition(vmapped.size(), num_chunks, learning);
+  std::vector<double> chunk_seconds(learning ? bounds.size() : 0);
+  return_type sum = internal::reduce_sum_impl<ReduceFunction, void,
+                                              return_type, Vec,
+                                              ref_type_t<Args&&>...>()(
+      std::forward<Vec>(vmapped), bounds,
+      learning ? chunk_seconds.data() : nullptr, msgs,
+      std::forward<Args>(args)...);
+  if (learning) {
+    learner.record(bounds, chunk_seconds);
+  }
+  return sum;
+#else
+  if (vmapped.empty()) {
+    return return_type(0.0);
+  }
+
+  return ReduceFunction()(std::forward<Vec>(vmapped), 0, vmapped.size() - 1,
+                          msgs, std::forward<Args>(args)...);
+#endif
+}
+
+}  // namespace math
+}  // namespace stan
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef STAN_MATH_PRIM_META_IS_PINNED_DATA_HPP
+#define STAN_MATH_PRIM_META_IS_PINNED_DATA_HPP
+
+#include <type_traits>
+
+namespace stan {
+namespace math {
+template <typename MatrixType>
+class pinned_data;
+}  // namespace math
+
+/** \ingroup type_trait
+ * Defines a static member named value which is defined to be true
+ * if the type is `pinned_data<T>`
+ */
+template <typename T>
+struct is_pinned_data : std::false_type {};
+
+template <typename T>
+struct is_pinned_data<math::pinned_data<T>> : std::true_type {};
+
+}  // namespace stan
+#endif
@@ -6,6 +6,8 @@
 #include <stan/math/prim/meta/is_var.hpp>
 #include <stan/math/prim/meta/is_eigen_dense_base.hpp>
 #include <stan/math/prim/meta/is_eigen_sparse_base.hpp>
+#include <stan/math/prim/meta/is_pinned_data.hpp>
+#include <stan/math/prim/meta/require_helpers.hpp>
 #include <vector>
 
 namespace stan {
@@ -82,7 +84,10 @@ struct promote_scalar_type<T, S,
  * @tparam S input matrix type
  */
 template <typename T, typename S>
-struct promote_scalar_type<T, S, require_eigen_dense_base_t<S>> {
+struct promote_scalar_type<
+    T, S,
+    require_t<bool_constant<is_eigen_dense_base<S>::value
+                            && !is_pinned_data<std::decay_t<S>>::value>>> {
   /**
    * The promoted type.
    */
@@ -95,6 +100,28 @@ struct promote_scalar_type<T, S, require_eigen_dense_base_t<S>> {
                    S::RowsAtCompileTime, S::ColsAtCompileTime>>::type;
 };
 
+/**
+ * Specialization for `pinned_data`. Promoting to the scalar type it
+ * holds keeps the `pinned_data`, so that data arguments stored on the AD
+ * tape as `arena_t<promote_scalar_t<double, T>>` refer to the pinned
+ * memory instead of holding a copy. Promoting to any other scalar type
+ * gives a plain matrix.
+ *
+ * @tparam T result scalar type.
+ * @tparam S `pinned_data` type
+ */
+template <typename T, typename S>
+struct promote_scalar_type<T, S, require_t<is_pinned_data<std::decay_t<S>>>> {
+  /**
+   * The promoted type.
+   */
+  using type = std::conditional_t<
+      std::is_same<T, typename std::decay_t<S>::Scalar>::value,
+      std::decay_t<S>,
+      typename promote_scalar_type<
+          T, typename std::decay_t<S>::PlainObject>::type>;
+};
+
 template <typename T, typename S>
 struct promote_scalar_type<T, S, require_eigen_sparse_base_t<S>> {
   /**
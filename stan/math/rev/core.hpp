@@ -2,13 +2,17 @@
 #define STAN_MATH_REV_CORE_HPP
 
 #include <stan/math/rev/core/accumulate_adjoints.hpp>
+#include <stan/math/rev/core/ad_task.hpp>
 #include <stan/math/rev/core/arena_allocator.hpp>
 #include <stan/math/rev/core/arena_matrix.hpp>
+#include <stan/math/rev/core/arena_tag.hpp>
 #include <stan/math/rev/core/autodiffstackstorage.hpp>
 #include <stan/math/rev/core/build_vari_array.hpp>
 #include <stan/math/rev/core/chainable_alloc.hpp>
 #include <stan/math/rev/core/chainable_object.hpp>
 #include <stan/math/rev/core/chainablestack.hpp>
+#include <stan/math/rev/core/compact_lane_tape.hpp>
+#include <stan/math/rev/core/compact_tape.hpp>
 #include <stan/math/rev/core/count_vars.hpp>
 #include <stan/math/rev/core/callback_vari.hpp>
 #include <stan/math/rev/core/init_chainablestack.hpp>
@@ -22,6 +26,7 @@
 #include <stan/math/rev/core/empty_nested.hpp>
 #include <stan/math/rev/core/gevv_vvv_vari.hpp>
 #include <stan/math/rev/core/grad.hpp>
+#include <stan/math/rev/core/grad_parallel.hpp>
 #include <stan/math/rev/core/nested_rev_autodiff.hpp>
 #include <stan/math/rev/core/matrix_vari.hpp>
 #include <stan/math/rev/core/nested_size.hpp>
@@ -46,17 +51,24 @@
 #include <stan/math/rev/core/operator_unary_negative.hpp>
 #include <stan/math/rev/core/operator_unary_not.hpp>
 #include <stan/math/rev/core/operator_unary_plus.hpp>
+#include <stan/math/rev/core/perf_counters.hpp>
+#include <stan/math/rev/core/pooled_chainablestack.hpp>
+#include <stan/math/rev/core/precomp_v_vari.hpp>
 #include <stan/math/rev/core/precomp_vv_vari.hpp>
 #include <stan/math/rev/core/precomp_vvv_vari.hpp>
 #include <stan/math/rev/core/precomputed_gradients.hpp>
 #include <stan/math/rev/core/print_stack.hpp>
 #include <stan/math/rev/core/profiling.hpp>
 #include <stan/math/rev/core/read_var.hpp>
+#include <stan/math/rev/core/recorded_tape.hpp>
 #include <stan/math/rev/core/recover_memory.hpp>
 #include <stan/math/rev/core/recover_memory_nested.hpp>
+#include <stan/math/rev/core/reserve_autodiff.hpp>
+#include <stan/math/rev/core/reverse_profile.hpp>
 #include <stan/math/rev/core/scoped_chainablestack.hpp>
 #include <stan/math/rev/core/set_zero_all_adjoints.hpp>
 #include <stan/math/rev/core/set_zero_all_adjoints_nested.hpp>
+#include <stan/math/rev/core/soa_tape.hpp>
 #include <stan/math/rev/core/start_nested.hpp>
 #include <stan/math/rev/core/std_complex.hpp>
 #include <stan/math/rev/core/std_isinf.hpp>
@@ -0,0 +1,99 @@
+#ifndef STAN_MATH_REV_CORE_AD_TASK_HPP
+#define STAN_MATH_REV_CORE_AD_TASK_HPP
+
+#include <stan/math/rev/core/pooled_chainablestack.hpp>
+#include <tbb/task_arena.h>
+#include <utility>
+
+namespace stan {
+namespace math {
+
+namespace internal {
+/**
+ * Number of AD tasks running on the current thread. Tasks nest when a
+ * thread waiting for a parallel region inside a task runs another task.
+ */
+inline int& ad_task_depth() {
+  static thread_local int depth = 0;
+  return depth;
+}
+}  // namespace internal
+
+/**
+ * Return true if the current thread is running an AD task, that is a
+ * piece of work of a parallel region such as a chunk of `reduce_sum` or
+ * a job of `map_rect`, on an AD tape of its own.
+ */
+inline bool in_ad_task() { return internal::ad_task_depth() > 0; }
+
+/**
+ * Run the specified function as an AD task on the specified AD tape,
+ * like `run_ad_task(F&&)` below, for tasks whose tape outlives them, for
+ * example to run the reverse pass over it later in another task.
+ *
+ * @tparam F Type of function
+ * @param task_stack AD tape of the task
+ * @param f Function to run
+ * @return Result of the function
+ */
+template <typename F>
+inline decltype(auto) run_ad_task(pooled_chainablestack& task_stack, F&& f) {
+  struct depth_scope {
+    depth_scope() { ++internal::ad_task_depth(); }
+    ~depth_scope() { --internal::ad_task_depth(); }
+  };
+  const depth_scope depth;
+  return task_stack.execute(std::forward<F>(f));
+}
+
+/**
+ * Run the specified function as an AD task: on an AD tape taken from
+ * the pool of `pooled_chainablestack` instead of the AD tape of the
+ * current thread. The tape is recovered and returned to the pool when
+ * the function returns, so vars created by the function must not
+ * outlive it; results are passed back as values and adjoints.
+ *
+ * A task never uses the tape of the thread it runs on, so a thread
+ * waiting for a parallel region inside a task may run any other task
+ * of the enclosing parallel regions in the meantime without touching
+ * the tape of the suspended task.
+ *
+ * @tparam F Type of function
+ * @param f Function to run
+ * @return Result of the function
+ */
+template <typename F>
+inline decltype(auto) run_ad_task(F&& f) {
+  pooled_chainablestack task_stack;
+  return run_ad_task(task_stack, std::forward<F>(f));
+}
+
+/**
+ * Run the specified function, which runs a parallel region of AD tasks
+ * started by `run_ad_task()`, such as a TBB reduction over the chunks of
+ * `reduce_sum`.
+ *
+ * The outermost region is run under task isolation, as described
+ * [here](https://software.intel.com/content/www/us/en/develop/documentation/tbb-documentation/top/intel-threading-building-blocks-developer-guide/task-isolation.html),
+ * so that a thread waiting for it only runs tasks of the region and of
+ * the regions nested in it, never foreign tasks using the thread local
+ * AD tape (like the gradient of another chain running Stan). Regions
+ * nested in an AD task are not isolated: a thread waiting for a nested
+ * region helps with the tasks of all enclosing regions, which share one
+ * work-stealing pool, and every task runs on its own tape.
+ *
+ * @tparam F Type of function
+ * @param f Function running the parallel region
+ */
+template <typename F>
+inline void run_ad_parallel(F&& f) {
+  if (in_ad_task()) {
+    f();
+  } else {
+    tbb::this_task_arena::isolate(f);
+  }
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
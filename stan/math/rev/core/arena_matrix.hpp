@@ -2,11 +2,14 @@
 #define STAN_MATH_REV_CORE_ARENA_MATRIX_HPP
 
 #include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/math/rev/core/arena_tag.hpp>
 #include <stan/math/rev/core/chainable_alloc.hpp>
 #include <stan/math/rev/core/chainablestack.hpp>
 #include <stan/math/rev/core/chainable_object.hpp>
 #include <stan/math/rev/core/var_value_fwd_declare.hpp>
+#include <stan/math/prim/fun/pin_data.hpp>
 #include <stan/math/prim/fun/to_ref.hpp>
+#include <type_traits>
 namespace stan {
 namespace math {
 
@@ -20,6 +23,41 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
   static constexpr int RowsAtCompileTime = MatrixType::RowsAtCompileTime;
   static constexpr int ColsAtCompileTime = MatrixType::ColsAtCompileTime;
 
+ private:
+  /**
+   * Allocate memory for the given number of coefficients on the arena.
+   * Arrays of at least 64 bytes are aligned on 64 bytes, so that
+   * vectorized loads and stores of their values and adjoints do not
+   * cross cache lines. The allocation is counted under the
+   * "arena_matrix" tag if arena tags are enabled.
+   * @param size number of coefficients
+   * @return pointer to the allocated memory
+   */
+  static inline Scalar* allocate(Eigen::Index size) {
+    constexpr size_t alignment = internal::SIMD_ALIGNMENT_NBYTES;
+    internal::count_arena_matrix_bytes(size * sizeof(Scalar));
+    if (size * sizeof(Scalar) >= alignment) {
+      return ChainableStack::instance_->memalloc_
+          .alloc_array_aligned<Scalar, alignment>(size);
+    }
+    return ChainableStack::instance_->memalloc_.alloc_array<Scalar>(size);
+  }
+
+  /**
+   * Return the memory of the pinned data for an `arena_matrix` of a
+   * const type, and newly allocated memory of the same size otherwise.
+   * @param other pinned matrix
+   * @return pointer to the memory to map
+   */
+  static inline auto map_or_allocate(const pinned_data<PlainObject>& other) {
+    if constexpr (std::is_const<MatrixType>::value) {
+      return other.data();
+    } else {
+      return allocate(other.size());
+    }
+  }
+
+ public:
   /**
    * Default constructor.
    */
@@ -35,9 +73,7 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
    * @param cols number of columns
    */
   arena_matrix(Eigen::Index rows, Eigen::Index cols)
-      : Base::Map(
-          ChainableStack::instance_->memalloc_.alloc_array<Scalar>(rows * cols),
-          rows, cols) {}
+      : Base::Map(allocate(rows * cols), rows, cols) {}
 
   /**
    * Constructs `arena_matrix` with given size. This only works if
@@ -45,9 +81,7 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
    * @param size number of elements
    */
   explicit arena_matrix(Eigen::Index size)
-      : Base::Map(
-          ChainableStack::instance_->memalloc_.alloc_array<Scalar>(size),
-          size) {}
+      : Base::Map(allocate(size), size) {}
 
  private:
   template <typename T>
@@ -72,10 +106,10 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
    */
   template <typename T, require_eigen_t<T>* = nullptr>
   arena_matrix(const T& other)  // NOLINT
-      : Base::Map(ChainableStack::instance_->memalloc_.alloc_array<Scalar>(
-                      other.size()),
-                  get_rows(other), get_cols(other)) {
-    *this = other;
+      : Base::Map(allocate(other.size()), get_rows(other), get_cols(other)) {
+    // assign through the map, the templated `operator=` would allocate
+    // the memory a second time
+    Base::operator=(other);
   }
   /**
    * Overwrite the current arena_matrix with new memory and assign a matrix to
@@ -85,9 +119,7 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
    */
   template <typename T, require_eigen_t<T>* = nullptr>
   arena_matrix& operator=(const T& other) {
-    new (this) Base(
-        ChainableStack::instance_->memalloc_.alloc_array<Scalar>(other.size()),
-        get_rows(other), get_cols(other));
+    new (this) Base(allocate(other.size()), get_rows(other), get_cols(other));
     Base::operator=(other);
     return *this;
   }
@@ -143,6 +175,20 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
   arena_matrix(const Base& other)  // NOLINT
       : Base::Map(other) {}
 
+  /**
+   * Constructs `arena_matrix` from pinned data. Pinned data is shared
+   * by threads and must not be written to, so only an `arena_matrix` of
+   * a const type refers to the pinned memory, which must then outlive
+   * the tape. Any other `arena_matrix` holds a copy on the arena.
+   * @param other pinned matrix
+   */
+  arena_matrix(const pinned_data<PlainObject>& other)  // NOLINT
+      : Base::Map(map_or_allocate(other), other.rows(), other.cols()) {
+    if constexpr (!std::is_const<MatrixType>::value) {
+      Base::operator=(other);
+    }
+  }
+
   /**
    * Copy constructor.
    * @param other matrix to copy from
@@ -167,6 +213,21 @@ class arena_matrix<MatrixType, require_eigen_dense_base_t<MatrixType>>
     return *this;
   }
 
+  /**
+   * Assigns pinned data. An `arena_matrix` of a const type refers to the
+   * pinned memory afterwards, any other `arena_matrix` holds a copy on
+   * the arena.
+   * @param other pinned matrix
+   * @return `*this`
+   */
+  arena_matrix& operator=(const pinned_data<PlainObject>& other) {
+    new (this) Base(map_or_allocate(other), other.rows(), other.cols());
+    if constexpr (!std::is_const<MatrixType>::value) {
+      Base::operator=(other);
+    }
+    return *this;
+  }
+
   /**
    * Forces hard copying matrices into an arena matrix
    * @tparam T Any type assignable to `Base`
@@ -0,0 +1,238 @@
+#ifndef STAN_MATH_REV_CORE_ARENA_TAG_HPP
+#define STAN_MATH_REV_CORE_ARENA_TAG_HPP
+
+#include <stan/math/rev/core/chainablestack.hpp>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Arena memory allocated under one tag on the current thread since the
+ * last call to `clear_arena_tags()`.
+ */
+struct arena_tag_stats {
+  /**
+   * Bytes allocated while a scope of the tag was active, including the
+   * bytes of nested scopes of other tags.
+   */
+  size_t bytes_{0};
+  /**
+   * Bytes allocated while a scope of the tag was the innermost active
+   * scope.
+   */
+  size_t self_bytes_{0};
+  /**
+   * Number of scopes of the tag, or of allocations for the built-in
+   * "arena_matrix" tag.
+   */
+  size_t count_{0};
+  /**
+   * Largest number of bytes allocated by a single scope of the tag.
+   */
+  size_t max_bytes_{0};
+};
+
+/**
+ * Memory of the arena of the AD tape of the current thread.
+ */
+struct arena_memory_stats {
+  /**
+   * Bytes handed out since the tape was last recovered.
+   */
+  size_t bytes_used_{0};
+  /**
+   * Bytes of the blocks holding the memory in use.
+   */
+  size_t bytes_allocated_{0};
+  /**
+   * Bytes of all blocks held by the arena, including blocks which are
+   * not in use.
+   */
+  size_t bytes_retained_{0};
+  /**
+   * Largest number of bytes in use since the peak was last reset.
+   */
+  size_t peak_bytes_used_{0};
+};
+
+namespace internal {
+
+inline std::atomic<bool>& arena_tags_flag() {
+  static std::atomic<bool> enabled{false};
+  return enabled;
+}
+
+/**
+ * Tags and active scopes of the current thread.
+ */
+struct arena_tag_registry {
+  struct scope {
+    arena_tag_stats* stats_;
+    size_t start_bytes_;
+    size_t child_bytes_;
+  };
+  std::map<std::string, arena_tag_stats> tags_;
+  std::vector<scope> active_;
+};
+
+inline arena_tag_registry& local_arena_tags() {
+  static thread_local arena_tag_registry registry;
+  return registry;
+}
+
+/**
+ * Count an allocation of an `arena_matrix` under the built-in
+ * "arena_matrix" tag if arena tags are enabled.
+ *
+ * @param bytes size of the allocation
+ */
+inline void count_arena_matrix_bytes(size_t bytes) {
+  if (!arena_tags_flag().load(std::memory_order_relaxed)) {
+    return;
+  }
+  arena_tag_stats& stats = local_arena_tags().tags_["arena_matrix"];
+  stats.bytes_ += bytes;
+  stats.self_bytes_ += bytes;
+  ++stats.count_;
+  if (bytes > stats.max_bytes_) {
+    stats.max_bytes_ = bytes;
+  }
+}
+
+}  // namespace internal
+
+/**
+ * Set whether `arena_tag` scopes and `arena_matrix` allocations are
+ * accounted. Off by default, in which case an `arena_tag` costs a single
+ * relaxed load.
+ *
+ * @param enable true if arena memory is accounted by tag
+ */
+inline void set_arena_tags(bool enable) {
+  internal::arena_tags_flag().store(enable, std::memory_order_relaxed);
+}
+
+/**
+ * Return the arena memory accounted by tag on the current thread. Next
+ * to the tags of `arena_tag` scopes, the "arena_matrix" tag holds the
+ * values of all `arena_matrix` objects; the rest of the memory of a
+ * scope is taken by varis and other arrays.
+ */
+inline const std::map<std::string, arena_tag_stats>& arena_tags() {
+  return internal::local_arena_tags().tags_;
+}
+
+/**
+ * Forget the arena memory accounted by tag on the current thread.
+ * Active scopes keep being accounted.
+ */
+inline void clear_arena_tags() {
+  auto& registry = internal::local_arena_tags();
+  if (registry.active_.empty()) {
+    registry.tags_.clear();
+    return;
+  }
+  for (auto& tag : registry.tags_) {
+    tag.second = arena_tag_stats();
+  }
+}
+
+/**
+ * Return the memory of the arena of the AD tape of the current thread.
+ * This takes constant time.
+ */
+inline arena_memory_stats arena_memory() {
+  const auto& memalloc = ChainableStack::instance_->memalloc_;
+  arena_memory_stats stats;
+  stats.bytes_used_ = memalloc.bytes_used();
+  stats.bytes_allocated_ = memalloc.bytes_allocated();
+  stats.bytes_retained_ = memalloc.bytes_retained();
+  stats.peak_bytes_used_ = memalloc.peak_bytes_used();
+  return stats;
+}
+
+/**
+ * Restart tracking the peak of the arena memory in use on the current
+ * thread.
+ */
+inline void reset_arena_peak() {
+  ChainableStack::instance_->memalloc_.reset_peak_bytes_used();
+}
+
+/**
+ * Accounts the arena memory allocated on the current thread while the
+ * object is in scope under the specified tag, such as the name of a
+ * model component or of a function.
+ *
+ * The memory is measured as the growth of the arena in use between the
+ * construction and the destruction of the scope, so memory recovered by
+ * a nested scope of the AD tape inside the tag is not counted. Scopes
+ * must be destroyed in the reverse order of their construction.
+ *
+ * Example:
+ *
+ * set_arena_tags(true);
+ * {
+ *   arena_tag tag("likelihood");
+ *   lp += normal_lpdf(y, mu, sigma);
+ * }
+ * for (const auto& tag : arena_tags()) { ... }
+ */
+class arena_tag {
+  bool active_;
+
+ public:
+  /**
+   * Start accounting memory under the specified tag, if arena tags are
+   * enabled.
+   *
+   * @param name name of the tag
+   */
+  explicit arena_tag(const char* name)
+      : active_(internal::arena_tags_flag().load(std::memory_order_relaxed)) {
+    if (active_) {
+      auto& registry = internal::local_arena_tags();
+      registry.active_.push_back(
+          {&registry.tags_[name],
+           ChainableStack::instance_->memalloc_.bytes_used(), 0});
+    }
+  }
+
+  arena_tag(const arena_tag&) = delete;
+  arena_tag& operator=(const arena_tag&) = delete;
+
+  /**
+   * Stop accounting memory under the tag.
+   */
+  ~arena_tag() {
+    if (!active_) {
+      return;
+    }
+    auto& registry = internal::local_arena_tags();
+    const auto scope = registry.active_.back();
+    registry.active_.pop_back();
+    const size_t end_bytes = ChainableStack::instance_->memalloc_.bytes_used();
+    const size_t bytes
+        = end_bytes > scope.start_bytes_ ? end_bytes - scope.start_bytes_ : 0;
+    arena_tag_stats& stats = *scope.stats_;
+    stats.bytes_ += bytes;
+    stats.self_bytes_ += bytes > scope.child_bytes_ ? bytes - scope.child_bytes_
+                                                    : 0;
+    ++stats.count_;
+    if (bytes > stats.max_bytes_) {
+      stats.max_bytes_ = bytes;
+    }
+    if (!registry.active_.empty()) {
+      registry.active_.back().child_bytes_ += bytes;
+    }
+  }
+};
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -2,6 +2,7 @@
 #define STAN_MATH_REV_CORE_AUTODIFFSTACKSTORAGE_HPP
 
 #include <stan/math/memory/stack_alloc.hpp>
+#include <atomic>
 #include <vector>
 
 namespace stan {
@@ -24,6 +25,78 @@ namespace math {
 #define STAN_THREADS_DEF
 #endif
 
+/**
+ * Number of nodes and arena bytes of an autodiff tape.
+ */
+struct autodiff_size {
+  size_t chain_nodes_ = 0;
+  size_t nochain_nodes_ = 0;
+  size_t arena_bytes_ = 0;
+};
+
+namespace internal {
+/**
+ * Process wide record of the largest autodiff tape recovered so far.
+ * If `reserve_new_stacks_` is set, every autodiff stack constructed
+ * afterwards reserves that size up front.
+ */
+struct autodiff_size_record {
+  std::atomic<size_t> chain_nodes_{0};
+  std::atomic<size_t> nochain_nodes_{0};
+  std::atomic<size_t> arena_bytes_{0};
+  std::atomic<bool> reserve_new_stacks_{false};
+
+  static inline void update_max(std::atomic<size_t> &peak, size_t x) {
+    size_t cur = peak.load(std::memory_order_relaxed);
+    while (cur < x
+           && !peak.compare_exchange_weak(cur, x, std::memory_order_relaxed)) {
+    }
+  }
+
+  inline void update(const autodiff_size &size) {
+    update_max(chain_nodes_, size.chain_nodes_);
+    update_max(nochain_nodes_, size.nochain_nodes_);
+    update_max(arena_bytes_, size.arena_bytes_);
+  }
+
+  inline autodiff_size get() const {
+    autodiff_size size;
+    size.chain_nodes_ = chain_nodes_.load(std::memory_order_relaxed);
+    size.nochain_nodes_ = nochain_nodes_.load(std::memory_order_relaxed);
+    size.arena_bytes_ = arena_bytes_.load(std::memory_order_relaxed);
+    return size;
+  }
+};
+
+inline autodiff_size_record &get_autodiff_size_record() {
+  static autodiff_size_record record;
+  return record;
+}
+}  // namespace internal
+
+/**
+ * A contiguous range of adjoint memory. All ranges registered on the
+ * autodiff stack are set to zero with one `memset` each by
+ * `set_zero_all_adjoints()`.
+ */
+struct zeroable_range {
+  void *begin_;
+  size_t nbytes_;
+};
+
+/**
+ * The owner of adjoint memory registered with `push_zeroable_range()`.
+ * An adjoint which was reassigned to new memory would no longer be
+ * zeroed by the `memset` of its range, so `set_zero_all_adjoints()`
+ * calls `zero_if_moved_` with every owner and its registered memory to
+ * zero such an adjoint where it is now.
+ */
+struct zeroable_range_owner {
+  void *owner_;
+  const void *begin_;
+  void (*zero_if_moved_)(void *, const void *);
+};
+
 /**
  * This struct always provides access to the autodiff stack using
  * the singleton pattern. Read warnings below!
@@ -99,17 +172,114 @@ struct AutodiffStackSingleton {
   }
 
   struct AutodiffStackStorage {
+    AutodiffStackStorage() {
+      const auto &record = internal::get_autodiff_size_record();
+      if (record.reserve_new_stacks_.load(std::memory_order_relaxed)) {
+        reserve(record.get());
+      }
+    }
     AutodiffStackStorage &operator=(const AutodiffStackStorage &) = delete;
 
     std::vector<ChainableT *> var_stack_;
     std::vector<ChainableT *> var_nochain_stack_;
     std::vector<ChainableAllocT *> var_alloc_stack_;
+    std::vector<zeroable_range> zeroable_ranges_;
+    std::vector<zeroable_range_owner> zeroable_range_owners_;
     stack_alloc memalloc_;
 
     // nested positions
     std::vector<size_t> nested_var_stack_sizes_;
     std::vector<size_t> nested_var_nochain_stack_sizes_;
     std::vector<size_t> nested_var_alloc_stack_starts_;
+    std::vector<size_t> nested_zeroable_ranges_sizes_;
+    std::vector<size_t> nested_zeroable_range_owners_sizes_;
+
+    /**
+     * Register adjoint memory to be zeroed by `set_zero_all_adjoints()`.
+     * A range directly following the last range of the current nesting
+     * level is merged into it.
+     *
+     * @param begin first byte of the range
+     * @param nbytes number of bytes in the range
+     */
+    inline void push_zeroable_range(void *begin, size_t nbytes) {
+      if (nbytes == 0) {
+        return;
+      }
+      const size_t nested_start = nested_zeroable_ranges_sizes_.empty()
+                                      ? 0
+                                      : nested_zeroable_ranges_sizes_.back();
+      if (zeroable_ranges_.size() > nested_start) {
+        zeroable_range &last = zeroable_ranges_.back();
+        if (static_cast<char *>(last.begin_) + last.nbytes_ == begin) {
+          last.nbytes_ += nbytes;
+          return;
+        }
+      }
+      zeroable_ranges_.push_back(zeroable_range{begin, nbytes});
+    }
+
+    /**
+     * Register adjoint memory to be zeroed by `set_zero_all_adjoints()`
+     * like `push_zeroable_range(void*, size_t)`, and record its owner,
+     * so that the adjoint is still zeroed if the owner reassigns it to
+     * new memory.
+     *
+     * @param begin first byte of the range
+     * @param nbytes number of bytes in the range
+     * @param owner owner of the adjoint memory
+     * @param zero_if_moved function called with the owner and `begin`,
+     * which zeroes the adjoint of the owner unless it is still at `begin`
+     */
+    inline void push_zeroable_range(void *begin, size_t nbytes, void *owner,
+                                    void (*zero_if_moved)(void *,
+                                                          const void *)) {
+      if (nbytes == 0) {
+        return;
+      }
+      push_zeroable_range(begin, nbytes);
+      zeroable_range_owners_.push_back(
+          zeroable_range_owner{owner, begin, zero_if_moved});
+    }
+
+    /**
+     * Zero the adjoints which the owners of the registered adjoint
+     * memory, starting with the specified one, reassigned to new memory.
+     * This is one comparison of pointers per owner if no adjoint moved.
+     *
+     * @param start index of the first owner to check
+     */
+    inline void zero_moved_adjoints(size_t start) {
+      for (size_t i = start; i < zeroable_range_owners_.size(); ++i) {
+        const zeroable_range_owner &x = zeroable_range_owners_[i];
+        x.zero_if_moved_(x.owner_, x.begin_);
+      }
+    }
+
+    /**
+     * Return the number of nodes and arena bytes used by the whole tape.
+     */
+    inline autodiff_size size() const {
+      autodiff_size size;
+      size.chain_nodes_ = var_stack_.size();
+      size.nochain_nodes_ = var_nochain_stack_.size();
+      size.arena_bytes_ = memalloc_.bytes_used();
+      return size;
+    }
+
+    /**
+     * Make sure a tape of the specified size can be recorded without
+     * growing the node stacks or allocating arena blocks.
+     *
+     * @param size number of nodes and arena bytes to reserve
+     */
+    inline void reserve(const autodiff_size &size) {
+      var_stack_.reserve(size.chain_nodes_);
+      var_nochain_stack_.reserve(size.nochain_nodes_);
+      if (size.arena_bytes_ > 0) {
+        memalloc_.reserve(size.arena_bytes_);
+      }
+    }
   };
 
   explicit AutodiffStackSingleton(AutodiffStackSingleton_t const &) = delete;
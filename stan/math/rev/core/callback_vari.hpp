@@ -19,6 +19,8 @@ struct callback_vari : public vari_value<T> {
         rev_functor_(std::forward<F>(rev_functor)) {}
 
   inline void chain() final { rev_functor_(*this); }
+
+  bool reads_only_own_adjoint() const final { return true; }
 };
 
 }  // namespace internal
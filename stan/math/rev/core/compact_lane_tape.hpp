@@ -0,0 +1,203 @@
+#ifndef STAN_MATH_REV_CORE_COMPACT_LANE_TAPE_HPP
+#define STAN_MATH_REV_CORE_COMPACT_LANE_TAPE_HPP
+
+#include <stan/math/rev/core/compact_tape.hpp>
+#include <stan/math/rev/core/vari.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * A reverse pass over K lanes at once: the compact tapes of K
+ * evaluations of the same function at different points, merged into a
+ * single tape whose nodes carry K adjoints and whose records carry K
+ * partials, one per lane.
+ *
+ * The merge succeeds if the compact tapes of all lanes have the same
+ * structure: only linear records, the same number of operands per
+ * record, and operands referring to the same nodes, that is the same
+ * input, the same earlier record or any other vari in every lane. This
+ * is the case for a function without branches on the values of its
+ * arguments whose operations all have linearizable varis. Other varis
+ * cannot be merged, since their reverse pass is only known through
+ * `chain()`, and a function whose tape differs between the lanes cannot
+ * be merged either; the lanes then have to be swept one by one, for
+ * example with their compact tapes.
+ *
+ * The reverse pass over the merged tape visits every record once for
+ * all K lanes. The K adjoints of a node and the K partials of an operand
+ * are contiguous, so the dispatch and the loads of the record are
+ * amortized over the lanes and the inner loop over the lanes is
+ * vectorized.
+ *
+ * Example:
+ *
+ * std::vector<compact_tape> tapes; // one per lane
+ * ...
+ * compact_lane_tape lanes;
+ * if (lanes.build(tapes, dependents, inputs)) {
+ *   lanes.grad(grads);
+ * }
+ */
+class compact_lane_tape {
+  /**
+   * Record whose reverse pass adds the adjoints of node `out_` times
+   * the partials of operand `k` to the adjoints of node `operands_[k]`
+   * for all `k` in `[begin_, end_)`, in every lane.
+   */
+  struct lane_record {
+    std::uint32_t out_;
+    std::uint32_t begin_;
+    std::uint32_t end_;
+  };
+
+  size_t num_lanes_{0};
+  size_t num_inputs_{0};
+  size_t num_nodes_{0};
+  std::uint32_t dependent_{0};
+  std::vector<lane_record> records_;
+  std::vector<std::uint32_t> operands_;
+  std::vector<double> partials_;
+
+ public:
+  /**
+   * Merge the compact tapes of the lanes. The nodes of the merged tape
+   * are the inputs, followed by a node standing for all other varis,
+   * such as leaves and varis from outside the tapes, whose adjoints are
+   * not returned, followed by the outputs of the records.
+   *
+   * @param tapes compact tape of every lane
+   * @param dependents root of partial derivative propagation of every
+   * lane
+   * @param inputs varis of the inputs of every lane, the same number in
+   * every lane
+   * @return true if the tapes of all lanes have the same structure and
+   * were merged, false otherwise
+   */
+  inline bool build(const std::vector<compact_tape>& tapes,
+                    const std::vector<vari*>& dependents,
+                    const std::vector<std::vector<vari*>>& inputs) {
+    num_lanes_ = tapes.size();
+    num_inputs_ = num_lanes_ == 0 ? 0 : inputs[0].size();
+    records_.clear();
+    operands_.clear();
+    partials_.clear();
+    if (num_lanes_ == 0) {
+      num_nodes_ = num_inputs_ + 1;
+      return true;
+    }
+    const size_t num_records = tapes[0].num_linear();
+    const size_t num_operands = tapes[0].num_operands();
+    const std::uint32_t other = num_inputs_;
+    num_nodes_ = num_inputs_ + 1 + num_records;
+    records_.reserve(num_records);
+    operands_.reserve(num_operands);
+    partials_.resize(num_operands * num_lanes_);
+
+    std::unordered_map<const vari*, std::uint32_t> ids;
+    for (size_t lane = 0; lane < num_lanes_; ++lane) {
+      const compact_tape& tape = tapes[lane];
+      if (tape.num_opaque() != 0 || tape.num_linear() != num_records
+          || tape.num_operands() != num_operands
+          || inputs[lane].size() != num_inputs_) {
+        return false;
+      }
+      ids.clear();
+      ids.reserve(num_inputs_ + num_records);
+      for (size_t i = 0; i < num_inputs_; ++i) {
+        if (!ids.emplace(inputs[lane][i], i).second) {
+          return false;
+        }
+      }
+      auto id_of = [&](const vari* vi) {
+        const auto it = ids.find(vi);
+        return it == ids.end() ? other : it->second;
+      };
+      const auto& records = tape.linear_records();
+      const auto& operands = tape.operands();
+      const auto& partials = tape.partials();
+      for (size_t r = 0; r < num_records; ++r) {
+        const compact_tape::linear_record& rec = records[r];
+        if (lane == 0) {
+          records_.push_back(lane_record{
+              static_cast<std::uint32_t>(num_inputs_ + 1 + r), rec.begin_,
+              rec.end_});
+        } else if (rec.begin_ != records_[r].begin_
+                   || rec.end_ != records_[r].end_) {
+          return false;
+        }
+        for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+          const std::uint32_t id = id_of(operands[k]);
+          if (lane == 0) {
+            operands_.push_back(id);
+          } else if (operands_[k] != id) {
+            return false;
+          }
+          partials_[k * num_lanes_ + lane] = partials[k];
+        }
+        ids.emplace(rec.out_, records_[r].out_);
+      }
+      const std::uint32_t dependent = id_of(dependents[lane]);
+      if (lane == 0) {
+        dependent_ = dependent;
+      } else if (dependent != dependent_) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Run the reverse pass over all lanes from their dependent variables
+   * and return the adjoints of the inputs. The adjoints of the varis of
+   * the lanes are neither used nor changed.
+   *
+   * @param[out] grad matrix with one row per input and one column per
+   * lane, receiving the gradient of the dependent variable of every lane
+   */
+  inline void grad(Eigen::Ref<Eigen::MatrixXd> grad) const {
+    const size_t num_lanes = num_lanes_;
+    std::vector<double> adj(num_nodes_ * num_lanes, 0.0);
+    double* dependent_adj = adj.data() + dependent_ * num_lanes;
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      dependent_adj[lane] = 1.0;
+    }
+    const std::uint32_t* operands = operands_.data();
+    const double* partials = partials_.data();
+    for (size_t r = records_.size(); r-- > 0;) {
+      const lane_record& rec = records_[r];
+      const double* out_adj = adj.data() + rec.out_ * num_lanes;
+      for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+        double* op_adj = adj.data() + operands[k] * num_lanes;
+        const double* partial = partials + k * num_lanes;
+        for (size_t lane = 0; lane < num_lanes; ++lane) {
+          op_adj[lane] += out_adj[lane] * partial[lane];
+        }
+      }
+    }
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      for (size_t i = 0; i < num_inputs_; ++i) {
+        grad.coeffRef(i, lane) = adj[i * num_lanes + lane];
+      }
+    }
+  }
+
+  /**
+   * Return the number of lanes.
+   */
+  inline size_t num_lanes() const noexcept { return num_lanes_; }
+
+  /**
+   * Return the number of records, each swept once for all lanes.
+   */
+  inline size_t num_records() const noexcept { return records_.size(); }
+};
+
+}  // namespace math
+}  // namespace stan
+#endif
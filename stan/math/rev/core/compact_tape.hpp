@@ -0,0 +1,384 @@
+#ifndef STAN_MATH_REV_CORE_COMPACT_TAPE_HPP
+#define STAN_MATH_REV_CORE_COMPACT_TAPE_HPP
+
+#include <stan/math/rev/core/chainablestack.hpp>
+#include <stan/math/rev/core/empty_nested.hpp>
+#include <stan/math/rev/core/vari.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_set>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * A devirtualized copy of the reverse pass of the autodiff tape.
+ *
+ * Constructing a `compact_tape` walks the chain stack of the current
+ * nested scope (or the whole stack if there is no nesting) once. Every
+ * vari whose reverse pass is described by `vari_base::linearize()` is
+ * stored as a record holding its output vari and a range of operands
+ * and partials in contiguous buffers. All other varis are kept as
+ * opaque pointers whose `chain()` is called. Plain `vari` leaves, whose
+ * `chain()` is empty, are dropped. Consecutive records of the same kind
+ * are grouped into runs, so the reverse pass is a tight loop over
+ * linear records without virtual calls, interrupted by calls to
+ * `chain()` only where the tape holds other varis.
+ *
+ * Example:
+ *
+ * var f = ...;
+ * compact_tape tape;
+ * tape.grad(f.vi_);
+ *
+ * The partials are evaluated when the compact tape is built, so it
+ * has to be built after the forward pass. It stays valid as long as
+ * the varis it was built from are on the tape; varis created after it
+ * was built are not part of it. Building the compact tape costs about
+ * as much as one reverse pass, so it pays off when the reverse pass is
+ * run several times over the same tape, for example for the rows of a
+ * Jacobian.
+ */
+class compact_tape {
+ public:
+  /**
+   * Record of a vari whose reverse pass adds the adjoint of `out_`
+   * times `partials_[i]` to the adjoint of `operands_[i]` for
+   * all `i` in `[begin_, end_)`.
+   */
+  struct linear_record {
+    vari* out_;
+    std::uint32_t begin_;
+    std::uint32_t end_;
+  };
+
+  enum class run_kind : std::uint8_t { linear, opaque };
+
+  /**
+   * A run of consecutive records of the same kind. `begin_` and `end_`
+   * index the linear records or the opaque varis.
+   */
+  struct run {
+    run_kind kind_;
+    size_t begin_;
+    size_t end_;
+  };
+
+  /**
+   * Number of records and operands removed by `prune()`.
+   */
+  struct prune_stats {
+    size_t num_linear_;
+    size_t num_opaque_;
+    size_t num_operands_;
+  };
+
+ private:
+  std::vector<linear_record> linear_;
+  std::vector<vari*> operands_;
+  std::vector<double> partials_;
+  std::vector<vari_base*> opaque_;
+  std::vector<run> runs_;
+  size_t num_leaves_{0};
+
+  /**
+   * Add a record of the given kind, extending the last run if it has
+   * the same kind.
+   */
+  inline void push_run(run_kind kind, size_t index) {
+    if (!runs_.empty() && runs_.back().kind_ == kind) {
+      runs_.back().end_ = index + 1;
+    } else {
+      runs_.push_back(run{kind, index, index + 1});
+    }
+  }
+
+ public:
+  /**
+   * Build the compact tape for the chain stack of the current nested
+   * scope, or the whole chain stack if there is no nesting.
+   *
+   * @throw std::length_error if the linear records have more than
+   * 2^32 - 1 operands
+   */
+  compact_tape() {
+    const auto& stack = ChainableStack::instance_->var_stack_;
+    const size_t begin
+        = empty_nested()
+              ? 0
+              : ChainableStack::instance_->nested_var_stack_sizes_.back();
+    build(stack.data() + begin, stack.data() + stack.size());
+  }
+
+  /**
+   * Build the compact tape for the given range of varis, listed in the
+   * order in which they were put on the chain stack.
+   *
+   * @param first Pointer to the first vari of the range
+   * @param last Pointer past the last vari of the range
+   * @throw std::length_error if the linear records have more than
+   * 2^32 - 1 operands
+   */
+  compact_tape(vari_base* const* first, vari_base* const* last) {
+    build(first, last);
+  }
+
+  /**
+   * Build the compact tape for the given range of varis, discarding the
+   * current contents.
+   *
+   * @param first Pointer to the first vari of the range
+   * @param last Pointer past the last vari of the range
+   * @throw std::length_error if the linear records have more than
+   * 2^32 - 1 operands
+   */
+  inline void build(vari_base* const* first, vari_base* const* last) {
+    linear_.clear();
+    operands_.clear();
+    partials_.clear();
+    opaque_.clear();
+    runs_.clear();
+    num_leaves_ = 0;
+    for (auto it = first; it != last; ++it) {
+      vari_base* node = *it;
+      const size_t begin = operands_.size();
+      if (node->linearize(operands_, partials_)) {
+        if (operands_.size() > std::numeric_limits<std::uint32_t>::max()) {
+          throw std::length_error(
+              "compact_tape: the tape has more than 2^32 - 1 operands");
+        }
+        linear_.push_back(linear_record{static_cast<vari*>(node),
+                                        static_cast<std::uint32_t>(begin),
+                                        static_cast<std::uint32_t>(
+                                            operands_.size())});
+        push_run(run_kind::linear, linear_.size() - 1);
+      } else {
+        operands_.resize(begin);
+        partials_.resize(begin);
+        // only checked here, as comparing types may compare their names
+        if (typeid(*node) == typeid(vari)) {
+          ++num_leaves_;
+          continue;
+        }
+        opaque_.push_back(node);
+        push_run(run_kind::opaque, opaque_.size() - 1);
+      }
+    }
+  }
+
+  /**
+   * Remove the records that cannot propagate a nonzero adjoint to the
+   * operands of the tape when the reverse pass starts from the specified
+   * dependent variable, and the operands whose partial is exactly zero.
+   *
+   * The tape is walked backwards from the dependent variable, marking
+   * the operands of every record whose output is marked. Records whose
+   * output is not marked are removed, such as diagnostics computed on
+   * `var`s that never feed into the dependent variable. An opaque scalar
+   * vari whose output is not marked is removed as well if it is known
+   * to read only its own adjoint, which stays zero (see
+   * `vari_base::reads_only_own_adjoint()`, for example for
+   * `callback_vari` and the unary and binary operator varis). All other
+   * opaque varis are kept, such as reverse pass callbacks, matrix varis
+   * and varis computing several outputs at once. Opaque varis that are
+   * kept may propagate to operands that are not known, so every record
+   * before the last kept opaque vari is kept.
+   *
+   * After pruning, `grad(dependent)` gives the same adjoints for the
+   * operands of the tape as before, as long as all adjoints other than
+   * the one of the dependent variable are zero when it is called. The
+   * adjoints of removed outputs are no longer computed.
+   *
+   * @param dependent root of partial derivative propagation
+   * @return number of removed records and operands
+   */
+  inline prune_stats prune(const vari_base* dependent) {
+    std::vector<bool> keep_linear(linear_.size(), false);
+    std::vector<bool> keep_opaque(opaque_.size(), false);
+    std::unordered_set<const vari_base*> live;
+    live.insert(dependent);
+    bool keep_all = false;
+    for (auto run_it = runs_.rbegin(); run_it != runs_.rend(); ++run_it) {
+      for (size_t i = run_it->end_; i-- > run_it->begin_;) {
+        if (run_it->kind_ == run_kind::linear) {
+          const linear_record& rec = linear_[i];
+          if (keep_all || live.count(rec.out_)) {
+            keep_linear[i] = true;
+            for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+              live.insert(operands_[k]);
+            }
+          }
+        } else {
+          const vari_base* node = opaque_[i];
+          if (keep_all || live.count(node) || !node->reads_only_own_adjoint()
+              || dynamic_cast<const vari*>(node) == nullptr) {
+            keep_opaque[i] = true;
+            keep_all = true;
+          }
+        }
+      }
+    }
+
+    prune_stats stats{0, 0, 0};
+    std::vector<linear_record> linear;
+    std::vector<vari*> operands;
+    std::vector<double> partials;
+    std::vector<vari_base*> opaque;
+    std::vector<run> runs;
+    linear.reserve(linear_.size());
+    operands.reserve(operands_.size());
+    partials.reserve(partials_.size());
+    runs_.swap(runs);
+    for (const auto& r : runs) {
+      for (size_t i = r.begin_; i < r.end_; ++i) {
+        if (r.kind_ == run_kind::opaque) {
+          if (keep_opaque[i]) {
+            opaque.push_back(opaque_[i]);
+            push_run(run_kind::opaque, opaque.size() - 1);
+          } else {
+            ++stats.num_opaque_;
+          }
+          continue;
+        }
+        const linear_record& rec = linear_[i];
+        if (!keep_linear[i]) {
+          ++stats.num_linear_;
+          stats.num_operands_ += rec.end_ - rec.begin_;
+          continue;
+        }
+        const size_t begin = operands.size();
+        for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+          if (partials_[k] == 0.0) {
+            ++stats.num_operands_;
+            continue;
+          }
+          operands.push_back(operands_[k]);
+          partials.push_back(partials_[k]);
+        }
+        linear.push_back(linear_record{
+            rec.out_, static_cast<std::uint32_t>(begin),
+            static_cast<std::uint32_t>(operands.size())});
+        push_run(run_kind::linear, linear.size() - 1);
+      }
+    }
+    linear_.swap(linear);
+    operands_.swap(operands);
+    partials_.swap(partials);
+    opaque_.swap(opaque);
+    return stats;
+  }
+
+  /**
+   * Run the reverse pass over the compact tape. Equivalent to calling
+   * `chain()` on every vari of the tape in reverse order.
+   */
+  inline void chain() const {
+    vari* const* operands = operands_.data();
+    const double* partials = partials_.data();
+    for (auto run_it = runs_.rbegin(); run_it != runs_.rend(); ++run_it) {
+      if (run_it->kind_ == run_kind::linear) {
+        for (size_t i = run_it->end_; i-- > run_it->begin_;) {
+          const linear_record& rec = linear_[i];
+          const double adj = rec.out_->adj_;
+          for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+            operands[k]->adj_ += adj * partials[k];
+          }
+        }
+      } else {
+        for (size_t i = run_it->end_; i-- > run_it->begin_;) {
+          opaque_[i]->chain();
+        }
+      }
+    }
+  }
+
+  /**
+   * Initialize the adjoint of the given root variable and run the
+   * reverse pass over the compact tape. Like `grad(vi)`, this does not
+   * zero any adjoints.
+   *
+   * @tparam Vari type of root variable implementation
+   * @param vi root of partial derivative propagation
+   */
+  template <typename Vari>
+  inline void grad(Vari* vi) const {
+    vi->init_dependent();
+    chain();
+  }
+
+  /**
+   * Return the number of varis stored as linear records.
+   */
+  inline size_t num_linear() const noexcept { return linear_.size(); }
+
+  /**
+   * Return the number of varis whose `chain()` is called.
+   */
+  inline size_t num_opaque() const noexcept { return opaque_.size(); }
+
+  /**
+   * Return the number of plain `vari` leaves dropped from the tape.
+   */
+  inline size_t num_leaves() const noexcept { return num_leaves_; }
+
+  /**
+   * Return the number of operands over all linear records.
+   */
+  inline size_t num_operands() const noexcept { return operands_.size(); }
+
+  /**
+   * Return the runs of records of the same kind, in tape order.
+   */
+  inline const std::vector<run>& runs() const noexcept { return runs_; }
+
+  /**
+   * Return the linear records, in tape order.
+   */
+  inline const std::vector<linear_record>& linear_records() const noexcept {
+    return linear_;
+  }
+
+  /**
+   * Return the operands of the linear records.
+   */
+  inline const std::vector<vari*>& operands() const noexcept {
+    return operands_;
+  }
+
+  /**
+   * Return the partials of the linear records.
+   */
+  inline const std::vector<double>& partials() const noexcept {
+    return partials_;
+  }
+
+  /**
+   * Return the varis whose `chain()` is called, in tape order.
+   */
+  inline const std::vector<vari_base*>& opaque() const noexcept {
+    return opaque_;
+  }
+};
+
+/**
+ * Compute the gradient of the specified root variable over a compact
+ * copy of the tape of the current nested scope (or of the whole tape).
+ * Gives the same result as `grad(vi)` without virtual calls for the
+ * varis that can be linearized.
+ *
+ * @tparam Vari type of root variable implementation
+ * @param vi root of partial derivative propagation
+ */
+template <typename Vari>
+inline void grad_compact(Vari* vi) {
+  compact_tape tape;
+  tape.grad(vi);
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
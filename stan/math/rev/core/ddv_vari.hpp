@@ -15,6 +15,8 @@ class op_ddv_vari : public vari {
  public:
   op_ddv_vari(double f, double a, double b, vari* cvi)
       : vari(f), ad_(a), bd_(b), cvi_(cvi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -13,6 +13,8 @@ class op_dv_vari : public vari {
 
  public:
   op_dv_vari(double f, double a, vari* bvi) : vari(f), ad_(a), bvi_(bvi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -15,6 +15,8 @@ class op_dvd_vari : public vari {
  public:
   op_dvd_vari(double f, double a, vari* bvi, double c)
       : vari(f), ad_(a), bvi_(bvi), cd_(c) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
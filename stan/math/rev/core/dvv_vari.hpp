@@ -15,6 +15,8 @@ class op_dvv_vari : public vari {
  public:
   op_dvv_vari(double f, double a, vari* bvi, vari* cvi)
       : vari(f), ad_(a), bvi_(bvi), cvi_(cvi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -6,6 +6,7 @@
 #include <stan/math/rev/core/empty_nested.hpp>
 #include <stan/math/rev/core/nested_size.hpp>
 #include <stan/math/rev/core/vari.hpp>
+#include <stan/math/prim/core/trace_events.hpp>
 #include <vector>
 
 namespace stan {
@@ -22,8 +23,12 @@ namespace math {
  *
  * <p>This function does not recover any memory from the computation.
  *
+ * <p>The reverse pass is recorded as a region of the timeline when a
+ * trace is recorded with `start_trace()`.
+ *
  */
 static inline void grad() {
+  const trace_region region("reverse pass", "autodiff");
   size_t end = ChainableStack::instance_->var_stack_.size();
   size_t beginning = empty_nested() ? 0 : end - nested_size();
   for (size_t i = end; i-- > beginning;) {
@@ -0,0 +1,508 @@
+#ifndef STAN_MATH_REV_CORE_GRAD_PARALLEL_HPP
+#define STAN_MATH_REV_CORE_GRAD_PARALLEL_HPP
+
+#include <stan/math/rev/core/chainablestack.hpp>
+#include <stan/math/rev/core/compact_tape.hpp>
+#include <stan/math/rev/core/empty_nested.hpp>
+#include <stan/math/rev/core/vari.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace stan {
+namespace math {
+namespace internal {
+
+/**
+ * An open addressing hash table numbering distinct varis in the order
+ * they are inserted.
+ */
+class vari_index {
+  std::vector<vari*> keys_;
+  // index of the key plus one, or zero for an empty bucket
+  std::vector<std::uint32_t> buckets_;
+  unsigned bits_{0};
+
+  inline size_t bucket(const vari* vi) const noexcept {
+    return (reinterpret_cast<std::uintptr_t>(vi) * 0x9E3779B97F4A7C15ULL)
+           >> (64 - bits_);
+  }
+
+  inline void rehash(unsigned bits) {
+    bits_ = bits;
+    buckets_.assign(size_t(1) << bits_, 0);
+    const size_t mask = buckets_.size() - 1;
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      size_t b = bucket(keys_[i]);
+      while (buckets_[b] != 0) {
+        b = (b + 1) & mask;
+      }
+      buckets_[b] = i + 1;
+    }
+  }
+
+ public:
+  static constexpr std::uint32_t none
+      = std::numeric_limits<std::uint32_t>::max();
+
+  /**
+   * Remove all keys, making room for the specified number of keys.
+   */
+  inline void clear(size_t capacity) {
+    keys_.clear();
+    unsigned bits = 4;
+    while ((size_t(1) << bits) < 2 * capacity) {
+      ++bits;
+    }
+    rehash(bits);
+  }
+
+  /**
+   * Return the index of the specified vari, or `none`.
+   */
+  inline std::uint32_t find(const vari* vi) const noexcept {
+    const size_t mask = buckets_.size() - 1;
+    for (size_t b = bucket(vi);; b = (b + 1) & mask) {
+      const std::uint32_t i = buckets_[b];
+      if (i == 0) {
+        return none;
+      }
+      if (keys_[i - 1] == vi) {
+        return i - 1;
+      }
+    }
+  }
+
+  /**
+   * Return the index of the specified vari, adding it if it is new.
+   */
+  inline std::uint32_t insert(vari* vi) {
+    const size_t mask = buckets_.size() - 1;
+    for (size_t b = bucket(vi);; b = (b + 1) & mask) {
+      const std::uint32_t i = buckets_[b];
+      if (i == 0) {
+        keys_.push_back(vi);
+        buckets_[b] = keys_.size();
+        if (2 * keys_.size() > buckets_.size()) {
+          rehash(bits_ + 1);
+        }
+        return keys_.size() - 1;
+      }
+      if (keys_[i - 1] == vi) {
+        return i - 1;
+      }
+    }
+  }
+
+  /**
+   * Return the varis in the order of their indices.
+   */
+  inline const std::vector<vari*>& keys() const noexcept { return keys_; }
+};
+
+/**
+ * A contiguous range of the chain stack, swept by the tasks of
+ * `grad_parallel()`.
+ *
+ * The adjoints of the outputs of the linear records of the chunk, the
+ * varis it owns, are written directly. The adjoints of all other
+ * operands, its externals, are accumulated in a private buffer and
+ * added to the varis after every phase. A record is held back to a later
+ * phase while a record of another chunk adding to its adjoint, or a
+ * record of the chunk held back itself, has not been swept. A chunk
+ * holding opaque varis is a barrier: their operands are not known, so it
+ * is swept alone, writing all adjoints directly, after every later chunk
+ * and before every earlier chunk.
+ */
+class parallel_chunk {
+ public:
+  static constexpr std::uint32_t external_bit = std::uint32_t(1) << 31;
+
+  /**
+   * A record of another chunk adding to the adjoint of an output of this
+   * chunk through one of its externals.
+   */
+  struct incoming_ref {
+    std::uint32_t chunk_;
+    std::uint32_t external_;
+    std::uint32_t record_;
+  };
+
+  compact_tape tape_{nullptr, nullptr};
+  bool barrier_{false};
+  // whether the outputs of the linear records are in increasing order,
+  // as they are allocated, or else their index
+  bool sorted_{true};
+  vari_index outputs_;
+  const vari* lo_{nullptr};
+  const vari* hi_{nullptr};
+  vari_index externals_;
+  // record owning every operand, or its external index with external_bit
+  std::vector<std::uint32_t> slots_;
+  std::vector<double> external_adj_;
+  // number of operands not yet swept of every external
+  std::vector<std::uint32_t> pending_;
+  std::vector<incoming_ref> incoming_;
+  // last phase in which every record was held back
+  std::vector<std::uint32_t> held_;
+  // records held back, from the last to the first
+  std::vector<std::uint32_t> remaining_;
+  std::vector<std::uint32_t> next_remaining_;
+  bool started_{false};
+
+  /**
+   * Linearize the specified range of the chain stack and sort the
+   * operands of the linear records into owned varis and externals.
+   *
+   * @param first Pointer to the first vari of the range
+   * @param last Pointer past the last vari of the range
+   */
+  inline void build(vari_base* const* first, vari_base* const* last) {
+    tape_.build(first, last);
+    barrier_ = tape_.num_opaque() != 0;
+    incoming_.clear();
+    remaining_.clear();
+    pending_.clear();
+    started_ = false;
+    lo_ = nullptr;
+    hi_ = nullptr;
+    const auto& records = tape_.linear_records();
+    const auto& operands = tape_.operands();
+    externals_.clear(0);
+    if (barrier_ || records.empty()) {
+      return;
+    }
+    std::less<const vari*> less;
+    sorted_ = true;
+    lo_ = hi_ = records[0].out_;
+    for (size_t i = 1; i < records.size(); ++i) {
+      sorted_ = sorted_ && less(records[i - 1].out_, records[i].out_);
+      lo_ = std::min(lo_, static_cast<const vari*>(records[i].out_), less);
+      hi_ = std::max(hi_, static_cast<const vari*>(records[i].out_), less);
+    }
+    if (!sorted_) {
+      outputs_.clear(records.size());
+      for (const auto& rec : records) {
+        outputs_.insert(rec.out_);
+      }
+    }
+    slots_.resize(operands.size());
+    for (std::uint32_t i = 0; i < records.size(); ++i) {
+      for (std::uint32_t k = records[i].begin_; k < records[i].end_; ++k) {
+        // most owned operands are outputs of the last few records
+        std::uint32_t owner = vari_index::none;
+        for (std::uint32_t j = i; j-- > 0 && j + 4 >= i;) {
+          if (records[j].out_ == operands[k]) {
+            owner = j;
+            break;
+          }
+        }
+        if (owner == vari_index::none) {
+          owner = find(operands[k]);
+        }
+        if (owner != vari_index::none) {
+          slots_[k] = owner;
+          continue;
+        }
+        const std::uint32_t e = externals_.insert(operands[k]);
+        if (e == pending_.size()) {
+          pending_.push_back(0);
+        }
+        ++pending_[e];
+        slots_[k] = e | external_bit;
+      }
+    }
+    external_adj_.resize(pending_.size());
+    held_.assign(records.size(), 0);
+  }
+
+  /**
+   * Return the index of the linear record of this chunk whose output is
+   * the specified vari, or `vari_index::none`.
+   */
+  inline std::uint32_t find(const vari* vi) const noexcept {
+    std::less<const vari*> less;
+    if (lo_ == nullptr || less(vi, lo_) || less(hi_, vi)) {
+      return vari_index::none;
+    }
+    if (!sorted_) {
+      return outputs_.find(vi);
+    }
+    const auto& records = tape_.linear_records();
+    auto it = std::lower_bound(
+        records.begin(), records.end(), vi,
+        [&less](const auto& rec, const vari* b) { return less(rec.out_, b); });
+    return it != records.end() && it->out_ == vi ? it - records.begin()
+                                                 : vari_index::none;
+  }
+
+  /**
+   * Return `true` if every linear record has been swept.
+   */
+  inline bool done() const noexcept {
+    return barrier_ || (started_ && remaining_.empty());
+  }
+
+  /**
+   * Hold back the records whose adjoints still get contributions from
+   * records of other chunks which have not been swept.
+   *
+   * @param chunks all chunks
+   * @param phase the phase about to be swept
+   */
+  inline void hold(const std::vector<parallel_chunk>& chunks,
+                   std::uint32_t phase) {
+    for (const auto& ref : incoming_) {
+      if (chunks[ref.chunk_].pending_[ref.external_] != 0) {
+        held_[ref.record_] = phase;
+      }
+    }
+  }
+
+  /**
+   * Run the reverse pass over the linear records not held back in the
+   * specified phase, accumulating the adjoints of the externals
+   * privately.
+   */
+  inline void sweep(std::uint32_t phase) {
+    std::fill(external_adj_.begin(), external_adj_.end(), 0.0);
+    next_remaining_.clear();
+    const auto& records = tape_.linear_records();
+    vari* const* operands = tape_.operands().data();
+    const double* partials = tape_.partials().data();
+    const std::uint32_t* slots = slots_.data();
+    double* external_adj = external_adj_.data();
+    auto step = [&](std::uint32_t i) {
+      const auto& rec = records[i];
+      if (held_[i] == phase) {
+        next_remaining_.push_back(i);
+        for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+          if (!(slots[k] & external_bit)) {
+            held_[slots[k]] = phase;
+          }
+        }
+        return;
+      }
+      const double adj = rec.out_->adj_;
+      for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+        if (slots[k] & external_bit) {
+          const std::uint32_t e = slots[k] & ~external_bit;
+          external_adj[e] += adj * partials[k];
+          --pending_[e];
+        } else {
+          operands[k]->adj_ += adj * partials[k];
+        }
+      }
+    };
+    if (started_) {
+      for (std::uint32_t i : remaining_) {
+        step(i);
+      }
+    } else {
+      for (size_t i = records.size(); i-- > 0;) {
+        step(i);
+      }
+      started_ = true;
+    }
+    remaining_.swap(next_remaining_);
+  }
+
+  /**
+   * Add the privately accumulated adjoints to the externals.
+   */
+  inline void flush() noexcept {
+    const auto& externals = externals_.keys();
+    for (size_t e = 0; e < externals.size(); ++e) {
+      externals[e]->adj_ += external_adj_[e];
+    }
+  }
+};
+
+/**
+ * Call the specified functor with every index below the specified
+ * number, in parallel, isolated from other work of the task arena.
+ */
+template <typename F>
+inline void parallel_for_each(size_t n, const F& f) {
+  tbb::this_task_arena::isolate([&] {
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n),
+                      [&](const tbb::blocked_range<size_t>& r) {
+                        for (size_t i = r.begin(); i < r.end(); ++i) {
+                          f(i);
+                        }
+                      });
+  });
+}
+
+}  // namespace internal
+
+/**
+ * Compute the gradient for all variables starting from the specified
+ * root variable implementation, running the reverse pass over
+ * independent parts of the tape in parallel. Gives the same result as
+ * `grad(vi)` up to rounding: the adjoint of the root is set to one and
+ * the contributions of the tape of the current nested scope (or the
+ * whole tape) are added to the adjoints of the varis.
+ *
+ * The chain stack is split into chunks of at least `grainsize` varis,
+ * which are linearized in parallel. The reverse pass then runs in
+ * phases, each sweeping the chunks in parallel. A chunk holds back a
+ * record to the next phase while a record of another chunk adding to its
+ * adjoint has not been swept, together with the records of the chunk
+ * adding to the adjoint of a record held back. Within a chunk the
+ * adjoints of operands that are not outputs of the chunk, such as the
+ * parameters shared by all terms of a likelihood, are accumulated
+ * privately and added to the varis at the end of the phase, in reverse
+ * chunk order, so the result does not depend on the number of threads.
+ * Chunks holding varis which cannot be linearized are swept alone,
+ * serially, between the phases of the later and the earlier chunks.
+ *
+ * A sum of log densities takes one phase for the chunk holding the sum,
+ * one for all terms and one for the terms split between two chunks. A
+ * long chain of dependent operations takes one phase per chunk and gains
+ * nothing. If the tape has a single chunk or the task arena a single
+ * thread, `chain()` is called on every vari in turn, as by `grad(vi)`.
+ *
+ * Linearizing and scheduling a tape of cheap scalar varis costs several
+ * serial reverse passes, so it takes as many threads to be faster than
+ * `grad(vi)`; it pays off sooner when the varis have many operands. The
+ * buffers of the chunks are kept by the calling thread for the next
+ * call, like the memory of the autodiff stack.
+ *
+ * This function does not recover any memory from the computation.
+ *
+ * @tparam Vari type of root variable implementation
+ * @param vi root of partial derivative propagation
+ * @param grainsize minimum number of varis per chunk
+ */
+template <typename Vari>
+inline void grad_parallel(Vari* vi, size_t grainsize = 4096) {
+  using internal::parallel_chunk;
+  using internal::vari_index;
+  const auto& stack = ChainableStack::instance_->var_stack_;
+  const size_t begin
+      = empty_nested()
+            ? 0
+            : ChainableStack::instance_->nested_var_stack_sizes_.back();
+  const size_t size = stack.size() - begin;
+  grainsize = std::max<size_t>(grainsize, 1);
+  const size_t num_chunks = (size + grainsize - 1) / grainsize;
+  vi->init_dependent();
+  if (num_chunks <= 1 || tbb::this_task_arena::max_concurrency() <= 1) {
+    for (size_t i = stack.size(); i-- > begin;) {
+      stack[i]->chain();
+    }
+    return;
+  }
+
+  // a reference, so that the tasks see the chunks of the calling thread
+  static thread_local std::vector<parallel_chunk> pool;
+  std::vector<parallel_chunk>& chunks = pool;
+  chunks.resize(num_chunks);
+  vari_base* const* first = stack.data() + begin;
+  internal::parallel_for_each(num_chunks, [&](size_t c) {
+    chunks[c].build(first + c * grainsize,
+                    first + std::min(size, (c + 1) * grainsize));
+  });
+
+  // the chunks sorted by their lowest output, to find the owners of
+  // externals without searching every chunk
+  std::less<const vari*> less;
+  std::vector<size_t> by_lo;
+  for (size_t c = 0; c < num_chunks; ++c) {
+    if (chunks[c].lo_ != nullptr) {
+      by_lo.push_back(c);
+    }
+  }
+  std::sort(by_lo.begin(), by_lo.end(), [&](size_t c, size_t d) {
+    return less(chunks[c].lo_, chunks[d].lo_);
+  });
+  std::vector<const vari*> max_hi(by_lo.size());
+  for (size_t j = 0; j < by_lo.size(); ++j) {
+    max_hi[j] = j == 0 ? chunks[by_lo[j]].hi_
+                       : std::max(max_hi[j - 1], chunks[by_lo[j]].hi_, less);
+  }
+  std::vector<size_t> external_begin(num_chunks + 1, 0);
+  for (size_t c = 0; c < num_chunks; ++c) {
+    external_begin[c + 1]
+        = external_begin[c] + chunks[c].externals_.keys().size();
+  }
+  std::vector<parallel_chunk::incoming_ref> owners(
+      external_begin.back(),
+      parallel_chunk::incoming_ref{0, 0, vari_index::none});
+  internal::parallel_for_each(external_begin.back(), [&](size_t x) {
+    const size_t c = std::upper_bound(external_begin.begin(),
+                                      external_begin.end(), x)
+                     - external_begin.begin() - 1;
+    const vari* op = chunks[c].externals_.keys()[x - external_begin[c]];
+    auto it = std::upper_bound(
+        by_lo.begin(), by_lo.end(), op,
+        [&](const vari* a, size_t d) { return less(a, chunks[d].lo_); });
+    for (size_t j = it - by_lo.begin(); j-- > 0 && !less(max_hi[j], op);) {
+      const size_t d = by_lo[j];
+      const std::uint32_t record
+          = d < c ? chunks[d].find(op) : vari_index::none;
+      if (record != vari_index::none) {
+        owners[x] = {static_cast<std::uint32_t>(d),
+                     static_cast<std::uint32_t>(x - external_begin[c]),
+                     record};
+        break;
+      }
+    }
+  });
+  for (size_t c = 0; c < num_chunks; ++c) {
+    for (size_t x = external_begin[c]; x < external_begin[c + 1]; ++x) {
+      if (owners[x].record_ != vari_index::none) {
+        chunks[owners[x].chunk_].incoming_.push_back(
+            {static_cast<std::uint32_t>(c), owners[x].external_,
+             owners[x].record_});
+      }
+    }
+  }
+
+  // barriers from the last to the first
+  std::vector<size_t> barriers;
+  for (size_t c = num_chunks; c-- > 0;) {
+    if (chunks[c].barrier_) {
+      barriers.push_back(c);
+    }
+  }
+  std::vector<size_t> active;
+  for (std::uint32_t phase = 1;; ++phase) {
+    active.clear();
+    for (size_t c = num_chunks; c-- > 0;) {
+      if (!barriers.empty() && c == barriers.front()) {
+        break;
+      }
+      if (!chunks[c].done()) {
+        active.push_back(c);
+      }
+    }
+    if (active.empty()) {
+      if (barriers.empty()) {
+        break;
+      }
+      chunks[barriers.front()].tape_.chain();
+      barriers.erase(barriers.begin());
+      continue;
+    }
+    internal::parallel_for_each(active.size(), [&](size_t j) {
+      chunks[active[j]].hold(chunks, phase);
+    });
+    internal::parallel_for_each(
+        active.size(), [&](size_t j) { chunks[active[j]].sweep(phase); });
+    for (size_t c : active) {
+      chunks[c].flush();
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
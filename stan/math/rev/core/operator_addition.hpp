@@ -5,6 +5,7 @@
 #include <stan/math/rev/core/var.hpp>
 #include <stan/math/prim/err/check_matching_dims.hpp>
 #include <stan/math/rev/core/callback_vari.hpp>
+#include <stan/math/rev/core/vv_vari.hpp>
 #include <stan/math/prim/fun/as_column_vector_or_scalar.hpp>
 #include <stan/math/prim/fun/as_array_or_scalar.hpp>
 #include <stan/math/prim/fun/constants.hpp>
@@ -12,6 +13,40 @@
 namespace stan {
 namespace math {
 
+namespace internal {
+class add_vv_vari final : public op_vv_vari {
+ public:
+  add_vv_vari(vari* avi, vari* bvi)
+      : op_vv_vari(avi->val_ + bvi->val_, avi, bvi) {}
+  void chain() {
+    avi_->adj_ += adj_;
+    bvi_->adj_ += adj_;
+  }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    operands.push_back(bvi_);
+    partials.push_back(1.0);
+    partials.push_back(1.0);
+    return true;
+  }
+};
+
+class add_vd_vari final : public vari {
+  vari* avi_;
+
+ public:
+  add_vd_vari(vari* avi, double b) : vari(avi->val_ + b), avi_(avi) {}
+  void chain() { avi_->adj_ += adj_; }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    partials.push_back(1.0);
+    return true;
+  }
+};
+}  // namespace internal
+
 /**
  * Addition operator for variables (C++).
  *
@@ -51,11 +86,7 @@ namespace math {
  * @return Variable result of adding two variables.
  */
 inline var operator+(const var& a, const var& b) {
-  return make_callback_vari(a.vi_->val_ + b.vi_->val_,
-                            [avi = a.vi_, bvi = b.vi_](const auto& vi) mutable {
-                              avi->adj_ += vi.adj_;
-                              bvi->adj_ += vi.adj_;
-                            });
+  return {new internal::add_vv_vari(a.vi_, b.vi_)};
 }
 
 /**
@@ -75,9 +106,7 @@ inline var operator+(const var& a, Arith b) {
   if (unlikely(b == 0.0)) {
     return a;
   }
-  return make_callback_vari(
-      a.vi_->val_ + b,
-      [avi = a.vi_](const auto& vi) mutable { avi->adj_ += vi.adj_; });
+  return {new internal::add_vd_vari(a.vi_, b)};
 }
 
 /**
@@ -12,6 +12,8 @@
 #include <stan/math/rev/core/operator_addition.hpp>
 #include <stan/math/rev/core/operator_multiplication.hpp>
 #include <stan/math/rev/core/operator_subtraction.hpp>
+#include <stan/math/rev/core/precomp_v_vari.hpp>
+#include <stan/math/rev/core/precomp_vv_vari.hpp>
 #include <stan/math/rev/fun/to_arena.hpp>
 #include <stan/math/rev/fun/value_of.hpp>
 #include <complex>
@@ -59,12 +61,9 @@ namespace math {
  * second.
  */
 inline var operator/(const var& dividend, const var& divisor) {
-  return make_callback_var(
-      dividend.val() / divisor.val(), [dividend, divisor](auto&& vi) {
-        dividend.adj() += vi.adj() / divisor.val();
-        divisor.adj()
-            -= vi.adj() * dividend.val() / (divisor.val() * divisor.val());
-      });
+  const double b = divisor.val();
+  return var(new precomp_vv_vari(dividend.val() / b, dividend.vi_, divisor.vi_,
+                                 1.0 / b, -dividend.val() / (b * b)));
 }
 
 /**
@@ -85,9 +84,8 @@ inline var operator/(const var& dividend, Arith divisor) {
   if (divisor == 1.0) {
     return dividend;
   }
-  return make_callback_var(
-      dividend.val() / divisor,
-      [dividend, divisor](auto&& vi) { dividend.adj() += vi.adj() / divisor; });
+  return var(new precomp_v_vari(dividend.val() / divisor, dividend.vi_,
+                                1.0 / static_cast<double>(divisor)));
 }
 
 /**
@@ -104,10 +102,9 @@ inline var operator/(const var& dividend, Arith divisor) {
  */
 template <typename Arith, require_arithmetic_t<Arith>* = nullptr>
 inline var operator/(Arith dividend, const var& divisor) {
-  return make_callback_var(
-      dividend / divisor.val(), [dividend, divisor](auto&& vi) {
-        divisor.adj() -= vi.adj() * dividend / (divisor.val() * divisor.val());
-      });
+  const double b = divisor.val();
+  return var(new precomp_v_vari(dividend / b, divisor.vi_,
+                                -static_cast<double>(dividend) / (b * b)));
 }
 
 /**
@@ -27,12 +27,26 @@ class multiply_vv_vari final : public op_vv_vari {
     avi_->adj_ += bvi_->val_ * adj_;
     bvi_->adj_ += avi_->val_ * adj_;
   }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    operands.push_back(bvi_);
+    partials.push_back(bvi_->val_);
+    partials.push_back(avi_->val_);
+    return true;
+  }
 };
 
 class multiply_vd_vari final : public op_vd_vari {
  public:
   multiply_vd_vari(vari* avi, double b) : op_vd_vari(avi->val_ * b, avi, b) {}
   void chain() { avi_->adj_ += adj_ * bd_; }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    partials.push_back(bd_);
+    return true;
+  }
 };
 }  // namespace internal
 
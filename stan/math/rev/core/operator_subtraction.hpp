@@ -5,6 +5,7 @@
 #include <stan/math/rev/core/var.hpp>
 #include <stan/math/rev/core/arena_matrix.hpp>
 #include <stan/math/rev/core/callback_vari.hpp>
+#include <stan/math/rev/core/vv_vari.hpp>
 #include <stan/math/prim/fun/as_column_vector_or_scalar.hpp>
 #include <stan/math/prim/fun/as_array_or_scalar.hpp>
 #include <stan/math/prim/fun/constants.hpp>
@@ -13,6 +14,54 @@
 namespace stan {
 namespace math {
 
+namespace internal {
+class subtract_vv_vari final : public op_vv_vari {
+ public:
+  subtract_vv_vari(vari* avi, vari* bvi)
+      : op_vv_vari(avi->val_ - bvi->val_, avi, bvi) {}
+  void chain() {
+    avi_->adj_ += adj_;
+    bvi_->adj_ -= adj_;
+  }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    operands.push_back(bvi_);
+    partials.push_back(1.0);
+    partials.push_back(-1.0);
+    return true;
+  }
+};
+
+class subtract_vd_vari final : public vari {
+  vari* avi_;
+
+ public:
+  subtract_vd_vari(vari* avi, double b) : vari(avi->val_ - b), avi_(avi) {}
+  void chain() { avi_->adj_ += adj_; }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    partials.push_back(1.0);
+    return true;
+  }
+};
+
+class subtract_dv_vari final : public vari {
+  vari* bvi_;
+
+ public:
+  subtract_dv_vari(double a, vari* bvi) : vari(a - bvi->val_), bvi_(bvi) {}
+  void chain() { bvi_->adj_ -= adj_; }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(bvi_);
+    partials.push_back(-1.0);
+    return true;
+  }
+};
+}  // namespace internal
+
 /**
  * Subtraction operator for variables.
  *
@@ -54,11 +103,7 @@ namespace math {
  * the first.
  */
 inline var operator-(const var& a, const var& b) {
-  return make_callback_vari(a.vi_->val_ - b.vi_->val_,
-                            [avi = a.vi_, bvi = b.vi_](const auto& vi) mutable {
-                              avi->adj_ += vi.adj_;
-                              bvi->adj_ -= vi.adj_;
-                            });
+  return {new internal::subtract_vv_vari(a.vi_, b.vi_)};
 }
 
 /**
@@ -79,9 +124,7 @@ inline var operator-(const var& a, Arith b) {
   if (unlikely(b == 0.0)) {
     return a;
   }
-  return make_callback_vari(
-      a.vi_->val_ - b,
-      [avi = a.vi_](const auto& vi) mutable { avi->adj_ += vi.adj_; });
+  return {new internal::subtract_vd_vari(a.vi_, b)};
 }
 
 /**
@@ -99,9 +142,7 @@ inline var operator-(const var& a, Arith b) {
  */
 template <typename Arith, require_arithmetic_t<Arith>* = nullptr>
 inline var operator-(Arith a, const var& b) {
-  return make_callback_vari(
-      a - b.vi_->val_,
-      [bvi = b.vi_](const auto& vi) mutable { bvi->adj_ -= vi.adj_; });
+  return {new internal::subtract_dv_vari(a, b.vi_)};
 }
 
 /**
@@ -4,6 +4,7 @@
 #include <stan/math/prim/meta.hpp>
 #include <stan/math/rev/core/var.hpp>
 #include <stan/math/rev/core/callback_vari.hpp>
+#include <stan/math/rev/core/precomp_v_vari.hpp>
 #include <stan/math/prim/fun/constants.hpp>
 #include <stan/math/prim/fun/is_nan.hpp>
 
@@ -35,8 +36,7 @@ namespace math {
  * @return Negation of variable.
  */
 inline var operator-(const var& a) {
-  return make_callback_var(
-      -a.val(), [a](const auto& vi) mutable { a.adj() -= vi.adj(); });
+  return var(new precomp_v_vari(-a.val(), a.vi_, -1.0));
 }
 
 /**
@@ -0,0 +1,238 @@
+#ifndef STAN_MATH_REV_CORE_PERF_COUNTERS_HPP
+#define STAN_MATH_REV_CORE_PERF_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace stan {
+namespace math {
+
+/**
+ * Hardware event counts of the current thread, as read from the Linux
+ * `perf_event_open` interface. Counts of events which the hardware or
+ * the kernel do not provide are zero.
+ */
+struct perf_counts {
+  /**
+   * CPU cycles.
+   */
+  uint64_t cycles_{0};
+  /**
+   * Retired instructions.
+   */
+  uint64_t instructions_{0};
+  /**
+   * Last level cache misses.
+   */
+  uint64_t cache_misses_{0};
+  /**
+   * Mispredicted branches.
+   */
+  uint64_t branch_misses_{0};
+
+  inline perf_counts& operator+=(const perf_counts& other) noexcept {
+    cycles_ += other.cycles_;
+    instructions_ += other.instructions_;
+    cache_misses_ += other.cache_misses_;
+    branch_misses_ += other.branch_misses_;
+    return *this;
+  }
+
+  /**
+   * Return the counts from `begin` to this reading. Counters are
+   * monotonic, but multiplexed counters are scaled estimates, so
+   * differences are clamped at zero.
+   *
+   * @param begin reading at the beginning of the region
+   */
+  inline perf_counts since(const perf_counts& begin) const noexcept {
+    auto diff = [](uint64_t end, uint64_t start) {
+      return end > start ? end - start : 0;
+    };
+    perf_counts d;
+    d.cycles_ = diff(cycles_, begin.cycles_);
+    d.instructions_ = diff(instructions_, begin.instructions_);
+    d.cache_misses_ = diff(cache_misses_, begin.cache_misses_);
+    d.branch_misses_ = diff(branch_misses_, begin.branch_misses_);
+    return d;
+  }
+
+  /**
+   * Return the instructions per cycle, or zero if no cycle was counted.
+   */
+  inline double ipc() const noexcept {
+    return cycles_ == 0 ? 0.0 : static_cast<double>(instructions_) / cycles_;
+  }
+
+  /**
+   * Return the last level cache misses per thousand instructions, or
+   * zero if no instruction was counted.
+   */
+  inline double cache_misses_per_kilo_instruction() const noexcept {
+    return instructions_ == 0
+               ? 0.0
+               : 1000.0 * static_cast<double>(cache_misses_) / instructions_;
+  }
+
+  /**
+   * Return the mispredicted branches per thousand instructions, or zero
+   * if no instruction was counted.
+   */
+  inline double branch_misses_per_kilo_instruction() const noexcept {
+    return instructions_ == 0
+               ? 0.0
+               : 1000.0 * static_cast<double>(branch_misses_) / instructions_;
+  }
+};
+
+namespace internal {
+
+/**
+ * Hardware counters of the current thread. The counters are opened
+ * when the group is constructed; counters which cannot be opened, for
+ * example because `perf_event_paranoid` forbids it, in a container
+ * without access to the PMU, or on a platform other than Linux, are
+ * skipped and read as zero.
+ */
+class perf_counter_group {
+  static constexpr size_t NUM_COUNTERS = 4;
+  std::array<int, NUM_COUNTERS> fds_;
+
+#ifdef __linux__
+  static inline int open_counter(uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format
+        = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  /**
+   * Return the count of the counter, scaled up if the kernel
+   * multiplexed it with other counters.
+   */
+  static inline uint64_t read_counter(int fd) {
+    uint64_t values[3];
+    if (fd < 0
+        || ::read(fd, values, sizeof(values))
+               != static_cast<ssize_t>(sizeof(values))
+        || values[2] == 0) {
+      return 0;
+    }
+    if (values[2] == values[1]) {
+      return values[0];
+    }
+    return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1]
+                                 / values[2]);
+  }
+#endif
+
+ public:
+  perf_counter_group() {
+    fds_.fill(-1);
+#ifdef __linux__
+    fds_[0] = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+    fds_[1] = open_counter(PERF_COUNT_HW_INSTRUCTIONS);
+    fds_[2] = open_counter(PERF_COUNT_HW_CACHE_MISSES);
+    fds_[3] = open_counter(PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+  }
+
+  perf_counter_group(const perf_counter_group&) = delete;
+  perf_counter_group& operator=(const perf_counter_group&) = delete;
+
+  ~perf_counter_group() {
+#ifdef __linux__
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  /**
+   * Return true if the cycle and instruction counters are open.
+   */
+  inline bool available() const noexcept {
+    return fds_[0] >= 0 && fds_[1] >= 0;
+  }
+
+  /**
+   * Return the current counts of the thread.
+   */
+  inline perf_counts read() const {
+    perf_counts counts;
+#ifdef __linux__
+    counts.cycles_ = read_counter(fds_[0]);
+    counts.instructions_ = read_counter(fds_[1]);
+    counts.cache_misses_ = read_counter(fds_[2]);
+    counts.branch_misses_ = read_counter(fds_[3]);
+#endif
+    return counts;
+  }
+};
+
+/**
+ * Return the hardware counters of the current thread, opening them on
+ * the first call.
+ */
+inline perf_counter_group& local_perf_counters() {
+  static thread_local perf_counter_group counters;
+  return counters;
+}
+
+inline std::atomic<bool>& profile_perf_counters_flag() {
+  static std::atomic<bool> enabled{false};
+  return enabled;
+}
+
+}  // namespace internal
+
+/**
+ * Return true if the cycle and instruction counters can be read on the
+ * current thread.
+ */
+inline bool perf_counters_available() {
+  return internal::local_perf_counters().available();
+}
+
+/**
+ * Set whether profiles read the hardware counters at the start and stop
+ * of their forward and reverse passes. Off by default, since each
+ * reading takes a few system calls. Where the counters are not
+ * available the counts of the profiles stay zero.
+ *
+ * @param enable true if profiles read the counters
+ */
+inline void set_profile_perf_counters(bool enable) {
+  internal::profile_perf_counters_flag().store(enable,
+                                               std::memory_order_relaxed);
+}
+
+/**
+ * Return true if profiles read the hardware counters.
+ */
+inline bool profile_perf_counters() {
+  return internal::profile_perf_counters_flag().load(
+      std::memory_order_relaxed);
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -0,0 +1,124 @@
+#ifndef STAN_MATH_REV_CORE_POOLED_CHAINABLESTACK_HPP
+#define STAN_MATH_REV_CORE_POOLED_CHAINABLESTACK_HPP
+
+#include <stan/math/rev/core/empty_nested.hpp>
+#include <stan/math/rev/core/recover_memory.hpp>
+#include <stan/math/rev/core/scoped_chainablestack.hpp>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+namespace internal {
+/**
+ * Process wide pool of AD tapes which are not in use. The tapes keep
+ * their arena memory, so taking a tape from the pool does not allocate
+ * once the pool is warm.
+ */
+struct chainablestack_pool {
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ScopedChainableStack>> stacks_;
+};
+
+inline chainablestack_pool& get_chainablestack_pool() {
+  static chainablestack_pool pool;
+  return pool;
+}
+}  // namespace internal
+
+/**
+ * A `ScopedChainableStack` which is taken from a process wide pool on
+ * construction and returned to it on destruction. The memory of the
+ * AD tape is recovered, but not freed, before the tape is returned to
+ * the pool, so the arena of the tape is reused by the next
+ * `pooled_chainablestack`, possibly on a different thread. Example:
+ *
+ * pooled_chainablestack scoped_stack;
+ *
+ * double cgrad_a = scoped_stack.execute([] {
+ *   var a = 2.0;
+ *   var b = 4.0;
+ *   var c = a*a + b;
+ *   c.grad();
+ *   return a.adj();
+ * });
+ *
+ * Any variables created on the tape must not be used once the
+ * `pooled_chainablestack` has been destroyed.
+ */
+class pooled_chainablestack {
+  std::unique_ptr<ScopedChainableStack> stack_;
+
+ public:
+  pooled_chainablestack() {
+    auto& pool = internal::get_chainablestack_pool();
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex_);
+      if (!pool.stacks_.empty()) {
+        stack_ = std::move(pool.stacks_.back());
+        pool.stacks_.pop_back();
+      }
+    }
+    if (!stack_) {
+      stack_ = std::make_unique<ScopedChainableStack>();
+    }
+  }
+
+  /**
+   * Recover the memory of the AD tape and return it to the pool. A tape
+   * with an open nested scope is freed instead.
+   */
+  ~pooled_chainablestack() {
+    if (!stack_) {
+      return;
+    }
+    const bool recovered = stack_->execute([] {
+      if (!empty_nested()) {
+        return false;
+      }
+      recover_memory();
+      return true;
+    });
+    if (recovered) {
+      auto& pool = internal::get_chainablestack_pool();
+      std::lock_guard<std::mutex> lock(pool.mutex_);
+      pool.stacks_.push_back(std::move(stack_));
+    }
+  }
+
+  pooled_chainablestack(pooled_chainablestack&&) = default;
+  pooled_chainablestack& operator=(pooled_chainablestack&&) = delete;
+  pooled_chainablestack(const pooled_chainablestack&) = delete;
+  pooled_chainablestack& operator=(const pooled_chainablestack&) = delete;
+
+  /**
+   * Execute in the current thread a function and write the AD
+   * tape to the pooled tape. The function may return any type.
+   *
+   * @tparam F functor to evaluate
+   * @param f instance of functor
+   * @param args arguments passed to functor
+   * @return Result of evaluated functor
+   */
+  template <typename F, typename... Args>
+  decltype(auto) execute(F&& f, Args&&... args) {
+    return stack_->execute(std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  /**
+   * Return the number of tapes in the pool which are not in use.
+   */
+  static inline size_t pool_size() {
+    auto& pool = internal::get_chainablestack_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex_);
+    return pool.stacks_.size();
+  }
+};
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -20,6 +20,14 @@ class precomp_vv_vari final : public op_vv_vari {
     avi_->adj_ += adj_ * da_;
     bvi_->adj_ += adj_ * db_;
   }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    operands.push_back(bvi_);
+    partials.push_back(da_);
+    partials.push_back(db_);
+    return true;
+  }
 };
 
 }  // namespace math
@@ -23,6 +23,16 @@ class precomp_vvv_vari final : public op_vvv_vari {
     bvi_->adj_ += adj_ * db_;
     cvi_->adj_ += adj_ * dc_;
   }
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.push_back(avi_);
+    operands.push_back(bvi_);
+    operands.push_back(cvi_);
+    partials.push_back(da_);
+    partials.push_back(db_);
+    partials.push_back(dc_);
+    return true;
+  }
 };
 
 }  // namespace math
@@ -7,6 +7,7 @@
 #include <stan/math/rev/fun/dims.hpp>
 #include <stan/math/rev/fun/to_arena.hpp>
 #include <algorithm>
+#include <typeinfo>
 #include <vector>
 #include <tuple>
 
@@ -155,6 +156,36 @@ class precomputed_gradients_vari_template : public vari {
     });
   }
 
+  /**
+   * Describe the reverse pass through the scalar operands and the
+   * prestored gradients. Variables with container operands and derived
+   * classes are run through `chain()`.
+   */
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    if (N_containers != 0
+        || typeid(*this) != typeid(precomputed_gradients_vari_template)) {
+      return false;
+    }
+    operands.insert(operands.end(), varis_, varis_ + size_);
+    partials.insert(partials.end(), gradients_, gradients_ + size_);
+    return true;
+  }
+
+  /**
+   * Return the number of adjoints of this variable, the scalar operands
+   * and the elements of the container operands.
+   */
+  size_t num_adjoints() const {
+    return index_apply<N_containers>([this](auto... Is) {
+      size_t num = 1 + this->size_;
+      static_cast<void>(std::initializer_list<int>{
+          (num += num_adjoints_one(std::get<Is>(this->container_operands_)),
+           0)...});
+      return num;
+    });
+  }
+
  private:
   /**
    * Implements the chain rule for one non-`std::vector` operand.
@@ -166,7 +197,7 @@ class precomputed_gradients_vari_template : public vari {
   template <typename Op, typename Grad,
             require_all_not_std_vector_t<Op, Grad>* = nullptr>
   void chain_one(Op& op, const Grad& grad) {
-    op.vi_->adj_ = op.vi_->adj_ + this->adj_ * grad;
+    op.vi_->adj_ += this->adj_ * grad;
   }
 
   /**
@@ -183,6 +214,31 @@ class precomputed_gradients_vari_template : public vari {
       chain_one(op[i], grad[i]);
     }
   }
+
+  /**
+   * Return the number of elements of one non-`std::vector` operand.
+   * @tparam Op type of the operand
+   * @param op operand
+   */
+  template <typename Op, require_not_std_vector_t<Op>* = nullptr>
+  static size_t num_adjoints_one(const Op& op) {
+    return op.size();
+  }
+
+  /**
+   * Return the number of elements of one `std::vector` operand.
+   * @tparam Op type of the operand element
+   * @tparam OpAlloc type of the operand allocator
+   * @param op operand
+   */
+  template <typename Op, typename OpAlloc>
+  static size_t num_adjoints_one(const std::vector<Op, OpAlloc>& op) {
+    size_t num = 0;
+    for (const auto& x : op) {
+      num += num_adjoints_one(x);
+    }
+    return num;
+  }
 };
 
 using precomputed_gradients_vari
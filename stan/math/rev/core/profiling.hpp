@@ -3,24 +3,238 @@
 
 #include <stan/math/prim/fun/Eigen.hpp>
 #include <stan/math/prim/fun/typedefs.hpp>
+#include <stan/math/rev/core/perf_counters.hpp>
 #include <stan/math/rev/core/var.hpp>
 #include <stan/math/rev/meta.hpp>
 #include <stan/math/rev/fun/value_of.hpp>
 #include <stan/math/prim/err.hpp>
+#include <stan/math/prim/core/trace_events.hpp>
 #include <tbb/concurrent_unordered_map.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
 #include <iostream>
-#include <sstream>
+#include <map>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace stan {
 namespace math {
 
+/**
+ * Histogram of durations with logarithmically spaced buckets, four per
+ * doubling of the duration, from one nanosecond up to about 18 minutes.
+ * Quantiles are resolved to within about 19% of the duration.
+ */
+class latency_histogram {
+ public:
+  static constexpr size_t BUCKETS_PER_DOUBLING = 4;
+  static constexpr size_t NUM_BUCKETS = 40 * BUCKETS_PER_DOUBLING;
+
+ private:
+  std::array<size_t, NUM_BUCKETS> counts_{};
+  size_t total_{0};
+
+ public:
+  /**
+   * Return the bucket holding the specified duration.
+   *
+   * @param seconds duration in seconds
+   */
+  static inline size_t bucket(double seconds) noexcept {
+    const double ns = seconds * 1e9;
+    if (!(ns > 1.0)) {
+      return 0;
+    }
+    const double b = std::log2(ns) * BUCKETS_PER_DOUBLING;
+    return b >= NUM_BUCKETS - 1 ? NUM_BUCKETS - 1 : static_cast<size_t>(b);
+  }
+
+  /**
+   * Return the upper bound of the specified bucket in seconds.
+   *
+   * @param b bucket
+   */
+  static inline double bucket_upper(size_t b) noexcept {
+    return std::exp2(static_cast<double>(b + 1) / BUCKETS_PER_DOUBLING)
+           * 1e-9;
+  }
+
+  /**
+   * Add a duration to the histogram.
+   *
+   * @param seconds duration in seconds
+   */
+  inline void add(double seconds) noexcept {
+    ++counts_[bucket(seconds)];
+    ++total_;
+  }
+
+  /**
+   * Return the number of durations added.
+   */
+  inline size_t count() const noexcept { return total_; }
+
+  /**
+   * Return the number of durations in every bucket.
+   */
+  inline const std::array<size_t, NUM_BUCKETS>& counts() const noexcept {
+    return counts_;
+  }
+
+  /**
+   * Return an upper bound of the `q` quantile of the durations, that is
+   * the upper bound of the bucket holding the duration of rank
+   * `ceil(q * count())`, or 0 if the histogram is empty.
+   *
+   * @param q quantile between 0 and 1
+   * @return quantile in seconds
+   */
+  inline double quantile(double q) const noexcept {
+    if (total_ == 0) {
+      return 0.0;
+    }
+    const double rank = std::ceil(q * total_);
+    const size_t target = rank < 1.0 ? 1 : static_cast<size_t>(rank);
+    size_t seen = 0;
+    for (size_t b = 0; b < NUM_BUCKETS; ++b) {
+      seen += counts_[b];
+      if (seen >= target) {
+        return bucket_upper(b);
+      }
+    }
+    return bucket_upper(NUM_BUCKETS - 1);
+  }
+};
+
+/**
+ * Timings of a profile at one call path, that is one node of the call
+ * tree of the profiles of a map on a thread. The node of a profile
+ * started while other profiles of the same map are active on the same
+ * thread is keyed by the path of names of those profiles and the name of
+ * the profile, so a profile used from several places has one node per
+ * place. The time spent in the child nodes is subtracted from the
+ * inclusive time to give the self time.
+ */
+class profile_call_info {
+ private:
+  std::vector<std::string> path_;
+  double fwd_pass_time_{0.0};
+  double rev_pass_time_{0.0};
+  double child_fwd_pass_time_{0.0};
+  double child_rev_pass_time_{0.0};
+  size_t n_fwd_passes_{0};
+  size_t n_rev_passes_{0};
+  std::chrono::time_point<std::chrono::steady_clock> fwd_pass_tp_;
+  std::chrono::time_point<std::chrono::steady_clock> rev_pass_tp_;
+
+ public:
+  profile_call_info() = default;
+
+  /**
+   * Construct the node of the specified call path.
+   *
+   * @param path names of the profiles from the root of the call tree to
+   * this profile
+   */
+  explicit profile_call_info(std::vector<std::string> path)
+      : path_(std::move(path)) {}
+
+  void fwd_pass_start() noexcept {
+    fwd_pass_tp_ = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Stop the forward pass.
+   *
+   * @return duration of the forward pass in seconds
+   */
+  double fwd_pass_stop() noexcept {
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - fwd_pass_tp_)
+                               .count();
+    fwd_pass_time_ += elapsed;
+    ++n_fwd_passes_;
+    return elapsed;
+  }
+
+  void rev_pass_start() noexcept {
+    rev_pass_tp_ = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Stop the reverse pass.
+   *
+   * @return duration of the reverse pass in seconds
+   */
+  double rev_pass_stop() noexcept {
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - rev_pass_tp_)
+                               .count();
+    rev_pass_time_ += elapsed;
+    ++n_rev_passes_;
+    return elapsed;
+  }
+
+  void add_child_fwd_time(double seconds) noexcept {
+    child_fwd_pass_time_ += seconds;
+  }
+
+  void add_child_rev_time(double seconds) noexcept {
+    child_rev_pass_time_ += seconds;
+  }
+
+  /**
+   * Return the names of the profiles from the root of the call tree to
+   * this profile.
+   */
+  const std::vector<std::string>& get_path() const noexcept { return path_; }
+
+  size_t get_num_fwd_passes() const noexcept { return n_fwd_passes_; }
+
+  size_t get_num_rev_passes() const noexcept { return n_rev_passes_; }
+
+  double get_fwd_time() const noexcept { return fwd_pass_time_; }
+
+  double get_rev_time() const noexcept { return rev_pass_time_; }
+
+  /**
+   * Return the time of the forward passes not spent in child profiles.
+   */
+  double get_fwd_self_time() const noexcept {
+    return fwd_pass_time_ - child_fwd_pass_time_;
+  }
+
+  /**
+   * Return the time of the reverse passes not spent in child profiles.
+   */
+  double get_rev_self_time() const noexcept {
+    return rev_pass_time_ - child_rev_pass_time_;
+  }
+};
+
 /**
  * Class used for storing profiling information.
+ *
+ * The totals are kept per name over all the call paths of the profile,
+ * and the timings of every call path are kept as the nodes of the call
+ * tree in `get_calls()`. A profile may be started again while it is
+ * active on the same thread, as in recursive code, in which case only
+ * the outermost pass is counted in the totals.
+ *
+ * If `set_profile_perf_counters(true)` was called, the hardware counters
+ * of the thread are read at the start and stop of every pass, so the
+ * cycles, instructions, cache misses and branch misses of the forward
+ * and reverse passes are summed as well. Work done on other threads,
+ * such as the tasks of `reduce_sum`, is not counted.
  */
 class profile_info {
  private:
-  bool active_;
+  size_t depth_{0};
+  size_t rev_depth_{0};
 
   double fwd_pass_time_;
   double rev_pass_time_;
@@ -29,41 +243,89 @@ class profile_info {
   size_t n_rev_passes_;
   size_t chain_stack_size_sum_;
   size_t nochain_stack_size_sum_;
-  std::chrono::time_point<std::chrono::steady_clock> fwd_pass_tp_;
-  std::chrono::time_point<std::chrono::steady_clock> rev_pass_tp_;
   size_t start_chain_stack_size_;
   size_t start_nochain_stack_size_;
+  size_t arena_bytes_sum_{0};
+  size_t start_arena_bytes_{0};
+  std::map<std::vector<std::string>, profile_call_info> calls_;
+  latency_histogram fwd_pass_hist_;
+  latency_histogram rev_pass_hist_;
+  bool fwd_counted_{false};
+  bool rev_counted_{false};
+  perf_counts fwd_pass_start_counts_;
+  perf_counts rev_pass_start_counts_;
+  perf_counts fwd_pass_counts_;
+  perf_counts rev_pass_counts_;
 
  public:
   profile_info()
-      : active_(false),
-        fwd_pass_time_(0.0),
+      : fwd_pass_time_(0.0),
         rev_pass_time_(0.0),
         n_fwd_AD_passes_(0),
         n_fwd_no_AD_passes_(0),
         n_rev_passes_(0),
         chain_stack_size_sum_(0),
         nochain_stack_size_sum_(0),
-        fwd_pass_tp_(std::chrono::steady_clock::now()),
-        rev_pass_tp_(std::chrono::steady_clock::now()),
         start_chain_stack_size_(0),
         start_nochain_stack_size_(0) {}
 
-  bool is_active() const noexcept { return active_; }
+  bool is_active() const noexcept { return depth_ > 0; }
+
+  /**
+   * Return the node of the call tree of this profile when started with
+   * the specified enclosing profiles, creating it if needed.
+   *
+   * @param parent_path names of the enclosing profiles from the root of
+   * the call tree, empty for a root
+   * @param name name of this profile
+   */
+  profile_call_info& call(const std::vector<std::string>& parent_path,
+                          const std::string& name) {
+    auto it = calls_.find(parent_path);
+    if (it == calls_.end()) {
+      std::vector<std::string> path(parent_path);
+      path.push_back(name);
+      it = calls_.emplace(parent_path, profile_call_info(std::move(path)))
+               .first;
+    }
+    return it->second;
+  }
 
+  /**
+   * Start the profile of the forward pass, unless it is started already.
+   */
   template <typename T>
   void fwd_pass_start() {
+    if (depth_++ > 0) {
+      return;
+    }
     if (!is_constant<T>::value) {
       start_chain_stack_size_ = ChainableStack::instance_->var_stack_.size();
       start_nochain_stack_size_
           = ChainableStack::instance_->var_nochain_stack_.size();
     }
-    fwd_pass_tp_ = std::chrono::steady_clock::now();
-    active_ = true;
+    start_arena_bytes_ = ChainableStack::instance_->memalloc_.bytes_used();
+    fwd_counted_ = profile_perf_counters();
+    if (fwd_counted_) {
+      fwd_pass_start_counts_ = internal::local_perf_counters().read();
+    }
   }
 
+  /**
+   * Stop the profile of the forward pass, unless this is the end of a
+   * pass started while the profile was active already.
+   *
+   * @param elapsed duration of the forward pass in seconds
+   */
   template <typename T>
-  void fwd_pass_stop() {
+  void fwd_pass_stop(double elapsed) {
+    if (--depth_ > 0) {
+      return;
+    }
+    if (fwd_counted_) {
+      fwd_pass_counts_ += internal::local_perf_counters().read().since(
+          fwd_pass_start_counts_);
+    }
     if (!is_constant<T>::value) {
       n_fwd_AD_passes_++;
       chain_stack_size_sum_ += (ChainableStack::instance_->var_stack_.size()
@@ -74,18 +336,45 @@ class profile_info {
     } else {
       n_fwd_no_AD_passes_++;
     }
-    fwd_pass_time_ += std::chrono::duration<double>(
-                          std::chrono::steady_clock::now() - fwd_pass_tp_)
-                          .count();
-    active_ = false;
+    const size_t arena_bytes
+        = ChainableStack::instance_->memalloc_.bytes_used();
+    if (arena_bytes > start_arena_bytes_) {
+      arena_bytes_sum_ += arena_bytes - start_arena_bytes_;
+    }
+    fwd_pass_time_ += elapsed;
+    fwd_pass_hist_.add(elapsed);
   }
 
-  void rev_pass_start() { rev_pass_tp_ = std::chrono::steady_clock::now(); }
+  /**
+   * Start the profile of the reverse pass, unless it is started already.
+   */
+  void rev_pass_start() {
+    if (rev_depth_++ > 0) {
+      return;
+    }
+    rev_counted_ = profile_perf_counters();
+    if (rev_counted_) {
+      rev_pass_start_counts_ = internal::local_perf_counters().read();
+    }
+  }
 
-  void rev_pass_stop() {
-    rev_pass_time_ += std::chrono::duration<double>(
-                          std::chrono::steady_clock::now() - rev_pass_tp_)
-                          .count();
+  /**
+   * Stop the profile of the reverse pass, unless this is the end of a
+   * pass started while the profile was active already.
+   *
+   * @param elapsed duration of the reverse pass in seconds
+   */
+  void rev_pass_stop(double elapsed) {
+    if (rev_depth_ > 0 && --rev_depth_ > 0) {
+      return;
+    }
+    if (rev_counted_) {
+      rev_pass_counts_ += internal::local_perf_counters().read().since(
+          rev_pass_start_counts_);
+      rev_counted_ = false;
+    }
+    rev_pass_time_ += elapsed;
+    rev_pass_hist_.add(elapsed);
     n_rev_passes_++;
   }
 
@@ -112,6 +401,93 @@ class profile_info {
   size_t get_num_rev_passes() const noexcept { return n_rev_passes_; }
 
   double get_rev_time() const noexcept { return rev_pass_time_; }
+
+  /**
+   * Return the nodes of the call tree of this profile, keyed by the
+   * names of the enclosing profiles from the root of the call tree.
+   */
+  const std::map<std::vector<std::string>, profile_call_info>& get_calls()
+      const noexcept {
+    return calls_;
+  }
+
+  /**
+   * Return the time of the forward passes not spent in child profiles,
+   * summed over all the call paths.
+   */
+  double get_fwd_self_time() const noexcept {
+    double self_time = 0.0;
+    for (const auto& call : calls_) {
+      self_time += call.second.get_fwd_self_time();
+    }
+    return self_time;
+  }
+
+  /**
+   * Return the time of the reverse passes not spent in child profiles,
+   * summed over all the call paths.
+   */
+  double get_rev_self_time() const noexcept {
+    double self_time = 0.0;
+    for (const auto& call : calls_) {
+      self_time += call.second.get_rev_self_time();
+    }
+    return self_time;
+  }
+
+  /**
+   * Return the number of bytes allocated on the AD arena in the forward
+   * passes, including the bytes of child profiles.
+   */
+  size_t get_arena_bytes_used() const noexcept { return arena_bytes_sum_; }
+
+  /**
+   * Return an upper bound of the `q` quantile of the durations of the
+   * forward passes.
+   *
+   * @param q quantile between 0 and 1
+   */
+  double get_fwd_time_quantile(double q) const noexcept {
+    return fwd_pass_hist_.quantile(q);
+  }
+
+  /**
+   * Return an upper bound of the `q` quantile of the durations of the
+   * reverse passes.
+   *
+   * @param q quantile between 0 and 1
+   */
+  double get_rev_time_quantile(double q) const noexcept {
+    return rev_pass_hist_.quantile(q);
+  }
+
+  const latency_histogram& get_fwd_time_histogram() const noexcept {
+    return fwd_pass_hist_;
+  }
+
+  const latency_histogram& get_rev_time_histogram() const noexcept {
+    return rev_pass_hist_;
+  }
+
+  /**
+   * Return the hardware event counts of the forward passes, including
+   * the counts of child profiles. All counts are zero unless
+   * `set_profile_perf_counters(true)` was called and the counters are
+   * available.
+   */
+  const perf_counts& get_fwd_perf_counts() const noexcept {
+    return fwd_pass_counts_;
+  }
+
+  /**
+   * Return the hardware event counts of the reverse passes, including
+   * the counts of child profiles. All counts are zero unless
+   * `set_profile_perf_counters(true)` was called and the counters are
+   * available.
+   */
+  const perf_counts& get_rev_perf_counts() const noexcept {
+    return rev_pass_counts_;
+  }
 };
 
 using profile_key = std::pair<std::string, std::thread::id>;
@@ -135,6 +511,24 @@ using profile_map = tbb::concurrent_unordered_map<profile_key, profile_info,
                                                   internal::hash_profile_key,
                                                   internal::equal_profile_key>;
 
+namespace internal {
+/**
+ * A profile which is active on the current thread.
+ */
+struct active_profile {
+  const profile_map* profiles_;
+  profile_call_info* call_;
+};
+
+/**
+ * Return the profiles active on the current thread, innermost last.
+ */
+inline std::vector<active_profile>& active_profiles() {
+  static thread_local std::vector<active_profile> active;
+  return active;
+}
+}  // namespace internal
+
 /**
  * Profiles C++ lines where the object is in scope.
  * When T is var, the constructor starts the profile for the forward pass
@@ -144,6 +538,15 @@ using profile_map = tbb::concurrent_unordered_map<profile_key, profile_info,
  * When T is not var, the constructor and destructor only profile the
  *
  *
+ * A profile constructed while other profiles of the same map are in
+ * scope on the same thread is a node of the call tree below them. A
+ * profile may be constructed again while it is in scope.
+ *
+ * While a trace is recorded with `start_trace()`, the forward pass and
+ * the reverse pass of the profile are recorded as regions of the
+ * timeline of the thread. The reverse pass is recorded if and only if
+ * the forward pass was, and the trace was not restarted in between.
+ *
  * @tparam T type of profile class. If var, the created object is used
  * to profile reverse mode AD. Only profiles the forward pass otherwise.
  */
@@ -151,6 +554,10 @@ template <typename T>
 class profile {
   profile_key key_;
   profile_info* profile_;
+  profile_call_info* call_;
+  profile_call_info* parent_{nullptr};
+  const std::string* name_;
+  std::uint64_t trace_;
 
  public:
   profile(std::string name, profile_map& profiles)
@@ -160,22 +567,59 @@ class profile {
       profiles[key_] = profile_info();
     }
     profile_ = &profiles[key_];
-    if (profile_->is_active()) {
-      std::ostringstream msg;
-      msg << "Profile '" << key_.first << "' already started!";
-      throw std::runtime_error(msg.str());
+    // keys of the map are never moved, so the callbacks on the AD tape
+    // can refer to the name without owning a copy
+    name_ = &profiles.find(key_)->first.first;
+    auto& active = internal::active_profiles();
+    for (auto it = active.rbegin(); it != active.rend(); ++it) {
+      if (it->profiles_ == &profiles) {
+        parent_ = it->call_;
+        break;
+      }
     }
+    call_ = parent_ == nullptr
+                ? &profile_->call(std::vector<std::string>(), key_.first)
+                : &profile_->call(parent_->get_path(), key_.first);
+    active.push_back({&profiles, call_});
+    trace_ = is_tracing() ? trace_event_record('B', key_.first, "profile")
+                          : 0;
     profile_->fwd_pass_start<T>();
+    call_->fwd_pass_start();
     if (!is_constant<T>::value) {
-      reverse_pass_callback(
-          [profile = this->profile_]() mutable { profile->rev_pass_stop(); });
+      reverse_pass_callback([profile = this->profile_, call = this->call_,
+                             parent = this->parent_, name = this->name_,
+                             trace = this->trace_]() mutable {
+        const double elapsed = call->rev_pass_stop();
+        profile->rev_pass_stop(elapsed);
+        if (parent != nullptr) {
+          parent->add_child_rev_time(elapsed);
+        }
+        if (trace != 0) {
+          trace_event_record_in(trace, 'E', *name + " (reverse)", "profile");
+        }
+      });
     }
   }
   ~profile() {
-    profile_->fwd_pass_stop<T>();
+    const double elapsed = call_->fwd_pass_stop();
+    profile_->fwd_pass_stop<T>(elapsed);
+    if (parent_ != nullptr) {
+      parent_->add_child_fwd_time(elapsed);
+    }
+    if (trace_ != 0) {
+      trace_event_record_in(trace_, 'E', key_.first, "profile");
+    }
+    internal::active_profiles().pop_back();
     if (!is_constant<T>::value) {
-      reverse_pass_callback(
-          [profile = this->profile_]() mutable { profile->rev_pass_start(); });
+      reverse_pass_callback([profile = this->profile_, call = this->call_,
+                             name = this->name_,
+                             trace = this->trace_]() mutable {
+        if (trace != 0) {
+          trace_event_record_in(trace, 'B', *name + " (reverse)", "profile");
+        }
+        profile->rev_pass_start();
+        call->rev_pass_start();
+      });
     }
   }
 };
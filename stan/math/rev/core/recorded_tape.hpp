@@ -0,0 +1,233 @@
+#ifndef STAN_MATH_REV_CORE_RECORDED_TAPE_HPP
+#define STAN_MATH_REV_CORE_RECORDED_TAPE_HPP
+
+#include <stan/math/rev/core/chainablestack.hpp>
+#include <stan/math/rev/core/grad.hpp>
+#include <stan/math/rev/core/nested_rev_autodiff.hpp>
+#include <stan/math/rev/core/var.hpp>
+#include <stan/math/rev/core/vari.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Records the shape of the autodiff tape built by a function whose
+ * control flow does not depend on its arguments, so that repeated
+ * gradient evaluations of that function can be run into preallocated
+ * storage. Example:
+ *
+ * recorded_tape tape;
+ * for (...) {
+ *   double fx;
+ *   Eigen::VectorXd grad_fx;
+ *   tape.gradient(f, x, fx, grad_fx);
+ * }
+ *
+ * The first call records the number of chained and non-chained varis
+ * and the number of arena bytes the function uses. Every later call
+ * reserves that much space on the `var_stack_`, the `var_nochain_stack_`
+ * and in one contiguous arena block before the function is evaluated,
+ * so the forward pass never grows a stack or switches arena blocks.
+ *
+ * The recorded varis of the latest evaluation stay on the tape until the
+ * next call to `gradient()`, which allows the reverse pass to be replayed
+ * with `replay()`, possibly for a different dependent variable, without
+ * rebuilding the expression graph.
+ *
+ * If the tape of an evaluation does not have the recorded shape, the
+ * function is not control-flow stable for the given inputs; the new shape
+ * is recorded and counted in `num_rerecords()`.
+ *
+ * All evaluations are run in a nested autodiff scope, so a
+ * `recorded_tape` does not interfere with the enclosing tape. The
+ * nested scope of the latest evaluation is closed when the next
+ * evaluation starts or the `recorded_tape` is destroyed, hence
+ * recorded tapes must be destroyed in the reverse order of their
+ * construction, like `nested_rev_autodiff`.
+ */
+class recorded_tape {
+  size_t num_chain_nodes_{0};
+  size_t num_nochain_nodes_{0};
+  size_t arena_bytes_{0};
+  size_t num_evaluations_{0};
+  size_t num_rerecords_{0};
+  bool recorded_{false};
+  bool nested_{false};
+  size_t chain_start_{0};
+  vari* dependent_{nullptr};
+  std::vector<vari*> independents_;
+
+  /**
+   * Close the nested scope of the latest evaluation, if any.
+   */
+  inline void release() {
+    if (nested_) {
+      recover_memory_nested();
+      nested_ = false;
+      dependent_ = nullptr;
+      independents_.clear();
+    }
+  }
+
+ public:
+  recorded_tape() = default;
+  ~recorded_tape() { release(); }
+
+  // Prevent undesirable operations
+  recorded_tape(const recorded_tape&) = delete;
+  recorded_tape& operator=(const recorded_tape&) = delete;
+  void* operator new(std::size_t) = delete;
+
+  /**
+   * Calculate the value and the gradient of the specified function
+   * at the specified argument, reusing the recorded tape shape.
+   *
+   * The functor must implement
+   *
+   * <code>
+   * var operator()(const Eigen::Matrix<var, Eigen::Dynamic, 1>&)
+   * </code>
+   *
+   * @tparam F Type of function
+   * @param[in] f Function
+   * @param[in] x Argument to function
+   * @param[out] fx Function applied to argument
+   * @param[out] grad_fx Gradient of function at argument
+   */
+  template <typename F>
+  void gradient(const F& f, const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
+                double& fx, Eigen::Matrix<double, Eigen::Dynamic, 1>& grad_fx) {
+    release();
+    start_nested();
+    nested_ = true;
+    auto& stack = *ChainableStack::instance_;
+    chain_start_ = stack.var_stack_.size();
+    const size_t nochain_start = stack.var_nochain_stack_.size();
+    if (recorded_) {
+      stack.var_stack_.reserve(chain_start_ + num_chain_nodes_);
+      stack.var_nochain_stack_.reserve(nochain_start + num_nochain_nodes_);
+      stack.memalloc_.reserve(arena_bytes_);
+    }
+    const size_t arena_start = stack.memalloc_.bytes_used();
+
+    Eigen::Matrix<var, Eigen::Dynamic, 1> x_var(x);
+    var fx_var = f(x_var);
+    fx = fx_var.val();
+
+    const size_t num_chain_nodes = stack.var_stack_.size() - chain_start_;
+    const size_t num_nochain_nodes
+        = stack.var_nochain_stack_.size() - nochain_start;
+    const size_t arena_bytes = stack.memalloc_.bytes_used() - arena_start;
+    if (recorded_
+        && (num_chain_nodes != num_chain_nodes_
+            || num_nochain_nodes != num_nochain_nodes_)) {
+      ++num_rerecords_;
+    }
+    num_chain_nodes_ = num_chain_nodes;
+    num_nochain_nodes_ = num_nochain_nodes;
+    if (!recorded_ || arena_bytes > arena_bytes_) {
+      arena_bytes_ = arena_bytes;
+    }
+    recorded_ = true;
+    ++num_evaluations_;
+
+    dependent_ = fx_var.vi_;
+    independents_.resize(x_var.size());
+    for (Eigen::Index i = 0; i < x_var.size(); ++i) {
+      independents_[i] = x_var.coeff(i).vi_;
+    }
+    grad(dependent_);
+    grad_fx.resize(x_var.size());
+    for (Eigen::Index i = 0; i < x_var.size(); ++i) {
+      grad_fx.coeffRef(i) = independents_[i]->adj_;
+    }
+  }
+
+  /**
+   * Replay the reverse pass of the latest evaluation for the specified
+   * dependent variable, without rebuilding the expression graph.
+   *
+   * All adjoints of the recorded tape are set to zero before the reverse
+   * pass. The dependent variable must have been created by the latest
+   * evaluation of the function or be the result of it.
+   *
+   * @param[in] dependent Dependent variable
+   * @param[out] grad_x Gradient of the dependent variable with respect to
+   * the arguments of the latest evaluation
+   * @throw std::logic_error if no evaluation is recorded or the nested
+   * scope of the latest evaluation is not on top of the tape
+   */
+  inline void replay(const var& dependent,
+                     Eigen::Matrix<double, Eigen::Dynamic, 1>& grad_x) {
+    if (!nested_
+        || ChainableStack::instance_->nested_var_stack_sizes_.empty()
+        || ChainableStack::instance_->nested_var_stack_sizes_.back()
+               != chain_start_) {
+      throw std::logic_error(
+          "recorded_tape::replay: the latest evaluation must be on top of "
+          "the autodiff tape");
+    }
+    set_zero_all_adjoints_nested();
+    grad(dependent.vi_);
+    grad_x.resize(independents_.size());
+    for (size_t i = 0; i < independents_.size(); ++i) {
+      grad_x.coeffRef(i) = independents_[i]->adj_;
+    }
+  }
+
+  /**
+   * Replay the reverse pass of the latest evaluation for the result of
+   * the function.
+   *
+   * @param[out] grad_x Gradient of the function with respect to its
+   * arguments at the latest evaluation
+   * @throw std::logic_error if no evaluation is recorded
+   */
+  inline void replay(Eigen::Matrix<double, Eigen::Dynamic, 1>& grad_x) {
+    if (!nested_) {
+      throw std::logic_error("recorded_tape::replay: nothing recorded");
+    }
+    replay(var(dependent_), grad_x);
+  }
+
+  /**
+   * Return true if a tape shape has been recorded.
+   */
+  inline bool is_recorded() const noexcept { return recorded_; }
+
+  /**
+   * Return the number of varis on the chain stack of the latest evaluation.
+   */
+  inline size_t num_chain_nodes() const noexcept { return num_chain_nodes_; }
+
+  /**
+   * Return the number of varis on the non-chain stack of the latest
+   * evaluation.
+   */
+  inline size_t num_nochain_nodes() const noexcept {
+    return num_nochain_nodes_;
+  }
+
+  /**
+   * Return the number of arena bytes reserved for an evaluation.
+   */
+  inline size_t arena_bytes() const noexcept { return arena_bytes_; }
+
+  /**
+   * Return the number of evaluations run through this tape.
+   */
+  inline size_t num_evaluations() const noexcept { return num_evaluations_; }
+
+  /**
+   * Return the number of evaluations whose tape shape differed from the
+   * recorded one.
+   */
+  inline size_t num_rerecords() const noexcept { return num_rerecords_; }
+};
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -21,12 +21,16 @@ static inline void recover_memory() {
         "empty_nested() must be true"
         " before calling recover_memory()");
   }
+  internal::get_autodiff_size_record().update(
+      ChainableStack::instance_->size());
   ChainableStack::instance_->var_stack_.clear();
   ChainableStack::instance_->var_nochain_stack_.clear();
   for (auto &x : ChainableStack::instance_->var_alloc_stack_) {
     delete x;
   }
   ChainableStack::instance_->var_alloc_stack_.clear();
+  ChainableStack::instance_->zeroable_ranges_.clear();
+  ChainableStack::instance_->zeroable_range_owners_.clear();
   ChainableStack::instance_->memalloc_.recover_all();
 }
 
@@ -27,6 +27,11 @@ static inline void recover_memory_nested() {
         " before calling recover_memory_nested()");
   }
 
+  if (ChainableStack::instance_->nested_var_stack_sizes_.size() == 1) {
+    internal::get_autodiff_size_record().update(
+        ChainableStack::instance_->size());
+  }
+
   ChainableStack::instance_->var_stack_.resize(
       ChainableStack::instance_->nested_var_stack_sizes_.back());
   ChainableStack::instance_->nested_var_stack_sizes_.pop_back();
@@ -44,6 +49,13 @@ static inline void recover_memory_nested() {
       ChainableStack::instance_->nested_var_alloc_stack_starts_.back());
   ChainableStack::instance_->nested_var_alloc_stack_starts_.pop_back();
 
+  ChainableStack::instance_->zeroable_ranges_.resize(
+      ChainableStack::instance_->nested_zeroable_ranges_sizes_.back());
+  ChainableStack::instance_->nested_zeroable_ranges_sizes_.pop_back();
+  ChainableStack::instance_->zeroable_range_owners_.resize(
+      ChainableStack::instance_->nested_zeroable_range_owners_sizes_.back());
+  ChainableStack::instance_->nested_zeroable_range_owners_sizes_.pop_back();
+
   ChainableStack::instance_->memalloc_.recover_nested();
 }
 
@@ -0,0 +1,77 @@
+#ifndef STAN_MATH_REV_CORE_RESERVE_AUTODIFF_HPP
+#define STAN_MATH_REV_CORE_RESERVE_AUTODIFF_HPP
+
+#include <stan/math/rev/core/autodiffstackstorage.hpp>
+#include <stan/math/rev/core/chainablestack.hpp>
+#include <cstddef>
+
+namespace stan {
+namespace math {
+
+/**
+ * Reserve space on the autodiff tape of the current thread for
+ * `bytes` bytes of arena memory and `nodes` varis, so that recording a
+ * tape of that size neither reallocates the node stacks nor allocates
+ * arena blocks. The reservation is kept when the memory of the tape is
+ * recovered.
+ *
+ * @param bytes number of bytes of arena memory
+ * @param nodes number of varis on each of the chain and no chain stacks
+ */
+inline void reserve_autodiff(size_t bytes, size_t nodes) {
+  autodiff_size size;
+  size.chain_nodes_ = nodes;
+  size.nochain_nodes_ = nodes;
+  size.arena_bytes_ = bytes;
+  ChainableStack::instance_->reserve(size);
+}
+
+/**
+ * Reserve space on the autodiff tape of the current thread for the
+ * largest tape recovered so far by any thread, as returned by
+ * `learned_autodiff_size()`.
+ */
+inline void reserve_autodiff() {
+  ChainableStack::instance_->reserve(
+      internal::get_autodiff_size_record().get());
+}
+
+/**
+ * Return the number of nodes and arena bytes of the largest autodiff
+ * tape recovered so far by any thread. Tapes are measured when their
+ * memory is recovered by `recover_memory()` or when the outermost
+ * nested scope is recovered.
+ *
+ * @return peak size of the recovered tapes
+ */
+inline autodiff_size learned_autodiff_size() {
+  return internal::get_autodiff_size_record().get();
+}
+
+/**
+ * Set whether autodiff stacks constructed from now on, such as the
+ * tapes of new threads and of `ScopedChainableStack`s, reserve the size
+ * returned by `learned_autodiff_size()` up front. Off by default, since
+ * the learned size is the peak over all tapes of the process and may be
+ * much larger than the tapes of worker threads.
+ *
+ * @param reserve true if new stacks reserve the learned size
+ */
+inline void reserve_learned_autodiff_size(bool reserve) {
+  internal::get_autodiff_size_record().reserve_new_stacks_.store(
+      reserve, std::memory_order_relaxed);
+}
+
+/**
+ * Forget the sizes of the tapes recovered so far.
+ */
+inline void reset_learned_autodiff_size() {
+  auto& record = internal::get_autodiff_size_record();
+  record.chain_nodes_.store(0, std::memory_order_relaxed);
+  record.nochain_nodes_.store(0, std::memory_order_relaxed);
+  record.arena_bytes_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
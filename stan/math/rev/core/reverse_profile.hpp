@@ -0,0 +1,268 @@
+#ifndef STAN_MATH_REV_CORE_REVERSE_PROFILE_HPP
+#define STAN_MATH_REV_CORE_REVERSE_PROFILE_HPP
+
+#include <stan/math/rev/core/chainablestack.hpp>
+#include <stan/math/rev/core/empty_nested.hpp>
+#include <stan/math/rev/core/nested_size.hpp>
+#include <stan/math/rev/core/vari.hpp>
+#include <boost/core/demangle.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Reverse pass statistics of one dynamic vari type.
+ */
+struct vari_type_stats {
+  /**
+   * Demangled name of the type.
+   */
+  std::string type_;
+  /**
+   * Number of calls to `chain()`.
+   */
+  size_t calls_{0};
+  /**
+   * Number of calls to `chain()` which were timed.
+   */
+  size_t sampled_calls_{0};
+  /**
+   * Time in seconds spent in the timed calls.
+   */
+  double sampled_time_{0.0};
+  /**
+   * Adjoint bytes read and written by the timed calls of varis which can
+   * be linearized or report their number of adjoints (see
+   * `vari_base::num_adjoints()`): the adjoint of the vari and of each
+   * operand.
+   */
+  size_t sampled_adjoint_bytes_{0};
+  /**
+   * Number of timed calls of varis for which the adjoint bytes are
+   * unknown.
+   */
+  size_t sampled_opaque_calls_{0};
+
+  /**
+   * Return the estimated time in seconds of all calls, scaling the time
+   * of the timed calls by the number of calls.
+   */
+  inline double estimated_time() const noexcept {
+    return sampled_calls_ == 0 ? 0.0
+                               : sampled_time_ * calls_ / sampled_calls_;
+  }
+
+  /**
+   * Return the estimated adjoint bytes touched by all calls, scaling the
+   * mean of the timed calls with known adjoint bytes, or zero if there
+   * is no such call.
+   */
+  inline double estimated_adjoint_bytes() const noexcept {
+    const size_t linear_calls = sampled_calls_ - sampled_opaque_calls_;
+    return linear_calls == 0 ? 0.0
+                             : static_cast<double>(sampled_adjoint_bytes_)
+                                   * calls_ / linear_calls;
+  }
+};
+
+/**
+ * Profile of the reverse pass by dynamic vari type.
+ *
+ * Every call to `chain()` run through `grad_profiled()` is counted
+ * under the demangled type of the vari. Every `sample_every`-th call is
+ * also timed, and the adjoint bytes it touches are measured by
+ * linearizing the vari, or estimated from its number of adjoints if it
+ * cannot be linearized, so that the overhead of the profile can be
+ * traded against its resolution. The statistics of a type are looked
+ * up by the address of its `std::type_info`, and the last type is
+ * cached, so the calls which are not timed cost a pointer comparison
+ * in runs of varis of the same type. The statistics add up over all
+ * reverse passes run with the same profile.
+ *
+ * Example:
+ *
+ * reverse_profile prof(16);
+ * grad_profiled(f.vi_, prof);
+ * prof.write_json(std::cout);
+ */
+class reverse_profile {
+  std::unordered_map<std::type_index, size_t> index_;
+  std::unordered_map<const std::type_info*, size_t> info_index_;
+  const std::type_info* last_info_{nullptr};
+  size_t last_index_{0};
+  std::vector<vari_type_stats> stats_;
+  size_t sample_every_;
+  size_t countdown_;
+  std::vector<vari*> operands_;
+  std::vector<double> partials_;
+
+  /**
+   * Return the statistics of the type of the specified vari. The type
+   * is compared by name only the first time its `std::type_info` is
+   * seen, since the same type may have several.
+   */
+  inline vari_type_stats& stats_of(const vari_base* vi) {
+    const std::type_info* info = &typeid(*vi);
+    if (info != last_info_) {
+      auto it = info_index_.find(info);
+      if (it == info_index_.end()) {
+        const std::type_index type(*info);
+        auto named = index_.find(type);
+        if (named == index_.end()) {
+          named = index_.emplace(type, stats_.size()).first;
+          stats_.emplace_back();
+          stats_.back().type_ = boost::core::demangle(type.name());
+        }
+        it = info_index_.emplace(info, named->second).first;
+      }
+      last_info_ = info;
+      last_index_ = it->second;
+    }
+    return stats_[last_index_];
+  }
+
+ public:
+  /**
+   * Construct an empty profile.
+   *
+   * @param sample_every time one in this many calls to `chain()`; zero
+   * is treated as one
+   */
+  explicit reverse_profile(size_t sample_every = 1)
+      : sample_every_(sample_every == 0 ? 1 : sample_every),
+        countdown_(1) {}
+
+  /**
+   * Call `chain()` on the specified vari and record it.
+   *
+   * @param vi vari to chain
+   */
+  inline void chain(vari_base* vi) {
+    vari_type_stats& stats = stats_of(vi);
+    ++stats.calls_;
+    if (--countdown_ != 0) {
+      vi->chain();
+      return;
+    }
+    countdown_ = sample_every_;
+    const auto start = std::chrono::steady_clock::now();
+    vi->chain();
+    stats.sampled_time_ += std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    ++stats.sampled_calls_;
+    operands_.clear();
+    partials_.clear();
+    if (vi->linearize(operands_, partials_)) {
+      stats.sampled_adjoint_bytes_ += (operands_.size() + 1) * sizeof(double);
+    } else if (vi->num_adjoints() != 0) {
+      stats.sampled_adjoint_bytes_ += vi->num_adjoints() * sizeof(double);
+    } else {
+      ++stats.sampled_opaque_calls_;
+    }
+  }
+
+  /**
+   * Return the statistics of all vari types seen, by decreasing
+   * estimated time.
+   */
+  inline std::vector<vari_type_stats> stats() const {
+    std::vector<vari_type_stats> sorted = stats_;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const vari_type_stats& a, const vari_type_stats& b) {
+                       return a.estimated_time() > b.estimated_time();
+                     });
+    return sorted;
+  }
+
+  /**
+   * Return the estimated time in seconds of all recorded calls.
+   */
+  inline double estimated_time() const noexcept {
+    double sum = 0.0;
+    for (const auto& stats : stats_) {
+      sum += stats.estimated_time();
+    }
+    return sum;
+  }
+
+  /**
+   * Discard all statistics.
+   */
+  inline void clear() {
+    index_.clear();
+    info_index_.clear();
+    last_info_ = nullptr;
+    stats_.clear();
+    countdown_ = 1;
+  }
+
+  /**
+   * Write the statistics as a JSON object holding the sampling interval
+   * and an array with one object per vari type, by decreasing estimated
+   * time.
+   *
+   * @param[in, out] os stream to write to
+   */
+  inline void write_json(std::ostream& os) const {
+    const double total_time = estimated_time();
+    os << "{\"sample_every\": " << sample_every_ << ", \"types\": [";
+    bool first = true;
+    for (const auto& stats : this->stats()) {
+      os << (first ? "" : ", ") << "{\"type\": \"";
+      for (char c : stats.type_) {
+        if (c == '"' || c == '\\') {
+          os << '\\';
+        }
+        os << c;
+      }
+      os << "\", \"calls\": " << stats.calls_
+         << ", \"sampled_calls\": " << stats.sampled_calls_
+         << ", \"sampled_time\": " << stats.sampled_time_
+         << ", \"estimated_time\": " << stats.estimated_time()
+         << ", \"time_fraction\": "
+         << (total_time > 0 ? stats.estimated_time() / total_time : 0.0)
+         << ", \"estimated_adjoint_bytes\": "
+         << stats.estimated_adjoint_bytes()
+         << ", \"sampled_opaque_calls\": " << stats.sampled_opaque_calls_
+         << "}";
+      first = false;
+    }
+    os << "]}";
+  }
+};
+
+/**
+ * Compute the gradient for all variables starting from the specified
+ * root variable implementation, like `grad(vi)`, recording every call
+ * to `chain()` in the specified profile.
+ *
+ * This function does not recover any memory from the computation.
+ *
+ * @tparam Vari type of root variable implementation
+ * @param vi root of partial derivative propagation
+ * @param[in, out] profile profile to record the reverse pass in
+ */
+template <typename Vari>
+inline void grad_profiled(Vari* vi, reverse_profile& profile) {
+  vi->init_dependent();
+  auto& stack = ChainableStack::instance_->var_stack_;
+  const size_t end = stack.size();
+  const size_t beginning = empty_nested() ? 0 : end - nested_size();
+  for (size_t i = end; i-- > beginning;) {
+    profile.chain(stack[i]);
+  }
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -4,12 +4,17 @@
 #include <stan/math/rev/core/vari.hpp>
 #include <stan/math/rev/core/chainable_alloc.hpp>
 #include <stan/math/rev/core/chainablestack.hpp>
+#include <cstring>
 
 namespace stan {
 namespace math {
 
 /**
- * Reset all adjoint values in the stack to zero.
+ * Reset all adjoint values in the stack to zero. The adjoints of dense
+ * matrix varis which are not on the `var_stack_` are registered as
+ * contiguous ranges and are zeroed with one `memset` per range. An
+ * adjoint which was reassigned to new memory since it was registered is
+ * zeroed where it is now.
  */
 static inline void set_zero_all_adjoints() {
   for (auto &x : ChainableStack::instance_->var_stack_) {
@@ -18,6 +23,10 @@ static inline void set_zero_all_adjoints() {
   for (auto &x : ChainableStack::instance_->var_nochain_stack_) {
     x->set_zero_adjoint();
   }
+  for (auto &x : ChainableStack::instance_->zeroable_ranges_) {
+    std::memset(x.begin_, 0, x.nbytes_);
+  }
+  ChainableStack::instance_->zero_moved_adjoints(0);
 }
 
 }  // namespace math
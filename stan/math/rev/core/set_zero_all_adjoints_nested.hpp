@@ -5,6 +5,7 @@
 #include <stan/math/rev/core/chainable_alloc.hpp>
 #include <stan/math/rev/core/chainablestack.hpp>
 #include <stan/math/rev/core/empty_nested.hpp>
+#include <cstring>
 #include <stdexcept>
 
 namespace stan {
@@ -37,6 +38,16 @@ static inline void set_zero_all_adjoints_nested() {
        i < ChainableStack::instance_->var_nochain_stack_.size(); ++i) {
     ChainableStack::instance_->var_nochain_stack_[i]->set_zero_adjoint();
   }
+
+  const size_t start3
+      = ChainableStack::instance_->nested_zeroable_ranges_sizes_.back();
+  for (size_t i = start3;
+       i < ChainableStack::instance_->zeroable_ranges_.size(); ++i) {
+    const zeroable_range &x = ChainableStack::instance_->zeroable_ranges_[i];
+    std::memset(x.begin_, 0, x.nbytes_);
+  }
+  ChainableStack::instance_->zero_moved_adjoints(
+      ChainableStack::instance_->nested_zeroable_range_owners_sizes_.back());
 }
 
 }  // namespace math
@@ -0,0 +1,352 @@
+#ifndef STAN_MATH_REV_CORE_SOA_TAPE_HPP
+#define STAN_MATH_REV_CORE_SOA_TAPE_HPP
+
+#include <stan/math/rev/core/compact_tape.hpp>
+#include <stan/math/rev/core/vari.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * A structure-of-arrays copy of the reverse pass of an autodiff tape.
+ *
+ * Every vari referenced by the linear records of a `compact_tape` is a
+ * node, numbered by a 32-bit id. The node ids follow the addresses of
+ * the varis, so the id of a vari is found by binary search and no map
+ * is stored. The adjoints of all nodes are held in one contiguous array
+ * indexed by node id, and every record stores the id of its output and
+ * the ids of its operands in a compressed row layout next to the
+ * partials. The reverse pass then streams through the record arrays and
+ * the adjoint array without touching the varis, and zeroing all
+ * adjoints is a single `memset`.
+ *
+ * Example:
+ *
+ * var f = ...;
+ * soa_tape tape{compact_tape()};
+ * tape.grad(f.vi_);
+ * double df_dx = tape.adjoint(x.vi_);
+ *
+ * This is a copy made after the forward pass, not a replacement for the
+ * varis: it holds 16 bytes per node and 12 bytes per operand on top of
+ * the tape. The adjoints of the soa tape are separate from the adjoints
+ * of the varis. They are copied to and from the varis with
+ * `scatter_adjoints()` and `gather_adjoints()`.
+ *
+ * Opaque varis of the compact tape are kept and their `chain()` is
+ * called in tape order. They work on the adjoints of the varis, so the
+ * adjoints of the nodes they may read are moved to the varis before, and
+ * the linear records before the last opaque vari also read the adjoints
+ * of their outputs from the varis. After the reverse pass, the adjoints
+ * the opaque varis added to nodes are moved back to the soa tape. For
+ * this the adjoints of the varis have to be zero when the reverse pass
+ * starts, as for `compact_tape`.
+ */
+class soa_tape {
+  static constexpr std::uint32_t none
+      = std::numeric_limits<std::uint32_t>::max();
+
+  std::vector<vari*> nodes_;
+  std::vector<double> adj_;
+  std::vector<std::uint32_t> out_ids_;
+  std::vector<std::uint32_t> record_begin_;
+  std::vector<std::uint32_t> operand_ids_;
+  std::vector<double> partials_;
+  std::vector<vari_base*> opaque_;
+  // node id of every opaque vari reading only its own adjoint, or none
+  std::vector<std::uint32_t> opaque_ids_;
+  std::vector<compact_tape::run> runs_;
+  // number of records before the last opaque vari
+  size_t num_mixed_{0};
+
+  /**
+   * Return the node id of the specified vari, or `none`.
+   */
+  inline std::uint32_t find(const vari* vi) const {
+    std::less<const vari*> less;
+    auto it = std::lower_bound(nodes_.begin(), nodes_.end(), vi, less);
+    return it != nodes_.end() && *it == vi
+               ? static_cast<std::uint32_t>(it - nodes_.begin())
+               : none;
+  }
+
+  /**
+   * Move the adjoints the records `[first, last)` added to their
+   * operands to the varis.
+   */
+  inline void move_to_varis(size_t first, size_t last) noexcept {
+    for (std::uint32_t k = record_begin_[first]; k < record_begin_[last];
+         ++k) {
+      nodes_[operand_ids_[k]]->adj_ += adj_[operand_ids_[k]];
+      adj_[operand_ids_[k]] = 0.0;
+    }
+  }
+
+ public:
+  /**
+   * Build the soa tape from a compact tape.
+   *
+   * @param tape compact tape
+   * @throw std::length_error if the tape has more than 2^32 - 1 nodes
+   * or operands
+   */
+  explicit soa_tape(const compact_tape& tape) {
+    if (tape.num_operands() + tape.num_linear()
+        >= std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error("soa_tape: the tape is too large");
+    }
+    const auto& records = tape.linear_records();
+    const auto& operands = tape.operands();
+    nodes_.reserve(records.size() + operands.size());
+    for (const auto& rec : records) {
+      nodes_.push_back(rec.out_);
+    }
+    nodes_.insert(nodes_.end(), operands.begin(), operands.end());
+    std::less<const vari*> less;
+    std::sort(nodes_.begin(), nodes_.end(), less);
+    nodes_.erase(std::unique(nodes_.begin(), nodes_.end()), nodes_.end());
+    nodes_.shrink_to_fit();
+
+    out_ids_.reserve(records.size());
+    record_begin_.reserve(records.size() + 1);
+    operand_ids_.reserve(operands.size());
+    record_begin_.push_back(0);
+    for (const auto& rec : records) {
+      for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+        operand_ids_.push_back(find(operands[k]));
+      }
+      out_ids_.push_back(find(rec.out_));
+      record_begin_.push_back(
+          static_cast<std::uint32_t>(operand_ids_.size()));
+    }
+    partials_ = tape.partials();
+    adj_.resize(nodes_.size(), 0.0);
+
+    opaque_ = tape.opaque();
+    runs_ = tape.runs();
+    for (vari_base* node : opaque_) {
+      const vari* vi = dynamic_cast<const vari*>(node);
+      opaque_ids_.push_back(vi != nullptr && node->reads_only_own_adjoint()
+                                ? find(vi)
+                                : none);
+    }
+    size_t num_linear = 0;
+    for (const auto& r : runs_) {
+      if (r.kind_ == compact_tape::run_kind::linear) {
+        num_linear = r.end_;
+      } else {
+        num_mixed_ = num_linear;
+      }
+    }
+  }
+
+  /**
+   * Set the adjoints of all nodes to zero.
+   */
+  inline void set_zero_adjoints() noexcept {
+    if (!adj_.empty()) {
+      std::memset(adj_.data(), 0, adj_.size() * sizeof(double));
+    }
+  }
+
+  /**
+   * Run the reverse pass over the records, propagating the adjoints
+   * held by the soa tape. Like `chain()` on a `compact_tape`, this does
+   * not zero any adjoints.
+   *
+   * If the tape holds opaque varis, the adjoints of the varis of all
+   * nodes have to be zero on entry and are zero again on exit. The
+   * adjoints of opaque varis that are not nodes are left as set by the
+   * reverse pass.
+   */
+  inline void chain() {
+    double* adj = adj_.data();
+    const std::uint32_t* out_ids = out_ids_.data();
+    const std::uint32_t* begin = record_begin_.data();
+    const std::uint32_t* operand_ids = operand_ids_.data();
+    const double* partials = partials_.data();
+    if (opaque_.empty()) {
+      for (size_t i = out_ids_.size(); i-- > 0;) {
+        const double out_adj = adj[out_ids[i]];
+        for (std::uint32_t k = begin[i]; k < begin[i + 1]; ++k) {
+          adj[operand_ids[k]] += out_adj * partials[k];
+        }
+      }
+      return;
+    }
+
+    // records [next, moved) have run since the adjoints were last moved
+    // to the varis; before the first move every node may hold an adjoint
+    size_t next = out_ids_.size();
+    size_t moved = next;
+    bool moved_all = false;
+    for (auto run_it = runs_.rbegin(); run_it != runs_.rend(); ++run_it) {
+      if (run_it->kind_ == compact_tape::run_kind::linear) {
+        for (size_t i = run_it->end_; i-- > run_it->begin_;) {
+          double out_adj = adj[out_ids[i]];
+          if (i < num_mixed_) {
+            out_adj += nodes_[out_ids[i]]->adj_;
+          }
+          for (std::uint32_t k = begin[i]; k < begin[i + 1]; ++k) {
+            adj[operand_ids[k]] += out_adj * partials[k];
+          }
+        }
+        next = run_it->begin_;
+        continue;
+      }
+      for (size_t i = run_it->end_; i-- > run_it->begin_;) {
+        const std::uint32_t id = opaque_ids_[i];
+        if (id != none) {
+          nodes_[id]->adj_ += adj[id];
+          adj[id] = 0.0;
+        } else if (!moved_all) {
+          for (size_t j = 0; j < nodes_.size(); ++j) {
+            nodes_[j]->adj_ += adj[j];
+            adj[j] = 0.0;
+          }
+          moved_all = true;
+          moved = next;
+        } else if (next < moved) {
+          move_to_varis(next, moved);
+          moved = next;
+        }
+        opaque_[i]->chain();
+      }
+    }
+    for (size_t j = 0; j < nodes_.size(); ++j) {
+      adj[j] += nodes_[j]->adj_;
+      nodes_[j]->adj_ = 0.0;
+    }
+  }
+
+  /**
+   * Set all adjoints to zero, set the adjoint of the specified root to
+   * one and run the reverse pass. Unlike `grad(vi)` this starts from
+   * zero adjoints, since the adjoints are held by the soa tape.
+   *
+   * @param vi root of partial derivative propagation
+   * @throw std::invalid_argument if the root is not part of the tape
+   * and the tape has no opaque varis
+   */
+  inline void grad(vari* vi) {
+    set_zero_adjoints();
+    const std::uint32_t root = find(vi);
+    if (root != none) {
+      adj_[root] = 1.0;
+    } else if (!opaque_.empty()) {
+      vi->adj_ = 1.0;
+    } else {
+      throw std::invalid_argument("soa_tape: vari is not part of the tape");
+    }
+    chain();
+  }
+
+  /**
+   * Copy the adjoints of the soa tape to the varis.
+   */
+  inline void scatter_adjoints() const noexcept {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      nodes_[i]->adj_ = adj_[i];
+    }
+  }
+
+  /**
+   * Copy the adjoints of the varis to the soa tape.
+   */
+  inline void gather_adjoints() noexcept {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      adj_[i] = nodes_[i]->adj_;
+    }
+  }
+
+  /**
+   * Return the node id of the specified vari.
+   *
+   * @param vi vari referenced by the tape
+   * @return node id
+   * @throw std::invalid_argument if the vari is not part of the tape
+   */
+  inline std::uint32_t id(const vari* vi) const {
+    const std::uint32_t node = find(vi);
+    if (node == none) {
+      throw std::invalid_argument("soa_tape: vari is not part of the tape");
+    }
+    return node;
+  }
+
+  /**
+   * Return the adjoint held by the soa tape for the specified vari.
+   *
+   * @param vi vari referenced by the tape
+   * @return adjoint of the vari
+   * @throw std::invalid_argument if the vari is not part of the tape
+   */
+  inline double adjoint(const vari* vi) const { return adj_[id(vi)]; }
+
+  /**
+   * Return the adjoints of all nodes, indexed by node id.
+   */
+  inline std::vector<double>& adjoints() noexcept { return adj_; }
+
+  /**
+   * Return the adjoints of all nodes, indexed by node id.
+   */
+  inline const std::vector<double>& adjoints() const noexcept { return adj_; }
+
+  /**
+   * Return the varis of all nodes, indexed by node id.
+   */
+  inline const std::vector<vari*>& nodes() const noexcept { return nodes_; }
+
+  /**
+   * Return the number of nodes.
+   */
+  inline size_t num_nodes() const noexcept { return nodes_.size(); }
+
+  /**
+   * Return the number of records.
+   */
+  inline size_t num_records() const noexcept { return out_ids_.size(); }
+
+  /**
+   * Return the node ids of the outputs of the records, in tape order.
+   */
+  inline const std::vector<std::uint32_t>& out_ids() const noexcept {
+    return out_ids_;
+  }
+
+  /**
+   * Return the offsets of the operands of every record into
+   * `operand_ids()` and `partials()`. The operands of record `i` are
+   * `[record_begin()[i], record_begin()[i + 1])`.
+   */
+  inline const std::vector<std::uint32_t>& record_begin() const noexcept {
+    return record_begin_;
+  }
+
+  /**
+   * Return the node ids of the operands of all records.
+   */
+  inline const std::vector<std::uint32_t>& operand_ids() const noexcept {
+    return operand_ids_;
+  }
+
+  /**
+   * Return the partials of all records.
+   */
+  inline const std::vector<double>& partials() const noexcept {
+    return partials_;
+  }
+};
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -20,6 +20,10 @@ static inline void start_nested() {
       ChainableStack::instance_->var_nochain_stack_.size());
   ChainableStack::instance_->nested_var_alloc_stack_starts_.push_back(
       ChainableStack::instance_->var_alloc_stack_.size());
+  ChainableStack::instance_->nested_zeroable_ranges_sizes_.push_back(
+      ChainableStack::instance_->zeroable_ranges_.size());
+  ChainableStack::instance_->nested_zeroable_range_owners_sizes_.push_back(
+      ChainableStack::instance_->zeroable_range_owners_.size());
   ChainableStack::instance_->memalloc_.start_nested();
 }
 
@@ -2,6 +2,8 @@
 #define STAN_MATH_REV_CORE_STORED_GRADIENT_VARI_HPP
 
 #include <stan/math/rev/core/vari.hpp>
+#include <typeinfo>
+#include <vector>
 
 namespace stan {
 namespace math {
@@ -43,6 +45,25 @@ class stored_gradient_vari : public vari {
       dtrs_[i]->adj_ += adj_ * partials_[i];
     }
   }
+
+  /**
+   * Describe the reverse pass through the daughter varis and the
+   * stored partials. Derived classes are run through `chain()`.
+   */
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    if (typeid(*this) != typeid(stored_gradient_vari)) {
+      return false;
+    }
+    operands.insert(operands.end(), dtrs_, dtrs_ + size_);
+    partials.insert(partials.end(), partials_, partials_ + size_);
+    return true;
+  }
+
+  /**
+   * Return the number of adjoints of this vari and its daughters.
+   */
+  size_t num_adjoints() const { return 1 + size_; }
 };
 
 }  // namespace math
@@ -12,6 +12,8 @@ class op_v_vari : public vari {
 
  public:
   op_v_vari(double f, vari* avi) : vari(f), avi_(avi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
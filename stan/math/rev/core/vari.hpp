@@ -8,6 +8,7 @@
 #include <stan/math/prim/meta.hpp>
 #include <ostream>
 #include <type_traits>
+#include <vector>
 
 namespace stan {
 namespace math {
@@ -34,6 +35,54 @@ class vari_base {
   virtual void chain() = 0;
   virtual void set_zero_adjoint() = 0;
 
+  /**
+   * Describe the reverse pass of this variable as a list of scalar
+   * operands and the partial derivatives of its value with respect to
+   * them, so that `chain()` is equivalent to adding the adjoint of this
+   * variable times each partial to the adjoint of each operand.
+   *
+   * Used by `compact_tape` to run the reverse pass without virtual
+   * dispatch. The default implementation returns `false`, which means
+   * the reverse pass of this variable can only be run through
+   * `chain()`. Classes overriding this method must be `final` or make
+   * sure derived classes do not inherit it.
+   *
+   * @param[in, out] operands Operands are appended to this vector.
+   * @param[in, out] partials Partials are appended to this vector.
+   * @return `true` if this variable has been described.
+   */
+  virtual bool linearize(std::vector<vari_value<double>*>& operands,
+                         std::vector<double>& partials) const {
+    return false;
+  }
+
+  /**
+   * Return `true` if `chain()` reads no adjoint other than the adjoint
+   * of this variable, so that it does nothing while that adjoint is zero.
+   *
+   * Used by `compact_tape::prune()`, which only drops an opaque scalar
+   * vari whose own adjoint cannot become nonzero if this returns `true`.
+   * The default implementation returns `false`, because `chain()` may
+   * read the adjoints of other varis, such as the outputs of a vari
+   * computing several values at once.
+   *
+   * @return `true` if the reverse pass of this variable only depends on
+   * its own adjoint.
+   */
+  virtual bool reads_only_own_adjoint() const { return false; }
+
+  /**
+   * Return the number of scalar adjoints `chain()` reads or writes,
+   * including the adjoints of this variable, or zero if it is not known.
+   *
+   * Used by `reverse_profile` to estimate the adjoint bytes touched by
+   * variables that cannot be linearized. The default implementation
+   * returns zero.
+   *
+   * @return number of adjoints touched by the reverse pass
+   */
+  virtual size_t num_adjoints() const { return 0; }
+
   /**
    * Allocate memory from the underlying memory pool.  This memory is
    * is managed as a whole externally.
@@ -678,7 +727,8 @@ class vari_value<T, require_all_t<is_plain_type<T>, is_eigen_dense_base<T>>>
    * Construct a dense Eigen variable implementation from a value. The
    * adjoint is initialized to zero.
    *
-   * All constructed variables are added to the no chain stack. Variables
+   * The adjoints of all constructed variables are registered to be
+   * zeroed by `set_zero_all_adjoints()`. Variables
    * should be constructed before variables on which they depend
    * to insure proper partial derivative propagation.
    *
@@ -697,14 +747,14 @@ class vari_value<T, require_all_t<is_plain_type<T>, is_eigen_dense_base<T>>>
                  ? x.rows()
                  : x.cols()) {
     adj_.setZero();
-    ChainableStack::instance_->var_nochain_stack_.push_back(this);
+    push_zeroable_adjoint();
   }
 
   /**
    * Construct a dense Eigen variable implementation from a value. The
    *  adjoint is initialized to zero and if `stacked` is `false` this vari
-   *  will be not be put on the var_stack. Instead it will only be put on
-   *  a stack to keep track of whether the adjoint needs to be set to zero.
+   *  will be not be put on the var_stack. Instead its adjoint will only be
+   *  registered to be set to zero by `set_zero_all_adjoints()`.
    *  Variables should be constructed before variables on which they depend
    *  to insure proper partial derivative propagation.  During
    *  derivative propagation, the chain() method of each variable
@@ -730,7 +780,7 @@ class vari_value<T, require_all_t<is_plain_type<T>, is_eigen_dense_base<T>>>
     if (stacked) {
       ChainableStack::instance_->var_stack_.push_back(this);
     } else {
-      ChainableStack::instance_->var_nochain_stack_.push_back(this);
+      push_zeroable_adjoint();
     }
   }
 
@@ -749,13 +799,33 @@ class vari_value<T, require_all_t<is_plain_type<T>, is_eigen_dense_base<T>>>
   template <typename S, typename K, require_assignable_t<T, S>* = nullptr,
             require_assignable_t<T, K>* = nullptr>
   explicit vari_value(const S& val, const K& adj) : val_(val), adj_(adj) {
-    ChainableStack::instance_->var_nochain_stack_.push_back(this);
+    push_zeroable_adjoint();
   }
 
  protected:
   template <typename S, require_not_same_t<T, S>* = nullptr>
   explicit vari_value(const vari_value<S>* x) : val_(x->val_), adj_(x->adj_) {}
 
+ private:
+  /**
+   * Register the adjoint of this vari on the autodiff stack to be zeroed
+   * by `set_zero_all_adjoints()` with a `memset`, instead of putting the
+   * vari on the no chain stack. The adjoint should be updated in place
+   * (`adj_ += x`) rather than reassigned (`adj_ = adj_ + x`), which moves
+   * it to new arena memory and costs `set_zero_all_adjoints()` a second
+   * pass over it.
+   */
+  inline void push_zeroable_adjoint() {
+    ChainableStack::instance_->push_zeroable_range(
+        adj_.data(), adj_.size() * sizeof(eigen_scalar), this,
+        [](void* vi, const void* begin) {
+          auto& adj = static_cast<vari_value*>(vi)->adj_;
+          if (adj.data() != begin) {
+            adj.setZero();
+          }
+        });
+  }
+
  public:
   /**
    * Return a constant reference to the value of this vari.
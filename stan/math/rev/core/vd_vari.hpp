@@ -13,6 +13,8 @@ class op_vd_vari : public vari {
 
  public:
   op_vd_vari(double f, vari* avi, double b) : vari(f), avi_(avi), bd_(b) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -15,6 +15,8 @@ class op_vdd_vari : public vari {
  public:
   op_vdd_vari(double f, vari* avi, double b, double c)
       : vari(f), avi_(avi), bd_(b), cd_(c) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -15,6 +15,8 @@ class op_vdv_vari : public vari {
  public:
   op_vdv_vari(double f, vari* avi, double b, vari* cvi)
       : vari(f), avi_(avi), bd_(b), cvi_(cvi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
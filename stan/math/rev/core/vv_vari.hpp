@@ -13,6 +13,8 @@ class op_vv_vari : public vari {
 
  public:
   op_vv_vari(double f, vari* avi, vari* bvi) : vari(f), avi_(avi), bvi_(bvi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
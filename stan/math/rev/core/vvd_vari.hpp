@@ -15,6 +15,8 @@ class op_vvd_vari : public vari {
  public:
   op_vvd_vari(double f, vari* avi, vari* bvi, double c)
       : vari(f), avi_(avi), bvi_(bvi), cd_(c) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -15,6 +15,8 @@ class op_vvv_vari : public vari {
  public:
   op_vvv_vari(double f, vari* avi, vari* bvi, vari* cvi)
       : vari(f), avi_(avi), bvi_(bvi), cvi_(cvi) {}
+
+  bool reads_only_own_adjoint() const { return true; }
 };
 
 }  // namespace math
@@ -133,6 +133,7 @@ inline auto cholesky_lambda(T1& L_A, T2& L, T3& A) {
  */
 template <typename EigMat, require_eigen_vt<is_var, EigMat>* = nullptr>
 inline auto cholesky_decompose(const EigMat& A) {
+  const arena_tag tag("cholesky_decompose");
   check_square("cholesky_decompose", "A", A);
   arena_t<EigMat> arena_A = A;
   arena_t<Eigen::Matrix<double, -1, -1>> L_A(arena_A.val());
@@ -169,6 +170,7 @@ inline auto cholesky_decompose(const EigMat& A) {
  */
 template <typename T, require_var_matrix_t<T>* = nullptr>
 inline auto cholesky_decompose(const T& A) {
+  const arena_tag tag("cholesky_decompose");
   check_symmetric("cholesky_decompose", "A", A.val());
   plain_type_t<T> L = cholesky_decompose(A.val());
   if (A.rows() <= 35) {
@@ -44,9 +44,8 @@ namespace math {
  * @return Cosine of variable.
  */
 inline var cos(var a) {
-  return make_callback_var(std::cos(a.val()), [a](const auto& vi) mutable {
-    a.adj() -= vi.adj() * std::sin(a.val());
-  });
+  return var(
+      new precomp_v_vari(std::cos(a.val()), a.vi_, -std::sin(a.val())));
 }
 
 /**
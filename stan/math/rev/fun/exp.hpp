@@ -40,9 +40,8 @@ namespace math {
  * @return Exponentiated variable.
  */
 inline var exp(const var& a) {
-  return make_callback_var(std::exp(a.val()), [a](auto& vi) mutable {
-    a.adj() += vi.adj() * vi.val();
-  });
+  const double exp_a = std::exp(a.val());
+  return var(new precomp_v_vari(exp_a, a.vi_, exp_a));
 }
 
 /**
@@ -36,9 +36,8 @@ namespace math {
  * @return Two to the power of the specified variable.
  */
 inline var expm1(const var& a) {
-  return make_callback_var(expm1(a.val()), [a](auto& vi) mutable {
-    a.adj() += vi.adj() * (vi.val() + 1.0);
-  });
+  const double expm1_a = expm1(a.val());
+  return var(new precomp_v_vari(expm1_a, a.vi_, expm1_a + 1.0));
 }
 
 template <typename T, require_eigen_t<T>* = nullptr>
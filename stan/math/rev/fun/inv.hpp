@@ -29,10 +29,15 @@ namespace math {
  */
 template <typename T, require_stan_scalar_or_eigen_t<T>* = nullptr>
 inline auto inv(const var_value<T>& a) {
-  auto denom = to_arena(as_array_or_scalar(square(a.val())));
-  return make_callback_var(inv(a.val()), [a, denom](auto& vi) mutable {
-    as_array_or_scalar(a.adj()) -= as_array_or_scalar(vi.adj()) / denom;
-  });
+  if constexpr (is_stan_scalar<T>::value) {
+    return var(
+        new precomp_v_vari(inv(a.val()), a.vi_, -1.0 / square(a.val())));
+  } else {
+    auto denom = to_arena(as_array_or_scalar(square(a.val())));
+    return make_callback_var(inv(a.val()), [a, denom](auto& vi) mutable {
+      as_array_or_scalar(a.adj()) -= as_array_or_scalar(vi.adj()) / denom;
+    });
+  }
 }
 
 }  // namespace math
@@ -24,11 +24,17 @@ namespace math {
  */
 template <typename T, require_stan_scalar_or_eigen_t<T>* = nullptr>
 inline auto inv_logit(const var_value<T>& a) {
-  return make_callback_var(inv_logit(a.val()), [a](auto& vi) mutable {
-    as_array_or_scalar(a).adj() += as_array_or_scalar(vi.adj())
-                                   * as_array_or_scalar(vi.val())
-                                   * (1.0 - as_array_or_scalar(vi.val()));
-  });
+  if constexpr (is_stan_scalar<T>::value) {
+    const double inv_logit_a = inv_logit(a.val());
+    return var(new precomp_v_vari(inv_logit_a, a.vi_,
+                                  inv_logit_a * (1.0 - inv_logit_a)));
+  } else {
+    return make_callback_var(inv_logit(a.val()), [a](auto& vi) mutable {
+      as_array_or_scalar(a).adj() += as_array_or_scalar(vi.adj())
+                                     * as_array_or_scalar(vi.val())
+                                     * (1.0 - as_array_or_scalar(vi.val()));
+    });
+  }
 }
 
 }  // namespace math
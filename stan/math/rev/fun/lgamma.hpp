@@ -22,10 +22,14 @@ namespace math {
  */
 template <typename T, require_stan_scalar_or_eigen_t<T>* = nullptr>
 inline auto lgamma(const var_value<T>& a) {
-  return make_callback_var(lgamma(a.val()), [a](auto& vi) mutable {
-    as_array_or_scalar(a.adj())
-        += as_array_or_scalar(vi.adj()) * as_array_or_scalar(digamma(a.val()));
-  });
+  if constexpr (is_stan_scalar<T>::value) {
+    return var(new precomp_v_vari(lgamma(a.val()), a.vi_, digamma(a.val())));
+  } else {
+    return make_callback_var(lgamma(a.val()), [a](auto& vi) mutable {
+      as_array_or_scalar(a.adj()) += as_array_or_scalar(vi.adj())
+                                     * as_array_or_scalar(digamma(a.val()));
+    });
+  }
 }
 
 }  // namespace math
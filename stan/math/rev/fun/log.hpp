@@ -49,10 +49,14 @@ namespace math {
  */
 template <typename T, require_stan_scalar_or_eigen_t<T>* = nullptr>
 inline auto log(const var_value<T>& a) {
-  return make_callback_var(log(a.val()), [a](auto& vi) mutable {
-    as_array_or_scalar(a.adj())
-        += as_array_or_scalar(vi.adj()) / as_array_or_scalar(a.val());
-  });
+  if constexpr (is_stan_scalar<T>::value) {
+    return var(new precomp_v_vari(log(a.val()), a.vi_, 1.0 / a.val()));
+  } else {
+    return make_callback_var(log(a.val()), [a](auto& vi) mutable {
+      as_array_or_scalar(a.adj())
+          += as_array_or_scalar(vi.adj()) / as_array_or_scalar(a.val());
+    });
+  }
 }
 
 /**
@@ -21,10 +21,15 @@ namespace math {
  */
 template <typename T, require_stan_scalar_or_eigen_t<T>* = nullptr>
 inline auto log1p(const var_value<T>& a) {
-  return make_callback_var(log1p(a.val()), [a](auto& vi) mutable {
-    as_array_or_scalar(a.adj())
-        += as_array_or_scalar(vi.adj()) / (1.0 + as_array_or_scalar(a.val()));
-  });
+  if constexpr (is_stan_scalar<T>::value) {
+    return var(
+        new precomp_v_vari(log1p(a.val()), a.vi_, 1.0 / (1.0 + a.val())));
+  } else {
+    return make_callback_var(log1p(a.val()), [a](auto& vi) mutable {
+      as_array_or_scalar(a.adj()) += as_array_or_scalar(vi.adj())
+                                     / (1.0 + as_array_or_scalar(a.val()));
+    });
+  }
 }
 
 }  // namespace math
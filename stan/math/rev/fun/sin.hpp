@@ -44,9 +44,8 @@ namespace math {
  * @return Sine of variable.
  */
 inline var sin(const var& a) {
-  return make_callback_var(std::sin(a.val()), [a](const auto& vi) mutable {
-    a.adj() += vi.adj() * std::cos(a.val());
-  });
+  return var(
+      new precomp_v_vari(std::sin(a.val()), a.vi_, std::cos(a.val())));
 }
 
 /**
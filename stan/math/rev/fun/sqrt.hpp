@@ -42,11 +42,9 @@ namespace math {
  * @return Square root of variable.
  */
 inline var sqrt(const var& a) {
-  return make_callback_var(std::sqrt(a.val()), [a](auto& vi) mutable {
-    if (vi.val() != 0.0) {
-      a.adj() += vi.adj() / (2.0 * vi.val());
-    }
-  });
+  const double sqrt_a = std::sqrt(a.val());
+  return var(new precomp_v_vari(sqrt_a, a.vi_,
+                                sqrt_a != 0.0 ? 0.5 / sqrt_a : 0.0));
 }
 
 /**
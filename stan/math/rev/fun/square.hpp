@@ -33,9 +33,7 @@ namespace math {
  * @return Square of variable.
  */
 inline var square(const var& x) {
-  return make_callback_var(square(x.val()), [x](auto& vi) mutable {
-    x.adj() += vi.adj() * 2.0 * x.val();
-  });
+  return var(new precomp_v_vari(square(x.val()), x.vi_, 2.0 * x.val()));
 }
 
 /**
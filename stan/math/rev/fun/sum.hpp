@@ -16,6 +16,38 @@
 namespace stan {
 namespace math {
 
+namespace internal {
+/**
+ * The vari of the sum of a standard vector of `var`, whose reverse pass
+ * adds its adjoint to the adjoint of every term.
+ */
+class sum_v_vari final : public vari {
+  vari** terms_;
+  size_t size_;
+
+ public:
+  sum_v_vari(double value, vari** terms, size_t size)
+      : vari(value), terms_(terms), size_(size) {}
+
+  void chain() {
+    for (size_t i = 0; i < size_; ++i) {
+      terms_[i]->adj_ += adj_;
+    }
+  }
+
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    operands.insert(operands.end(), terms_, terms_ + size_);
+    partials.insert(partials.end(), size_, 1.0);
+    return true;
+  }
+
+  bool reads_only_own_adjoint() const { return true; }
+
+  size_t num_adjoints() const { return size_ + 1; }
+};
+}  // namespace internal
+
 /**
  * Returns the sum of the entries of the specified vector.
  *
@@ -27,10 +59,14 @@ inline var sum(const std::vector<var, Alloc>& m) {
   if (unlikely(m.empty())) {
     return 0.0;
   } else {
-    auto arena_m = to_arena(as_array_or_scalar(m));
-    return make_callback_var(arena_m.val().sum(), [arena_m](auto& vi) mutable {
-      arena_m.adj() += vi.adj();
-    });
+    vari** terms
+        = ChainableStack::instance_->memalloc_.alloc_array<vari*>(m.size());
+    double value = 0;
+    for (size_t i = 0; i < m.size(); ++i) {
+      terms[i] = m[i].vi_;
+      value += m[i].val();
+    }
+    return var(new internal::sum_v_vari(value, terms, m.size()));
   }
 }
 
@@ -40,10 +40,9 @@ namespace math {
  * @return Hyperbolic tangent of variable.
  */
 inline var tanh(const var& a) {
-  return make_callback_var(std::tanh(a.val()), [a](const auto& vi) mutable {
-    const auto a_cosh = std::cosh(a.val());
-    a.adj() += vi.adj_ / (a_cosh * a_cosh);
-  });
+  const double a_cosh = std::cosh(a.val());
+  return var(
+      new precomp_v_vari(std::tanh(a.val()), a.vi_, 1.0 / (a_cosh * a_cosh)));
 }
 
 /**
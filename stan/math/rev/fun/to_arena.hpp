@@ -57,7 +57,9 @@ inline std::remove_reference_t<T> to_arena(T&& a) {
  * AD stack or schedules its destructor to be called when AD stack memory is
  * recovered.
  *
- * Converts eigen types to `arena_matrix`.
+ * Converts eigen types to `arena_matrix`. A `pinned_data` is not copied;
+ * the returned read-only `arena_matrix<const T>` refers to the pinned
+ * memory.
  * @tparam T type of argument
  * @param a argument
  * @return argument copied/evaluated on AD stack
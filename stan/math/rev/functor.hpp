@@ -8,10 +8,12 @@
 #include <stan/math/rev/functor/apply_scalar_unary.hpp>
 #include <stan/math/rev/functor/apply_scalar_binary.hpp>
 #include <stan/math/rev/functor/apply_vector_unary.hpp>
+#include <stan/math/rev/functor/checkpointed_loop.hpp>
 #include <stan/math/rev/functor/coupled_ode_system.hpp>
 #include <stan/math/rev/functor/cvodes_integrator.hpp>
 #include <stan/math/rev/functor/cvodes_utils.hpp>
 #include <stan/math/rev/functor/gradient.hpp>
+#include <stan/math/rev/functor/gradient_batch.hpp>
 #include <stan/math/rev/functor/integrate_1d.hpp>
 #include <stan/math/rev/functor/dae.hpp>
 #include <stan/math/rev/functor/integrate_ode_adams.hpp>
@@ -28,6 +30,7 @@
 #include <stan/math/rev/functor/operands_and_partials.hpp>
 #include <stan/math/rev/functor/partials_propagator.hpp>
 #include <stan/math/rev/functor/reduce_sum.hpp>
+#include <stan/math/rev/functor/sparse_jacobian.hpp>
 #include <stan/math/rev/functor/finite_diff_hessian_auto.hpp>
 #include <stan/math/rev/functor/finite_diff_hessian_times_vector_auto.hpp>
 
@@ -0,0 +1,231 @@
+#ifndef STAN_MATH_REV_FUNCTOR_CHECKPOINTED_LOOP_HPP
+#define STAN_MATH_REV_FUNCTOR_CHECKPOINTED_LOOP_HPP
+
+#include <stan/math/rev/meta.hpp>
+#include <stan/math/rev/core.hpp>
+#include <stan/math/rev/fun/value_of.hpp>
+#include <stan/math/prim/err.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/math/prim/fun/eval.hpp>
+#include <stan/math/prim/functor/apply.hpp>
+#include <stan/math/prim/functor/checkpointed_loop.hpp>
+#include <ostream>
+#include <tuple>
+#include <utility>
+
+namespace stan {
+namespace math {
+namespace internal {
+
+/**
+ * Reverse pass of `checkpointed_loop`, recomputing the states of the
+ * loop from checkpoints by recursive bisection.
+ *
+ * @tparam F Type of step function
+ * @tparam ArgsTuple Type of the tuple holding the shared arguments
+ * @tparam ArgsValTuple Type of the tuple holding the values of the shared
+ * arguments
+ */
+template <typename F, typename ArgsTuple, typename ArgsValTuple>
+class checkpointed_loop_reverse {
+  const F& f_;
+  std::ostream* msgs_;
+  const ArgsTuple& args_;
+  const ArgsValTuple& args_val_;
+  Eigen::VectorXd& args_adj_;
+
+ public:
+  checkpointed_loop_reverse(const F& f, std::ostream* msgs,
+                            const ArgsTuple& args, const ArgsValTuple& args_val,
+                            Eigen::VectorXd& args_adj)
+      : f_(f),
+        msgs_(msgs),
+        args_(args),
+        args_val_(args_val),
+        args_adj_(args_adj) {}
+
+  /**
+   * Return the state reached from the state at step `begin` after step
+   * `end - 1`, without recording anything on the autodiff tape.
+   *
+   * @param x state at step `begin`
+   * @param begin first step
+   * @param end one past the last step
+   * @return state at step `end`
+   */
+  inline Eigen::VectorXd advance(Eigen::VectorXd x, int begin, int end) const {
+    for (int t = begin; t < end; ++t) {
+      Eigen::VectorXd x_next = math::apply(
+          [&](const auto&... args) { return f_(x, t, msgs_, args...); },
+          args_val_);
+      check_size_match("checkpointed_loop", "size of the next state",
+                       x_next.size(), "size of the state", x.size());
+      x = std::move(x_next);
+    }
+    return x;
+  }
+
+  /**
+   * Return the adjoint of the state at step `t` given the adjoint of the
+   * state at step `t + 1`, adding the adjoints of the shared arguments
+   * to `args_adj_`. The step is recorded on a nested tape.
+   *
+   * @param x state at step `t`
+   * @param t step
+   * @param x_next_adj adjoint of the state at step `t + 1`
+   * @return adjoint of the state at step `t`
+   */
+  inline Eigen::VectorXd step(const Eigen::VectorXd& x, int t,
+                              const Eigen::VectorXd& x_next_adj) const {
+    nested_rev_autodiff nested;
+    Eigen::Matrix<var, Eigen::Dynamic, 1> x_v = x;
+    auto args_copy = math::apply(
+        [](const auto&... args) {
+          return std::make_tuple(eval(deep_copy_vars(args))...);
+        },
+        args_);
+    Eigen::Matrix<var, Eigen::Dynamic, 1> x_next = math::apply(
+        [&](const auto&... args) { return f_(x_v, t, msgs_, args...); },
+        args_copy);
+    check_size_match("checkpointed_loop", "size of the next state",
+                     x_next.size(), "size of the state", x.size());
+    for (Eigen::Index i = 0; i < x_next.size(); ++i) {
+      x_next.coeffRef(i).adj() += x_next_adj.coeff(i);
+    }
+    grad();
+    math::apply(
+        [&](const auto&... args) {
+          accumulate_adjoints(args_adj_.data(), args...);
+        },
+        args_copy);
+    return x_v.adj();
+  }
+
+  /**
+   * Return the adjoint of the state at step `begin` given the adjoint of
+   * the state at step `end`. The segment is split in half; the state at
+   * the midpoint is recomputed from `x`, the second half is reversed and
+   * then the first one. Only one state per level of recursion is held,
+   * so the memory is O(log(end - begin)) states and every step is
+   * recomputed O(log(end - begin)) times.
+   *
+   * @param x state at step `begin`
+   * @param begin first step of the segment
+   * @param end one past the last step of the segment
+   * @param x_end_adj adjoint of the state at step `end`
+   * @return adjoint of the state at step `begin`
+   */
+  inline Eigen::VectorXd reverse(const Eigen::VectorXd& x, int begin, int end,
+                                 const Eigen::VectorXd& x_end_adj) const {
+    if (end - begin == 0) {
+      return x_end_adj;
+    }
+    if (end - begin == 1) {
+      return step(x, begin, x_end_adj);
+    }
+    const int mid = begin + (end - begin) / 2;
+    Eigen::VectorXd x_mid_adj
+        = reverse(advance(x, begin, mid), mid, end, x_end_adj);
+    return reverse(x, begin, mid, x_mid_adj);
+  }
+};
+
+}  // namespace internal
+
+/**
+ * Return the state reached after applying the step function `f` to the
+ * initial state `num_steps` times, that is `x_{t + 1} = f(x_t, t, msgs,
+ * args...)` for `t = 0, ..., num_steps - 1`, using checkpointed reverse
+ * mode.
+ *
+ * The step function must be callable as
+ *
+ * <code>
+ * Eigen::Matrix<T, Eigen::Dynamic, 1> operator()(
+ *     const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, int t,
+ *     std::ostream* msgs, const Args&... args) const
+ * </code>
+ *
+ * for `T` being `double` or `var`, and must return a state of the same
+ * size. Its control flow may depend on `t` and on the values of its
+ * arguments.
+ *
+ * The forward pass runs the loop on values only and puts a single
+ * callback on the autodiff tape, so the tape does not grow with the
+ * number of steps. In the reverse pass the states are recomputed by
+ * recursive bisection from the initial state and every step is taped
+ * in a nested scope just before its adjoint is needed. The reverse
+ * pass holds O(log num_steps) states and the tape of one step at a
+ * time, at the cost of running every step O(log num_steps) times.
+ *
+ * @tparam F Type of step function
+ * @tparam T_state Type of initial state
+ * @tparam Args Types of shared arguments
+ * @param f step function
+ * @param x0 initial state
+ * @param num_steps number of steps
+ * @param[in, out] msgs the print stream for warning messages
+ * @param args shared arguments passed to every step
+ * @return state after `num_steps` steps
+ * @throw std::domain_error if the number of steps is negative
+ * @throw std::invalid_argument if a step changes the size of the state
+ */
+template <typename F, typename T_state, typename... Args,
+          require_eigen_col_vector_t<T_state>* = nullptr,
+          require_any_st_var<T_state, Args...>* = nullptr>
+inline Eigen::Matrix<var, Eigen::Dynamic, 1> checkpointed_loop(
+    const F& f, const T_state& x0, int num_steps, std::ostream* msgs,
+    const Args&... args) {
+  static constexpr const char* function = "checkpointed_loop";
+  check_nonnegative(function, "number of steps", num_steps);
+
+  arena_t<T_state> arena_x0 = x0;
+  const size_t num_vars_args = count_vars(args...);
+  vari** args_varis
+      = ChainableStack::instance_->memalloc_.alloc_array<vari*>(num_vars_args);
+  save_varis(args_varis, args...);
+  // the step function and the shared arguments are kept alive until the
+  // memory of the tape is recovered
+  auto* saved = make_chainable_ptr(
+      std::make_tuple(f, std::make_tuple(plain_type_t<Args>(args)...)));
+
+  Eigen::VectorXd args_adj;
+  const auto args_val = std::make_tuple(eval(value_of(args))...);
+  internal::checkpointed_loop_reverse<F, std::decay_t<decltype(std::get<1>(
+                                             *saved))>,
+                                      std::decay_t<decltype(args_val)>>
+      loop(std::get<0>(*saved), msgs, std::get<1>(*saved), args_val, args_adj);
+  arena_t<Eigen::Matrix<var, Eigen::Dynamic, 1>> res
+      = loop.advance(value_of(arena_x0), 0, num_steps);
+
+  reverse_pass_callback([saved, msgs, arena_x0, res, args_varis,
+                         num_vars_args, num_steps]() mutable {
+    const auto args_val = math::apply(
+        [](const auto&... args) {
+          return std::make_tuple(eval(value_of(args))...);
+        },
+        std::get<1>(*saved));
+    Eigen::VectorXd args_adj = Eigen::VectorXd::Zero(num_vars_args);
+    internal::checkpointed_loop_reverse<
+        F, std::decay_t<decltype(std::get<1>(*saved))>,
+        std::decay_t<decltype(args_val)>>
+        loop(std::get<0>(*saved), msgs, std::get<1>(*saved), args_val,
+             args_adj);
+    Eigen::VectorXd x0_adj
+        = loop.reverse(value_of(arena_x0), 0, num_steps, res.adj());
+    if (!is_constant<T_state>::value) {
+      forward_as<arena_t<Eigen::Matrix<var, Eigen::Dynamic, 1>>>(arena_x0)
+          .adj()
+          += x0_adj;
+    }
+    for (size_t i = 0; i < num_vars_args; ++i) {
+      args_varis[i]->adj_ += args_adj.coeff(i);
+    }
+  });
+
+  return Eigen::Matrix<var, Eigen::Dynamic, 1>(res);
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
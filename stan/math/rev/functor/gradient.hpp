@@ -48,7 +48,10 @@ void gradient(const F& f, const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
   nested_rev_autodiff nested;
 
   Eigen::Matrix<var, Eigen::Dynamic, 1> x_var(x);
-  var fx_var = f(x_var);
+  var fx_var = [&] {
+    const trace_region region("forward pass", "autodiff");
+    return f(x_var);
+  }();
   fx = fx_var.val();
   grad_fx.resize(x.size());
   grad(fx_var.vi_);
@@ -0,0 +1,132 @@
+#ifndef STAN_MATH_REV_FUNCTOR_GRADIENT_BATCH_HPP
+#define STAN_MATH_REV_FUNCTOR_GRADIENT_BATCH_HPP
+
+#include <stan/math/rev/meta.hpp>
+#include <stan/math/rev/core.hpp>
+#include <stan/math/rev/functor/gradient.hpp>
+#include <stan/math/prim/err.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
+#include <vector>
+
+namespace stan {
+namespace math {
+
+/**
+ * Calculate the value and the gradient of the specified function at
+ * every column of the specified matrix, as used by samplers running
+ * several chains or an ensemble of particles on the same density.
+ *
+ * <p>The functor must implement
+ *
+ * <code>
+ * var operator()(const Eigen::Matrix<var, Eigen::Dynamic, 1>&)
+ * </code>
+ *
+ * and must be safe to call concurrently from several threads.
+ *
+ * <p>The columns are split into batches of `lanes` columns. The forward
+ * pass is run for every column of a batch, and the compact tapes of the
+ * columns are merged into a `compact_lane_tape`, so the reverse pass
+ * over the batch visits every node once for all its columns. The
+ * batches are evaluated in parallel, each on an AD tape taken from the
+ * pool of `pooled_chainablestack`.
+ *
+ * <p>Only functions whose tape is linear gain from the lanes. If the
+ * tape of a column records varis which cannot be linearized, the
+ * remaining columns of the batch are evaluated by calling `gradient()`,
+ * without building compact tapes, and the reverse pass of the columns
+ * evaluated so far is run over their compact tapes. If the tapes of the
+ * columns cannot be merged, because the function branches on the values
+ * of its arguments, the reverse pass is run over the compact tape of
+ * every column. In both cases there is no speedup over calling
+ * `gradient()` on every column, apart from the parallel evaluation of
+ * the batches.
+ *
+ * <p>The result is the same as calling `gradient()` on every column.
+ * The AD tape of the calling thread is not used.
+ *
+ * @tparam F Type of function
+ * @param[in] f Function
+ * @param[in] x Matrix holding one argument to the function per column
+ * @param[out] fx Function applied to every column
+ * @param[out] grad_fx Matrix holding the gradient of the function at
+ * every column
+ * @param[in] lanes Number of columns swept together by one reverse pass
+ * @throw std::domain_error if the number of lanes is not positive
+ */
+template <typename F>
+void gradient_batch(const F& f, const Eigen::MatrixXd& x, Eigen::VectorXd& fx,
+                    Eigen::MatrixXd& grad_fx, int lanes = 8) {
+  check_positive("gradient_batch", "lanes", lanes);
+  fx.resize(x.cols());
+  grad_fx.resize(x.rows(), x.cols());
+  if (x.cols() == 0) {
+    return;
+  }
+  const Eigen::Index num_batches = (x.cols() + lanes - 1) / lanes;
+  auto evaluate = [&](const tbb::blocked_range<Eigen::Index>& r) {
+    pooled_chainablestack stack;
+    stack.execute([&] {
+      for (Eigen::Index b = r.begin(); b < r.end(); ++b) {
+        const Eigen::Index begin = b * lanes;
+        const Eigen::Index end
+            = std::min<Eigen::Index>(begin + lanes, x.cols());
+        nested_rev_autodiff nested;
+        const auto& var_stack = ChainableStack::instance_->var_stack_;
+        std::vector<compact_tape> tapes;
+        std::vector<vari*> dependents;
+        std::vector<std::vector<vari*>> inputs;
+        tapes.reserve(end - begin);
+        for (Eigen::Index k = begin; k < end; ++k) {
+          const size_t first = var_stack.size();
+          Eigen::Matrix<var, Eigen::Dynamic, 1> x_var(x.col(k));
+          var fx_var = f(x_var);
+          fx.coeffRef(k) = fx_var.val();
+          tapes.emplace_back(var_stack.data() + first,
+                             var_stack.data() + var_stack.size());
+          dependents.push_back(fx_var.vi_);
+          inputs.emplace_back(x_var.size());
+          for (Eigen::Index i = 0; i < x_var.size(); ++i) {
+            inputs.back()[i] = x_var.coeff(i).vi_;
+          }
+          if (tapes.back().num_opaque() != 0) {
+            break;
+          }
+        }
+        compact_lane_tape lane_tape;
+        if (tapes.back().num_opaque() == 0
+            && tapes.size() == static_cast<size_t>(end - begin)
+            && lane_tape.build(tapes, dependents, inputs)) {
+          lane_tape.grad(grad_fx.middleCols(begin, end - begin));
+          continue;
+        }
+        for (size_t j = 0; j < tapes.size(); ++j) {
+          nested.set_zero_all_adjoints();
+          tapes[j].grad(dependents[j]);
+          for (Eigen::Index i = 0; i < x.rows(); ++i) {
+            grad_fx.coeffRef(i, begin + j) = inputs[j][i]->adj_;
+          }
+        }
+        for (Eigen::Index k = begin + tapes.size(); k < end; ++k) {
+          double fx_k;
+          Eigen::VectorXd grad_fx_k;
+          gradient(f, Eigen::VectorXd(x.col(k)), fx_k, grad_fx_k);
+          fx.coeffRef(k) = fx_k;
+          grad_fx.col(k) = grad_fx_k;
+        }
+      }
+    });
+  };
+  tbb::this_task_arena::isolate([&] {
+    tbb::parallel_for(tbb::blocked_range<Eigen::Index>(0, num_batches),
+                      evaluate);
+  });
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
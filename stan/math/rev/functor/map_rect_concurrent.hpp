@@ -2,22 +2,236 @@
 #define STAN_MATH_REV_FUNCTOR_MAP_RECT_CONCURRENT_HPP
 
 #include <stan/math/prim/meta.hpp>
+#include <stan/math/prim/core/trace_events.hpp>
 #include <stan/math/prim/fun/typedefs.hpp>
 #include <stan/math/prim/functor/map_rect_concurrent.hpp>
 #include <stan/math/prim/functor/map_rect_reduce.hpp>
 #include <stan/math/prim/functor/map_rect_combine.hpp>
-#include <stan/math/rev/core/chainablestack.hpp>
+#include <stan/math/rev/core.hpp>
 
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
+#include <tbb/task_arena.h>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 namespace stan {
 namespace math {
 namespace internal {
 
+/**
+ * AD tape holding the evaluation of a chunk of consecutive jobs of
+ * `map_rect` with var arguments. The tape is kept until the AD tape of
+ * the call is recovered, so that the reverse pass of the call runs the
+ * reverse pass over the tape of every chunk once, instead of the
+ * forward pass storing the Jacobian of every job.
+ *
+ * @tparam T_shared_scalar Scalar type of the shared parameters
+ * @tparam T_job_param Scalar type of the job specific parameters
+ */
+template <typename T_shared_scalar, typename T_job_param>
+struct map_rect_chunk_tape {
+  pooled_chainablestack stack_;
+  /**
+   * First job of the chunk.
+   */
+  std::size_t begin_{0};
+  /**
+   * One past the last job of the chunk.
+   */
+  std::size_t end_{0};
+  /**
+   * Position of the first output of the chunk in the output of the call.
+   */
+  std::size_t output_begin_{0};
+  /**
+   * Copy of the shared parameters on the tape of the chunk.
+   */
+  Eigen::Matrix<T_shared_scalar, Eigen::Dynamic, 1> shared_params_;
+  /**
+   * Copies of the job specific parameters on the tape of the chunk.
+   */
+  std::vector<Eigen::Matrix<T_job_param, Eigen::Dynamic, 1>> job_params_;
+  /**
+   * Outputs of the jobs of the chunk.
+   */
+  std::vector<vector_v> outputs_;
+  /**
+   * Adjoints of the shared parameters from the last reverse pass over
+   * the tape of the chunk.
+   */
+  vector_d shared_adjoints_;
+};
+
+/**
+ * Reverse mode `map_rect_concurrent`.
+ *
+ * The jobs are split into a few chunks of consecutive jobs per thread.
+ * Every chunk is evaluated once, as an AD task on a tape of its own (see
+ * `run_ad_task()`), which is kept with the AD tape of the call. The
+ * outputs are returned as new vars and a single callback on the AD tape
+ * of the call runs the reverse pass over the tapes of all chunks in
+ * parallel: the adjoints of the outputs of a chunk are copied to the
+ * outputs on its tape and one sweep over the tape gives the
+ * vector-Jacobian product of all jobs of the chunk. No Jacobian is
+ * stored and the outputs are not collected into an intermediate matrix.
+ *
+ * The adjoints of the shared parameters are summed over the chunks in
+ * the order of the chunks after the parallel reverse pass.
+ *
+ * @tparam F Type of job function
+ * @tparam T_shared_param Type of shared parameters
+ * @tparam T_job_param Scalar type of job specific parameters
+ * @param shared_params Shared parameters
+ * @param job_params Job specific parameters
+ * @param x_r Job specific real data
+ * @param x_i Job specific int data
+ * @param[in, out] msgs The print stream for warning messages
+ * @return Outputs of all jobs, one after the other
+ */
+template <typename F, typename T_shared_param, typename T_job_param>
+vector_v map_rect_concurrent_rev(
+    const T_shared_param& shared_params,
+    const std::vector<Eigen::Matrix<T_job_param, Eigen::Dynamic, 1>>&
+        job_params,
+    const std::vector<std::vector<double>>& x_r,
+    const std::vector<std::vector<int>>& x_i, std::ostream* msgs) {
+  using chunk_t
+      = map_rect_chunk_tape<scalar_type_t<T_shared_param>, T_job_param>;
+  const std::size_t num_jobs = job_params.size();
+  if (num_jobs == 0) {
+    return vector_v();
+  }
+
+#ifdef STAN_THREADS
+  // a few chunks per thread balance jobs of different cost
+  const std::size_t num_chunks = std::min<std::size_t>(
+      num_jobs, 4 * tbb::this_task_arena::max_concurrency());
+#else
+  const std::size_t num_chunks = 1;
+#endif
+
+  // the tapes of the chunks are returned to the pool when the AD tape
+  // of the call is recovered
+  chunk_t* chunks
+      = make_chainable_ptr(std::vector<chunk_t>(num_chunks))->data();
+
+  auto evaluate_chunk = [&](std::size_t c) {
+    chunk_t& chunk = chunks[c];
+    chunk.begin_ = num_jobs * c / num_chunks;
+    chunk.end_ = num_jobs * (c + 1) / num_chunks;
+    run_ad_task(chunk.stack_, [&] {
+      chunk.shared_params_ = deep_copy_vars(shared_params);
+      chunk.job_params_.reserve(chunk.end_ - chunk.begin_);
+      chunk.outputs_.reserve(chunk.end_ - chunk.begin_);
+      for (std::size_t i = chunk.begin_; i != chunk.end_; ++i) {
+        const trace_region region(
+            "map_rect job", "map_rect",
+            is_tracing() ? "\"job\": " + std::to_string(i) : std::string());
+        chunk.job_params_.emplace_back(deep_copy_vars(job_params[i]));
+        chunk.outputs_.emplace_back(F()(chunk.shared_params_,
+                                        chunk.job_params_.back(), x_r[i],
+                                        x_i[i], msgs));
+      }
+    });
+  };
+
+#ifdef STAN_THREADS
+  run_ad_parallel([&] {
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, num_chunks, 1),
+                      [&](const tbb::blocked_range<std::size_t>& r) {
+                        for (std::size_t c = r.begin(); c != r.end(); ++c) {
+                          evaluate_chunk(c);
+                        }
+                      });
+  });
+#else
+  evaluate_chunk(0);
+#endif
+
+  std::size_t num_outputs = 0;
+  for (std::size_t c = 0; c < num_chunks; ++c) {
+    chunks[c].output_begin_ = num_outputs;
+    for (const auto& job_output : chunks[c].outputs_) {
+      num_outputs += job_output.size();
+    }
+  }
+  arena_t<vector_v> outputs(num_outputs);
+  for (std::size_t c = 0; c < num_chunks; ++c) {
+    std::size_t k = chunks[c].output_begin_;
+    for (const auto& job_output : chunks[c].outputs_) {
+      for (Eigen::Index m = 0; m < job_output.size(); ++m) {
+        outputs.coeffRef(k++) = var(job_output.coeff(m).val());
+      }
+    }
+  }
+
+  const std::size_t num_shared_vars = count_vars(shared_params);
+  const std::size_t num_job_vars = count_vars(job_params[0]);
+  auto& memalloc = ChainableStack::instance_->memalloc_;
+  vari** shared_varis = memalloc.alloc_array<vari*>(num_shared_vars);
+  vari** job_varis = memalloc.alloc_array<vari*>(num_jobs * num_job_vars);
+  double* job_adjoints = memalloc.alloc_array<double>(num_jobs * num_job_vars);
+  save_varis(shared_varis, shared_params);
+  save_varis(job_varis, job_params);
+
+  reverse_pass_callback([outputs, chunks, num_chunks, shared_varis,
+                         num_shared_vars, job_varis, job_adjoints, num_jobs,
+                         num_job_vars]() {
+    auto sweep_chunk = [&](std::size_t c) {
+      chunk_t& chunk = chunks[c];
+      run_ad_task(chunk.stack_, [&] {
+        set_zero_all_adjoints();
+        std::size_t k = chunk.output_begin_;
+        for (auto& job_output : chunk.outputs_) {
+          for (Eigen::Index m = 0; m < job_output.size(); ++m) {
+            job_output.coeffRef(m).adj() += outputs.coeff(k++).adj();
+          }
+        }
+        grad();
+        chunk.shared_adjoints_ = vector_d::Zero(num_shared_vars);
+        accumulate_adjoints(chunk.shared_adjoints_.data(),
+                            chunk.shared_params_);
+        double* job_adjoints_chunk = job_adjoints + chunk.begin_ * num_job_vars;
+        std::fill(job_adjoints_chunk,
+                  job_adjoints + chunk.end_ * num_job_vars, 0.0);
+        for (const auto& job_param : chunk.job_params_) {
+          job_adjoints_chunk = accumulate_adjoints(job_adjoints_chunk,
+                                                   job_param);
+        }
+      });
+    };
+
+#ifdef STAN_THREADS
+    run_ad_parallel([&] {
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, num_chunks, 1),
+                        [&](const tbb::blocked_range<std::size_t>& r) {
+                          for (std::size_t c = r.begin(); c != r.end(); ++c) {
+                            sweep_chunk(c);
+                          }
+                        });
+    });
+#else
+    sweep_chunk(0);
+#endif
+
+    // the same vari may be among the shared and the job specific
+    // parameters, so the adjoints of the operands are only updated here
+    for (std::size_t c = 0; c < num_chunks; ++c) {
+      for (std::size_t j = 0; j < num_shared_vars; ++j) {
+        shared_varis[j]->adj_ += chunks[c].shared_adjoints_.coeff(j);
+      }
+    }
+    for (std::size_t n = 0; n < num_jobs * num_job_vars; ++n) {
+      job_varis[n]->adj_ += job_adjoints[n];
+    }
+  });
+
+  return outputs;
+}
+
 template <int call_id, typename F, typename T_shared_param,
           typename T_job_param, require_eigen_col_vector_t<T_shared_param>*>
 Eigen::Matrix<return_type_t<T_shared_param, T_job_param>, Eigen::Dynamic, 1>
@@ -27,55 +241,62 @@ map_rect_concurrent(
         job_params,
     const std::vector<std::vector<double>>& x_r,
     const std::vector<std::vector<int>>& x_i, std::ostream* msgs) {
-  using ReduceF
-      = map_rect_reduce<F, scalar_type_t<T_shared_param>, T_job_param>;
-  using CombineF = map_rect_combine<F, T_shared_param, T_job_param>;
-
-  const int num_jobs = job_params.size();
-  const vector_d shared_params_dbl = value_of(shared_params);
-  std::vector<matrix_d> job_output(num_jobs);
-  std::vector<int> world_f_out(num_jobs, 0);
-
-  auto execute_chunk = [&](std::size_t start, std::size_t end) -> void {
-    for (std::size_t i = start; i != end; ++i) {
-      job_output[i] = ReduceF()(shared_params_dbl, value_of(job_params[i]),
-                                x_r[i], x_i[i], msgs);
-      world_f_out[i] = job_output[i].cols();
-    }
-  };
+  if constexpr (is_var<return_type_t<T_shared_param, T_job_param>>::value) {
+    return map_rect_concurrent_rev<F>(shared_params, job_params, x_r, x_i,
+                                      msgs);
+  } else {
+    using ReduceF
+        = map_rect_reduce<F, scalar_type_t<T_shared_param>, T_job_param>;
+    using CombineF = map_rect_combine<F, T_shared_param, T_job_param>;
+
+    const int num_jobs = job_params.size();
+    const vector_d shared_params_dbl = value_of(shared_params);
+    std::vector<matrix_d> job_output(num_jobs);
+    std::vector<int> world_f_out(num_jobs, 0);
+
+    auto execute_chunk = [&](std::size_t start, std::size_t end) -> void {
+      for (std::size_t i = start; i != end; ++i) {
+        const trace_region region(
+            "map_rect job", "map_rect",
+            is_tracing() ? "\"job\": " + std::to_string(i) : std::string());
+        // jobs on doubles never touch an AD tape, so they run without
+        // taking one from the pool
+        job_output[i] = ReduceF()(shared_params_dbl, value_of(job_params[i]),
+                                  x_r[i], x_i[i], msgs);
+        world_f_out[i] = job_output[i].cols();
+      }
+    };
 
 #ifdef STAN_THREADS
-  // we must use task isolation as described here:
-  // https://software.intel.com/content/www/us/en/develop/documentation/tbb-documentation/top/intel-threading-building-blocks-developer-guide/task-isolation.html
-  // this is to ensure that the thread local AD tape ressource is
-  // not being modified from a different task which may happen
-  // whenever this function is being used itself in a parallel
-  // context (like running multiple chains for Stan)
-  tbb::this_task_arena::isolate([&] {
-    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, num_jobs),
-                      [&](const tbb::blocked_range<size_t>& r) {
-                        execute_chunk(r.begin(), r.end());
-                      });
-  });
+    // only the outermost parallel region is isolated, so map_rect nested
+    // in reduce_sum or map_rect shares the work-stealing pool with the
+    // enclosing region
+    run_ad_parallel([&] {
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, num_jobs),
+                        [&](const tbb::blocked_range<size_t>& r) {
+                          execute_chunk(r.begin(), r.end());
+                        });
+    });
 #else
-  execute_chunk(0, num_jobs);
+    execute_chunk(0, num_jobs);
 #endif
 
-  // collect results
-  const int num_world_output
-      = std::accumulate(world_f_out.begin(), world_f_out.end(), 0);
-  matrix_d world_output(job_output[0].rows(), num_world_output);
+    // collect results
+    const int num_world_output
+        = std::accumulate(world_f_out.begin(), world_f_out.end(), 0);
+    matrix_d world_output(job_output[0].rows(), num_world_output);
 
-  int offset = 0;
-  for (const auto& job : job_output) {
-    const int num_job_outputs = job.cols();
+    int offset = 0;
+    for (const auto& job : job_output) {
+      const int num_job_outputs = job.cols();
 
-    world_output.block(0, offset, world_output.rows(), num_job_outputs) = job;
+      world_output.block(0, offset, world_output.rows(), num_job_outputs) = job;
 
-    offset += num_job_outputs;
+      offset += num_job_outputs;
+    }
+    CombineF combine(shared_params, job_params);
+    return combine(world_output, world_f_out);
   }
-  CombineF combine(shared_params, job_params);
-  return combine(world_output, world_f_out);
 }
 
 }  // namespace internal
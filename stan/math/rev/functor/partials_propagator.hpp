@@ -15,6 +15,165 @@ namespace math {
 
 namespace internal {
 
+/**
+ * A contiguous run of scalar operands and their partials, held on the
+ * autodiff memory stack.
+ */
+struct partials_segment {
+  const var* operands_;
+  const double* partials_;
+  size_t size_;
+};
+
+/**
+ * The vari built by `partials_propagator` for the scalar operands of its
+ * edges. The operands and partials of every edge stay where the edge put
+ * them on the autodiff memory stack, and this vari only stores one
+ * segment per edge, so the reverse pass of a distribution can be
+ * linearized like a `stored_gradient_vari`.
+ */
+class partials_vari final : public vari {
+  size_t num_segments_;
+  partials_segment* segments_;
+
+ public:
+  /**
+   * Construct the vari with the specified value and segments.
+   *
+   * @param value value of the vari
+   * @param num_segments number of segments
+   * @param segments segments of operands and partials
+   */
+  partials_vari(double value, size_t num_segments, partials_segment* segments)
+      : vari(value), num_segments_(num_segments), segments_(segments) {}
+
+  /**
+   * Propagate the adjoint to the operands of the segments, starting
+   * from the last segment like the reverse pass callbacks of the edges.
+   */
+  void chain() {
+    for (size_t s = num_segments_; s-- > 0;) {
+      const partials_segment& seg = segments_[s];
+      for (size_t i = 0; i < seg.size_; ++i) {
+        seg.operands_[i].vi_->adj_ += adj_ * seg.partials_[i];
+      }
+    }
+  }
+
+  /**
+   * Describe the reverse pass through the operands and partials of the
+   * segments.
+   */
+  bool linearize(std::vector<vari*>& operands,
+                 std::vector<double>& partials) const {
+    for (size_t s = num_segments_; s-- > 0;) {
+      const partials_segment& seg = segments_[s];
+      for (size_t i = 0; i < seg.size_; ++i) {
+        operands.push_back(seg.operands_[i].vi_);
+      }
+      partials.insert(partials.end(), seg.partials_,
+                      seg.partials_ + seg.size_);
+    }
+    return true;
+  }
+
+  bool reads_only_own_adjoint() const { return true; }
+
+  /**
+   * Return the number of adjoints of this vari and its operands.
+   */
+  size_t num_adjoints() const {
+    size_t num = 1;
+    for (size_t s = 0; s < num_segments_; ++s) {
+      num += segments_[s].size_;
+    }
+    return num;
+  }
+};
+
+/**
+ * Return the number of segments of scalar operands of an edge. Constant
+ * operands and `var_value` matrices have none.
+ */
+template <typename Op, require_not_std_vector_t<Op>* = nullptr>
+inline constexpr size_t count_partials_segments(const Op& /* op */) noexcept {
+  return !is_var_matrix<Op>::value && (is_var<Op>::value || is_eigen<Op>::value)
+         && is_var<scalar_type_t<Op>>::value;
+}
+
+template <typename StdVec, require_std_vector_t<StdVec>* = nullptr>
+inline size_t count_partials_segments(const StdVec& op) noexcept {
+  if (is_var<value_type_t<StdVec>>::value
+      && !is_var_matrix<value_type_t<StdVec>>::value) {
+    return 1;
+  }
+  size_t num = 0;
+  for (const auto& op_i : op) {
+    num += count_partials_segments(op_i);
+  }
+  return num;
+}
+
+/**
+ * Add the segments of scalar operands of an edge, in the order counted
+ * by `count_partials_segments()`.
+ */
+template <typename Arith, typename Partial,
+          require_st_arithmetic<Arith>* = nullptr>
+inline void push_partials_segments(const Arith& /* op */,
+                                   const Partial& /* partial */,
+                                   partials_segment*& /* next */) noexcept {}
+
+template <typename VarMat, typename Partial,
+          require_var_matrix_t<VarMat>* = nullptr>
+inline void push_partials_segments(const VarMat& /* op */,
+                                   const Partial& /* partial */,
+                                   partials_segment*& /* next */) noexcept {}
+
+template <typename Scalar, require_var_t<Scalar>* = nullptr,
+          require_not_var_matrix_t<Scalar>* = nullptr>
+inline void push_partials_segments(const Scalar& op, double partial,
+                                   partials_segment*& next) {
+  auto& stack = ChainableStack::instance_->memalloc_;
+  var* op_arena = stack.alloc_array<var>(1);
+  double* partial_arena = stack.alloc_array<double>(1);
+  new (op_arena) var(op);
+  *partial_arena = partial;
+  *next++ = partials_segment{op_arena, partial_arena, 1};
+}
+
+template <typename EigMat, typename Partial,
+          require_eigen_vt<is_var, EigMat>* = nullptr>
+inline void push_partials_segments(const EigMat& op, const Partial& partial,
+                                   partials_segment*& next) noexcept {
+  *next++ = partials_segment{op.data(), partial.data(),
+                             static_cast<size_t>(op.size())};
+}
+
+template <typename StdVec, typename Partial,
+          require_std_vector_vt<is_var, StdVec>* = nullptr,
+          require_not_std_vector_vt<is_var_matrix, StdVec>* = nullptr>
+inline void push_partials_segments(const StdVec& op, const Partial& partial,
+                                   partials_segment*& next) noexcept {
+  *next++ = partials_segment{op.data(), partial.data(), op.size()};
+}
+
+template <typename StdVec, typename Partial,
+          require_std_vector_t<StdVec>* = nullptr,
+          require_not_std_vector_vt<is_var, StdVec>* = nullptr>
+inline void push_partials_segments(const StdVec& op, const Partial& partial,
+                                   partials_segment*& next) {
+  for (size_t i = 0; i < op.size(); ++i) {
+    push_partials_segments(op[i], partial[i], next);
+  }
+}
+
+template <typename StdVec, typename Partial,
+          require_std_vector_vt<is_var_matrix, StdVec>* = nullptr>
+inline void push_partials_segments(const StdVec& /* op */,
+                                   const Partial& /* partial */,
+                                   partials_segment*& /* next */) noexcept {}
+
 /** \ingroup type_trait
  * \callergraph
  * This class builds partial derivatives with respect to a set of
@@ -65,7 +224,10 @@ class partials_propagator<ReturnType, require_var_t<ReturnType>, Ops...> {
    *
    * For scalars, we don't calculate any tangents.
    * For reverse mode, we end up returning a type of var that will calculate
-   * the appropriate adjoint using the stored operands and partials.
+   * the appropriate adjoint using the stored operands and partials. The
+   * scalar operands of all edges are held by a single `partials_vari`,
+   * which can be linearized; edges holding `var_value` matrices add a
+   * reverse pass callback each.
    * Forward mode just calculates the tangent on the spot and returns it in
    * a vanilla fvar.
    *
@@ -73,12 +235,33 @@ class partials_propagator<ReturnType, require_var_t<ReturnType>, Ops...> {
    * @return the node to be stored in the expression graph for autodiff
    */
   inline var build(double value) {
-    var ret(value);
+    size_t num_segments = 0;
+    stan::math::for_each(
+        [&num_segments](auto&& edge) {
+          num_segments += count_partials_segments(edge.operand());
+        },
+        edges_);
+    partials_segment* segments
+        = ChainableStack::instance_->memalloc_.alloc_array<partials_segment>(
+            num_segments);
+    partials_segment* next = segments;
+    stan::math::for_each(
+        [&next](auto&& edge) {
+          push_partials_segments(edge.operand(), edge.partial(), next);
+        },
+        edges_);
+    var ret = num_segments == 0
+                  ? var(value)
+                  : var(new partials_vari(value, num_segments, segments));
     stan::math::for_each(
         [ret](auto&& edge) mutable {
-          reverse_pass_callback(
-              [operand = edge.operand(), partial = edge.partial(),
-               ret]() mutable { update_adjoints(operand, partial, ret); });
+          using op_t = std::decay_t<decltype(edge.operand())>;
+          if (is_var_matrix<op_t>::value
+              || is_var_matrix<value_type_t<op_t>>::value) {
+            reverse_pass_callback(
+                [operand = edge.operand(), partial = edge.partial(),
+                 ret]() mutable { update_adjoints(operand, partial, ret); });
+          }
         },
         edges_);
     return ret;
@@ -8,7 +8,9 @@
 #include <tbb/task_arena.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
 
+#include <initializer_list>
 #include <tuple>
 #include <memory>
 #include <utility>
@@ -18,6 +20,179 @@ namespace stan {
 namespace math {
 namespace internal {
 
+/**
+ * Return the copy of a shared argument of `reduce_sum` used by the
+ * reducers running on one thread. Arguments without vars are
+ * referenced and vars are copied to new varis by `deep_copy_vars()`.
+ *
+ * @tparam T Type of shared argument
+ * @param arg Shared argument
+ * @return Copy of the argument
+ */
+template <typename T, require_not_var_matrix_t<T>* = nullptr>
+inline decltype(auto) local_shared_arg(T&& arg) {
+  return deep_copy_vars(std::forward<T>(arg));
+}
+
+/**
+ * Return the copy of a `var_value<Matrix>` shared argument of
+ * `reduce_sum` used by the reducers running on one thread. The copy
+ * refers to the values of the argument in place and has adjoints of its
+ * own, allocated on the current AD tape, in which the reducers of the
+ * thread accumulate their adjoints.
+ *
+ * The reducers must not modify the values of the argument.
+ *
+ * @tparam T Type of shared argument
+ * @param arg Shared argument
+ * @return Copy of the argument
+ */
+template <typename T, require_var_matrix_t<T>* = nullptr>
+inline auto local_shared_arg(const T& arg) {
+  using plain_t = plain_type_t<value_type_t<std::decay_t<T>>>;
+  arena_matrix<plain_t> adj(arg.rows(), arg.cols());
+  adj.setZero();
+  return var_value<plain_t>(arena_matrix<plain_t>(arg.vi_->val_), adj);
+}
+
+/**
+ * Return the number of scalar vars in a shared argument of `reduce_sum`.
+ * The adjoints of `var_value<Matrix>` arguments are propagated apart from
+ * the scalar vars, so these count zero.
+ *
+ * @tparam T Type of shared argument
+ * @param arg Shared argument
+ */
+template <typename T, require_not_var_matrix_t<T>* = nullptr>
+inline size_t count_shared_scalar_vars(T&& arg) {
+  return count_vars(arg);
+}
+
+template <typename T, require_var_matrix_t<T>* = nullptr>
+inline size_t count_shared_scalar_vars(T&&) {
+  return 0;
+}
+
+/**
+ * Return the number of elements of a `var_value<Matrix>` shared argument
+ * of `reduce_sum`, or zero for other arguments.
+ *
+ * @tparam T Type of shared argument
+ * @param arg Shared argument
+ */
+template <typename T, require_not_var_matrix_t<T>* = nullptr>
+inline size_t count_shared_matrix_vars(T&&) {
+  return 0;
+}
+
+template <typename T, require_var_matrix_t<T>* = nullptr>
+inline size_t count_shared_matrix_vars(T&& arg) {
+  return arg.size();
+}
+
+/**
+ * Save the varis of the scalar vars in a shared argument of `reduce_sum`
+ * and return the next position of the storage pointer.
+ *
+ * @tparam T Type of shared argument
+ * @param dest Pointer to where the varis are saved
+ * @param arg Shared argument
+ * @return Next position of the storage pointer
+ */
+template <typename T, require_not_var_matrix_t<T>* = nullptr>
+inline vari** save_shared_varis(vari** dest, T&& arg) {
+  return save_varis(dest, arg);
+}
+
+template <typename T, require_var_matrix_t<T>* = nullptr>
+inline vari** save_shared_varis(vari** dest, T&&) {
+  return dest;
+}
+
+/**
+ * Positions in the adjoints of the shared arguments of `reduce_sum`. The
+ * adjoints of all scalar vars come first, followed by the adjoints of
+ * the elements of all `var_value<Matrix>` arguments.
+ */
+struct shared_adjoints_cursor {
+  double* scalars_;
+  double* matrices_;
+};
+
+/**
+ * Accumulate the adjoints of a shared argument of `reduce_sum` and
+ * advance the cursor past them.
+ *
+ * @tparam T Type of shared argument
+ * @param dest Positions of the adjoints of the argument
+ * @param arg Shared argument
+ */
+template <typename T, require_not_var_matrix_t<T>* = nullptr>
+inline void accumulate_shared_arg_adjoints(shared_adjoints_cursor& dest,
+                                           T&& arg) {
+  dest.scalars_ = accumulate_adjoints(dest.scalars_, arg);
+}
+
+template <typename T, require_var_matrix_t<T>* = nullptr>
+inline void accumulate_shared_arg_adjoints(shared_adjoints_cursor& dest,
+                                           T&& arg) {
+  using plain_t = plain_type_t<value_type_t<std::decay_t<T>>>;
+  Eigen::Map<plain_t>(dest.matrices_, arg.rows(), arg.cols()) += arg.adj();
+  dest.matrices_ += arg.size();
+}
+
+/**
+ * Accumulate the adjoints of the copies of the shared arguments of
+ * `reduce_sum` used on one thread.
+ *
+ * @tparam Args Types of the copies of the shared arguments
+ * @param dest Pointer to the adjoints of the shared arguments
+ * @param num_scalar_vars Number of scalar vars in the shared arguments
+ * @param args_tuple Copies of the shared arguments
+ */
+template <typename... Args>
+inline void accumulate_shared_adjoints(double* dest, size_t num_scalar_vars,
+                                       const std::tuple<Args...>& args_tuple) {
+  shared_adjoints_cursor cursor{dest, dest + num_scalar_vars};
+  math::apply(
+      [&](auto&&... args) {
+        static_cast<void>(std::initializer_list<int>{
+            (accumulate_shared_arg_adjoints(cursor, args), 0)...});
+      },
+      args_tuple);
+}
+
+/**
+ * Propagate the adjoint of the sum computed by `reduce_sum` to a
+ * `var_value<Matrix>` shared argument in the reverse pass, and return the
+ * position of the partials of the next such argument.
+ *
+ * @tparam T Type of shared argument
+ * @param sum Sum computed by `reduce_sum`
+ * @param partials Partials of the sum with respect to the elements of the
+ * argument, allocated on the AD tape
+ * @param arg Shared argument
+ * @return Position of the partials of the next argument
+ */
+template <typename T, require_not_var_matrix_t<T>* = nullptr>
+inline const double* chain_shared_matrix_adjoints(const var&,
+                                                  const double* partials,
+                                                  T&&) {
+  return partials;
+}
+
+template <typename T, require_var_matrix_t<T>* = nullptr>
+inline const double* chain_shared_matrix_adjoints(const var& sum,
+                                                  const double* partials,
+                                                  T&& arg) {
+  using plain_t = plain_type_t<value_type_t<std::decay_t<T>>>;
+  reverse_pass_callback([sum, partials, arg]() mutable {
+    arg.adj() += sum.adj()
+                 * Eigen::Map<const plain_t>(partials, arg.rows(), arg.cols());
+  });
+  return partials + arg.size();
+}
+
 /**
  * Var specialization of reduce_sum_impl
  *
@@ -30,14 +205,24 @@ template <typename ReduceFunction, typename ReturnType, typename Vec,
           typename... Args>
 struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
                        Vec, Args...> {
+  /**
+   * Copy of the shared arguments on an AD tape taken from the pool of
+   * `pooled_chainablestack`. There is one copy per thread and call of
+   * `reduce_sum`, shared by all reducers running on that thread. Only
+   * scalar vars are copied; arguments without vars are referenced and
+   * `var_value<Matrix>` arguments share their values with the
+   * arguments, see `local_shared_arg()`.
+   */
   struct scoped_args_tuple {
-    ScopedChainableStack stack_;
+    pooled_chainablestack stack_;
     using args_tuple_t
-        = std::tuple<decltype(deep_copy_vars(std::declval<Args>()))...>;
+        = std::tuple<decltype(local_shared_arg(std::declval<Args&>()))...>;
     std::unique_ptr<args_tuple_t> args_tuple_holder_;
 
     scoped_args_tuple() : stack_(), args_tuple_holder_(nullptr) {}
   };
+  using local_args_tuples_t
+      = tbb::enumerable_thread_specific<scoped_args_tuple>;
 
   /**
    * This struct is used by the TBB to accumulate partial
@@ -46,27 +231,38 @@ struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
    *  case the splitting copy constructor is used. It is designed to
    *  meet the Imperative form requirements of `tbb::parallel_reduce`.
    *
+   * The reducers refer to the sliced and shared arguments of the call,
+   *  so splitting a reducer does not copy them.
+   *
    * @note see link [here](https://tinyurl.com/vp7xw2t) for requirements.
    */
   struct recursive_reducer {
     const size_t num_vars_per_term_;
     const size_t num_vars_shared_terms_;  // Number of vars in shared arguments
+    const size_t num_shared_adjoints_;  // Including var_value<Matrix> elements
+    // Accumulate adjoints of shared arguments per thread, not per reducer
+    const bool per_thread_adjoints_;
     double* sliced_partials_;  // Points to adjoints of the partial calculations
-    Vec vmapped_;
+    const std::decay_t<Vec>& vmapped_;
     std::stringstream msgs_;
-    std::tuple<Args...> args_tuple_;
-    scoped_args_tuple local_args_tuple_scope_;
+    std::tuple<Args&...> args_tuple_;
+    local_args_tuples_t& local_args_tuples_;
     double sum_{0.0};
     Eigen::VectorXd args_adjoints_{0};
 
-    template <typename VecT, typename... ArgsT>
     recursive_reducer(size_t num_vars_per_term, size_t num_vars_shared_terms,
-                      double* sliced_partials, VecT&& vmapped, ArgsT&&... args)
+                      size_t num_shared_adjoints, bool per_thread_adjoints,
+                      double* sliced_partials,
+                      local_args_tuples_t& local_args_tuples,
+                      const std::decay_t<Vec>& vmapped, Args&... args)
         : num_vars_per_term_(num_vars_per_term),
           num_vars_shared_terms_(num_vars_shared_terms),
+          num_shared_adjoints_(num_shared_adjoints),
+          per_thread_adjoints_(per_thread_adjoints),
           sliced_partials_(sliced_partials),
-          vmapped_(std::forward<VecT>(vmapped)),
-          args_tuple_(std::forward<ArgsT>(args)...) {}
+          vmapped_(vmapped),
+          args_tuple_(args...),
+          local_args_tuples_(local_args_tuples) {}
 
     /*
      * This is the copy operator as required for tbb::parallel_reduce
@@ -77,91 +273,112 @@ struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
     recursive_reducer(recursive_reducer& other, tbb::split)
         : num_vars_per_term_(other.num_vars_per_term_),
           num_vars_shared_terms_(other.num_vars_shared_terms_),
+          num_shared_adjoints_(other.num_shared_adjoints_),
+          per_thread_adjoints_(other.per_thread_adjoints_),
           sliced_partials_(other.sliced_partials_),
           vmapped_(other.vmapped_),
-          args_tuple_(other.args_tuple_) {}
+          args_tuple_(other.args_tuple_),
+          local_args_tuples_(other.local_args_tuples_) {}
 
     /**
-     * Compute, using nested autodiff, the value and Jacobian of
+     * Compute, using autodiff on an AD tape of its own (see
+     *  `run_ad_task()`), the value and Jacobian of
      *  `ReduceFunction` called over the range defined by r and accumulate those
      *  in member variable sum_ (for the value) and args_adjoints_ (for the
-     *  Jacobian). The nested autodiff uses deep copies of the involved operands
+     *  Jacobian). The autodiff uses deep copies of the involved operands
      *  ensuring that no side effects are implied to the adjoints of the input
      *  operands which reside potentially on a autodiff tape stored in a
      *  different thread other than the current thread of execution. This
      * function may be called multiple times per object instantiation (so the
      * sum_ and args_adjoints_ must be accumulated, not just assigned).
      *
+     * If `per_thread_adjoints_` is true, the adjoints of the shared
+     *  arguments are left to accumulate in the copies of the current
+     *  thread over all ranges it computes, and args_adjoints_ is not used.
+     *
+     * @tparam Range `tbb::blocked_range<size_t>` or `cost_range`
      * @param r Range over which to compute reduce_sum
      */
-    inline void operator()(const tbb::blocked_range<size_t>& r) {
+    template <typename Range>
+    inline void operator()(const Range& r) {
       if (r.empty()) {
         return;
       }
 
-      if (args_adjoints_.size() == 0) {
-        args_adjoints_ = Eigen::VectorXd::Zero(num_vars_shared_terms_);
+      const trace_region region("reduce_sum chunk", "reduce_sum",
+                                reduce_sum_trace_args(r.begin(), r.end()));
+      const chunk_timer<Range> timer(r);
+
+      if (!per_thread_adjoints_ && args_adjoints_.size() == 0) {
+        args_adjoints_ = Eigen::VectorXd::Zero(num_shared_adjoints_);
       }
 
       // Obtain reference to a local copy of all shared arguments that do
       // not point
       //   back to main autodiff stack
+      scoped_args_tuple& local_args_tuple_scope = local_args_tuples_.local();
 
-      if (!local_args_tuple_scope_.args_tuple_holder_) {
-        // shared arguments need to be copied to reducer-specific
-        // scope. In this case no need for zeroing adjoints, since the
-        // fresh copy has all adjoints set to zero.
-        local_args_tuple_scope_.stack_.execute([&]() {
+      if (!local_args_tuple_scope.args_tuple_holder_) {
+        // shared arguments need to be copied to thread-specific
+        // scope. The fresh copy has all adjoints set to zero.
+        local_args_tuple_scope.stack_.execute([&]() {
           math::apply(
               [&](auto&&... args) {
-                local_args_tuple_scope_.args_tuple_holder_ = std::make_unique<
+                local_args_tuple_scope.args_tuple_holder_ = std::make_unique<
                     typename scoped_args_tuple::args_tuple_t>(
-                    deep_copy_vars(args)...);
+                    local_shared_arg(args)...);
               },
               args_tuple_);
         });
-      } else {
-        // set adjoints of shared arguments to zero
-        local_args_tuple_scope_.stack_.execute([] { set_zero_all_adjoints(); });
       }
 
-      auto& args_tuple_local = *(local_args_tuple_scope_.args_tuple_holder_);
-
-      // Initialize nested autodiff stack
-      const nested_rev_autodiff begin_nest;
-
-      // Create nested autodiff copies of sliced argument that do not point
-      //   back to main autodiff stack
-      std::decay_t<Vec> local_sub_slice;
-      local_sub_slice.reserve(r.size());
-      for (size_t i = r.begin(); i < r.end(); ++i) {
-        local_sub_slice.emplace_back(deep_copy_vars(vmapped_[i]));
-      }
-
-      // Perform calculation
-      var sub_sum_v = math::apply(
-          [&](auto&&... args) {
-            return ReduceFunction()(local_sub_slice, r.begin(), r.end() - 1,
-                                    &msgs_, args...);
-          },
-          args_tuple_local);
-
-      // Compute Jacobian
-      sub_sum_v.grad();
-
-      // Accumulate value of reduce_sum
-      sum_ += sub_sum_v.val();
-
-      // Accumulate adjoints of sliced_arguments
-      accumulate_adjoints(sliced_partials_ + r.begin() * num_vars_per_term_,
-                          std::move(local_sub_slice));
-
-      // Accumulate adjoints of shared_arguments
-      math::apply(
-          [&](auto&&... args) {
-            accumulate_adjoints(args_adjoints_.data(), args...);
-          },
-          args_tuple_local);
+      auto& args_tuple_local = *(local_args_tuple_scope.args_tuple_holder_);
+
+      // Run the range on an AD tape of its own, so that a thread waiting
+      //   for a parallel region nested in the calculation can run other
+      //   ranges in the meantime
+      run_ad_task([&] {
+        // Create nested autodiff copies of sliced argument that do not
+        //   point back to main autodiff stack
+        std::decay_t<Vec> local_sub_slice;
+        local_sub_slice.reserve(r.size());
+        for (size_t i = r.begin(); i < r.end(); ++i) {
+          local_sub_slice.emplace_back(deep_copy_vars(vmapped_[i]));
+        }
+
+        // Perform calculation
+        var sub_sum_v = math::apply(
+            [&](auto&&... args) {
+              return ReduceFunction()(local_sub_slice, r.begin(), r.end() - 1,
+                                      &msgs_, args...);
+            },
+            args_tuple_local);
+
+        if (per_thread_adjoints_) {
+          // Compute Jacobian
+          sub_sum_v.grad();
+        } else {
+          // Other ranges run on this thread while the calculation waits
+          //   for a nested parallel region share the copies of the
+          //   shared arguments, so their adjoints are zeroed, computed
+          //   and accumulated without running other tasks in between
+          tbb::this_task_arena::isolate([&] {
+            local_args_tuple_scope.stack_.execute(
+                [] { set_zero_all_adjoints(); });
+            sub_sum_v.grad();
+            accumulate_shared_adjoints(args_adjoints_.data(),
+                                       num_vars_shared_terms_,
+                                       args_tuple_local);
+          });
+        }
+
+        // Accumulate value of reduce_sum
+        sum_ += sub_sum_v.val();
+
+        // Accumulate adjoints of sliced_arguments
+        accumulate_adjoints(sliced_partials_ + r.begin() * num_vars_per_term_,
+                            std::move(local_sub_slice));
+      });
     }
 
     /**
@@ -205,6 +422,12 @@ struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
    * of that sum over multiple threads by coordinating calls to `ReduceFunction`
    * instances. Results are stored as precomputed varis in the autodiff tree.
    *
+   * Shared arguments are not copied per piece of work. Every thread works
+   *  on one copy of the vars in the shared arguments, which refers to
+   *  the values of `var_value<Matrix>` arguments in place, and the
+   *  adjoints accumulated in the copies of all threads are summed once
+   *  at the end.
+   *
    * If auto partitioning is true, break work into pieces automatically,
    *  taking grainsize as a recommended work size. The partitioning is
    *  not deterministic nor is the order guaranteed in which partial
@@ -212,7 +435,9 @@ struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
    *  lead to slight differences in the accumulated results between
    *  multiple runs. If false, break work deterministically into pieces smaller
    *  than or equal to grainsize and accumulate all the partial sums
-   *  in the same order. This still may not achieve bitwise reproducibility.
+   *  in the same order. In this case the adjoints of the shared
+   *  arguments are accumulated per piece of work in the same order as
+   *  the partial sums. This still may not achieve bitwise reproducibility.
    *
    * @param vmapped Vector containing one element per term of sum
    * @param auto_partitioning Work partitioning style
@@ -223,6 +448,72 @@ struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
    */
   inline var operator()(Vec&& vmapped, bool auto_partitioning, int grainsize,
                         std::ostream* msgs, Args&&... args) const {
+    const std::size_t num_terms = vmapped.size();
+    return reduce(
+        vmapped, msgs, auto_partitioning,
+        [&](recursive_reducer& worker) {
+          if (auto_partitioning) {
+            tbb::parallel_reduce(
+                tbb::blocked_range<std::size_t>(0, num_terms, grainsize),
+                worker);
+          } else {
+            tbb::simple_partitioner partitioner;
+            tbb::parallel_deterministic_reduce(
+                tbb::blocked_range<std::size_t>(0, num_terms, grainsize),
+                worker, partitioner);
+          }
+        },
+        args...);
+  }
+
+  /**
+   * Call an instance of the function `ReduceFunction` on every chunk of
+   *   the specified partition of an input sequence and sum these terms.
+   *   The chunks and the order in which the partial sums and the
+   *   adjoints of the shared arguments are accumulated depend only on
+   *   the partition.
+   *
+   * @param vmapped Vector containing one element per term of sum
+   * @param bounds Bounds of the chunks, as returned by
+   *   `partition_by_cost()`
+   * @param chunk_seconds Array receiving the time taken by every chunk,
+   *   or `nullptr`
+   * @param[in, out] msgs The print stream for warning messages
+   * @param args Shared arguments used in every sum term
+   * @return Summation of all terms
+   */
+  inline var operator()(Vec&& vmapped, const std::vector<size_t>& bounds,
+                        double* chunk_seconds, std::ostream* msgs,
+                        Args&&... args) const {
+    return reduce(
+        vmapped, msgs, false,
+        [&](recursive_reducer& worker) {
+          tbb::simple_partitioner partitioner;
+          tbb::parallel_deterministic_reduce(
+              cost_range(bounds, chunk_seconds), worker, partitioner);
+        },
+        args...);
+  }
+
+ private:
+  /**
+   * Sum the terms with the specified reduction over the terms and
+   *   store the result with its Jacobian on the AD tape.
+   *
+   * @tparam RunReduce Type of the reduction
+   * @param vmapped Vector containing one element per term of sum
+   * @param[in, out] msgs The print stream for warning messages
+   * @param per_thread_adjoints Accumulate the adjoints of the shared
+   *   arguments per thread rather than per piece of work
+   * @param run_reduce Callable running the TBB reduction with the
+   *   reducer it is given
+   * @param args Shared arguments used in every sum term
+   * @return Summation of all terms
+   */
+  template <typename RunReduce>
+  inline var reduce(const std::decay_t<Vec>& vmapped, std::ostream* msgs,
+                    bool per_thread_adjoints, RunReduce&& run_reduce,
+                    Args&... args) const {
     if (vmapped.empty()) {
       return var(0.0);
     }
@@ -230,53 +521,74 @@ struct reduce_sum_impl<ReduceFunction, require_var_t<ReturnType>, ReturnType,
     const std::size_t num_terms = vmapped.size();
     const std::size_t num_vars_per_term = count_vars(vmapped[0]);
     const std::size_t num_vars_sliced_terms = num_terms * num_vars_per_term;
-    const std::size_t num_vars_shared_terms = count_vars(args...);
+    std::size_t num_vars_shared_terms = 0;
+    std::size_t num_shared_matrix_vars = 0;
+    static_cast<void>(std::initializer_list<int>{
+        (num_vars_shared_terms += count_shared_scalar_vars(args),
+         num_shared_matrix_vars += count_shared_matrix_vars(args), 0)...});
+    const std::size_t num_shared_adjoints
+        = num_vars_shared_terms + num_shared_matrix_vars;
 
     vari** varis = ChainableStack::instance_->memalloc_.alloc_array<vari*>(
         num_vars_sliced_terms + num_vars_shared_terms);
+    // the partials of the elements of var_value<Matrix> arguments follow
+    // those of the scalar vars
     double* partials = ChainableStack::instance_->memalloc_.alloc_array<double>(
-        num_vars_sliced_terms + num_vars_shared_terms);
+        num_vars_sliced_terms + num_shared_adjoints);
 
     save_varis(varis, vmapped);
-    save_varis(varis + num_vars_sliced_terms, args...);
+    vari** shared_varis = varis + num_vars_sliced_terms;
+    static_cast<void>(std::initializer_list<int>{
+        (shared_varis = save_shared_varis(shared_varis, args), 0)...});
 
-    for (size_t i = 0; i < num_vars_sliced_terms; ++i) {
+    for (size_t i = 0; i < num_vars_sliced_terms + num_shared_adjoints; ++i) {
       partials[i] = 0.0;
     }
 
-    recursive_reducer worker(num_vars_per_term, num_vars_shared_terms, partials,
-                             std::forward<Vec>(vmapped),
-                             std::forward<Args>(args)...);
-
-    // we must use task isolation as described here:
-    // https://software.intel.com/content/www/us/en/develop/documentation/tbb-documentation/top/intel-threading-building-blocks-developer-guide/task-isolation.html
-    // this is to ensure that the thread local AD tape ressource is
-    // not being modified from a different task which may happen
-    // whenever this function is being used itself in a parallel
-    // context (like running multiple chains for Stan)
-    tbb::this_task_arena::isolate([&] {
-      if (auto_partitioning) {
-        tbb::parallel_reduce(
-            tbb::blocked_range<std::size_t>(0, num_terms, grainsize), worker);
-      } else {
-        tbb::simple_partitioner partitioner;
-        tbb::parallel_deterministic_reduce(
-            tbb::blocked_range<std::size_t>(0, num_terms, grainsize), worker,
-            partitioner);
+    // the shared arguments are copied once per thread; the AD tapes
+    // holding the copies are taken from and returned to a process wide
+    // pool, so their memory is reused across calls
+    local_args_tuples_t local_args_tuples;
+
+    recursive_reducer worker(num_vars_per_term, num_vars_shared_terms,
+                             num_shared_adjoints, per_thread_adjoints,
+                             partials, local_args_tuples, vmapped, args...);
+
+    // every range runs on an AD tape of its own; only the outermost
+    // parallel region is isolated, so reduce_sum nested in reduce_sum or
+    // map_rect shares the work-stealing pool with the enclosing region
+    run_ad_parallel([&] { run_reduce(worker); });
+
+    double* shared_partials = partials + num_vars_sliced_terms;
+    if (per_thread_adjoints) {
+      for (auto& local_args_tuple_scope : local_args_tuples) {
+        if (local_args_tuple_scope.args_tuple_holder_) {
+          accumulate_shared_adjoints(
+              shared_partials, num_vars_shared_terms,
+              *(local_args_tuple_scope.args_tuple_holder_));
+        }
+      }
+    } else {
+      for (size_t i = 0; i < num_shared_adjoints; ++i) {
+        shared_partials[i] = worker.args_adjoints_.coeff(i);
       }
-    });
-
-    for (size_t i = 0; i < num_vars_shared_terms; ++i) {
-      partials[num_vars_sliced_terms + i] = worker.args_adjoints_.coeff(i);
     }
 
     if (msgs) {
       *msgs << worker.msgs_.str();
     }
 
-    return var(new precomputed_gradients_vari(
+    var sum(new precomputed_gradients_vari(
         worker.sum_, num_vars_sliced_terms + num_vars_shared_terms, varis,
         partials));
+
+    const double* matrix_partials = shared_partials + num_vars_shared_terms;
+    static_cast<void>(std::initializer_list<int>{
+        (matrix_partials
+         = chain_shared_matrix_adjoints(sum, matrix_partials, args),
+         0)...});
+
+    return sum;
   }
 };
 }  // namespace internal
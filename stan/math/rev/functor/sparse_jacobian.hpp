@@ -0,0 +1,287 @@
+#ifndef STAN_MATH_REV_FUNCTOR_SPARSE_JACOBIAN_HPP
+#define STAN_MATH_REV_FUNCTOR_SPARSE_JACOBIAN_HPP
+
+#include <stan/math/rev/meta.hpp>
+#include <stan/math/rev/core.hpp>
+#include <stan/math/prim/err.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace stan {
+namespace math {
+namespace internal {
+
+/**
+ * Find the structural sparsity pattern of the Jacobian of the outputs
+ * with respect to the inputs by propagating the sets of inputs every
+ * vari depends on forward through the linearized tape of the current
+ * nested scope. An entry is part of the pattern if the output is
+ * connected to the input on the tape, even if the partial derivative
+ * happens to be zero at the current point.
+ *
+ * Opaque varis, such as reverse pass callbacks, do not expose their
+ * operands and results. They are traced conservatively: a vari which is
+ * neither an input nor the result of a linear record, and which is used
+ * after an opaque vari on the tape, may be the result of the callback
+ * and depends on all inputs, as does such an output.
+ *
+ * @param x_var inputs
+ * @param fx_var outputs
+ * @param[out] pattern columns of the nonzero entries of every row
+ */
+inline void trace_jacobian_sparsity(
+    const Eigen::Matrix<var, Eigen::Dynamic, 1>& x_var,
+    const Eigen::Matrix<var, Eigen::Dynamic, 1>& fx_var,
+    std::vector<std::vector<int>>& pattern) {
+  const compact_tape tape;
+  std::unordered_map<const vari*, std::vector<int>> deps;
+  for (Eigen::Index j = 0; j < x_var.size(); ++j) {
+    deps[x_var.coeff(j).vi_].push_back(j);
+  }
+  std::vector<int> all_inputs(x_var.size());
+  for (Eigen::Index j = 0; j < x_var.size(); ++j) {
+    all_inputs[j] = j;
+  }
+  const auto& records = tape.linear_records();
+  const auto& operands = tape.operands();
+  bool after_opaque = false;
+  std::vector<int> merged;
+  for (const auto& r : tape.runs()) {
+    if (r.kind_ == compact_tape::run_kind::opaque) {
+      after_opaque = true;
+      continue;
+    }
+    for (size_t i = r.begin_; i < r.end_; ++i) {
+      const auto& rec = records[i];
+      merged.clear();
+      for (std::uint32_t k = rec.begin_; k < rec.end_; ++k) {
+        auto it = deps.find(operands[k]);
+        if (it != deps.end()) {
+          merged.insert(merged.end(), it->second.begin(), it->second.end());
+        } else if (after_opaque) {
+          merged = all_inputs;
+          break;
+        }
+      }
+      if (!merged.empty()) {
+        std::sort(merged.begin(), merged.end());
+        merged.erase(std::unique(merged.begin(), merged.end()),
+                     merged.end());
+        deps[rec.out_] = merged;
+      }
+    }
+  }
+  pattern.assign(fx_var.size(), std::vector<int>());
+  for (Eigen::Index i = 0; i < fx_var.size(); ++i) {
+    auto it = deps.find(fx_var.coeff(i).vi_);
+    if (it != deps.end()) {
+      pattern[i] = it->second;
+    } else if (after_opaque) {
+      pattern[i] = all_inputs;
+    }
+  }
+}
+
+/**
+ * Group the rows of a sparsity pattern such that no two rows of a group
+ * have a nonzero entry in the same column, using greedy distance-1
+ * coloring of the row intersection graph. Rows without nonzero entries
+ * are not put in any group.
+ *
+ * @param pattern columns of the nonzero entries of every row
+ * @param num_cols number of columns
+ * @return rows of every group
+ */
+inline std::vector<std::vector<int>> color_jacobian_rows(
+    const std::vector<std::vector<int>>& pattern, int num_cols) {
+  std::vector<std::vector<int>> col_rows(num_cols);
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    for (int j : pattern[i]) {
+      col_rows[j].push_back(i);
+    }
+  }
+  std::vector<int> color(pattern.size(), -1);
+  // forbidden[c] == i if color c is taken by a neighbor of row i
+  std::vector<int> forbidden;
+  std::vector<std::vector<int>> groups;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i].empty()) {
+      continue;
+    }
+    for (int j : pattern[i]) {
+      for (int k : col_rows[j]) {
+        if (color[k] >= 0) {
+          forbidden[color[k]] = i;
+        }
+      }
+    }
+    size_t c = 0;
+    while (c < groups.size() && forbidden[c] == static_cast<int>(i)) {
+      ++c;
+    }
+    if (c == groups.size()) {
+      groups.emplace_back();
+      forbidden.push_back(-1);
+    }
+    color[i] = c;
+    groups[c].push_back(i);
+  }
+  return groups;
+}
+
+/**
+ * Compute the Jacobian with the specified sparsity pattern by one
+ * reverse pass per group of structurally orthogonal rows. The adjoints
+ * of all outputs of a group are seeded together; since their rows have
+ * no column in common, the adjoint of every input in the pattern of a
+ * row is the entry of that row.
+ *
+ * @param nested nested scope holding the tape of the function
+ * @param x_var inputs
+ * @param fx_var outputs
+ * @param pattern columns of the nonzero entries of every row
+ * @param[out] J Jacobian
+ */
+inline void colored_sparse_jacobian(
+    nested_rev_autodiff& nested,
+    const Eigen::Matrix<var, Eigen::Dynamic, 1>& x_var,
+    const Eigen::Matrix<var, Eigen::Dynamic, 1>& fx_var,
+    const std::vector<std::vector<int>>& pattern,
+    Eigen::SparseMatrix<double>& J) {
+  std::vector<Eigen::Triplet<double>> triplets;
+  size_t nnz = 0;
+  for (const auto& row : pattern) {
+    nnz += row.size();
+  }
+  triplets.reserve(nnz);
+  for (const auto& group : color_jacobian_rows(pattern, x_var.size())) {
+    nested.set_zero_all_adjoints();
+    for (int i : group) {
+      fx_var.coeff(i).vi_->adj_ = 1.0;
+    }
+    grad();
+    for (int i : group) {
+      for (int j : pattern[i]) {
+        triplets.emplace_back(i, j, x_var.coeff(j).adj());
+      }
+    }
+  }
+  J.resize(fx_var.size(), x_var.size());
+  J.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+}  // namespace internal
+
+/**
+ * Return the Jacobian of the function applied to the specified input,
+ * as a sparse matrix, and the value of the function.
+ *
+ * <p>The functor must implement
+ *
+ * <code>
+ * Eigen::Matrix<var, Eigen::Dynamic, 1>
+ * operator()(const Eigen::Matrix<var, Eigen::Dynamic, 1>&)
+ * </code>
+ *
+ * <p>The function is recorded once. The sparsity pattern of the
+ * Jacobian is found by a structural trace of the tape, the rows are
+ * grouped such that no two rows of a group share a column, and one
+ * reverse pass is run per group instead of one per output. A Jacobian
+ * with at most `k` nonzeros per row and per column needs at most
+ * `k * (k - 1) + 1` reverse passes, whatever the number of outputs.
+ *
+ * <p>Varis which cannot be traced, such as reverse pass callbacks, are
+ * assumed to connect their results to all inputs, so the rows using
+ * them are dense in the pattern and the Jacobian. Use the overload
+ * taking a sparsity pattern for such functions.
+ *
+ * @tparam F Type of function
+ * @param[in] f Function
+ * @param[in] x Argument to function
+ * @param[out] fx Function applied to argument
+ * @param[out] J Jacobian of function at argument, with one row per
+ * output and one column per input
+ */
+template <typename F>
+void sparse_jacobian(const F& f,
+                     const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
+                     Eigen::Matrix<double, Eigen::Dynamic, 1>& fx,
+                     Eigen::SparseMatrix<double>& J) {
+  nested_rev_autodiff nested;
+
+  Eigen::Matrix<var, Eigen::Dynamic, 1> x_var(x);
+  Eigen::Matrix<var, Eigen::Dynamic, 1> fx_var = f(x_var);
+  fx = fx_var.val();
+
+  std::vector<std::vector<int>> pattern;
+  internal::trace_jacobian_sparsity(x_var, fx_var, pattern);
+  internal::colored_sparse_jacobian(nested, x_var, fx_var, pattern, J);
+}
+
+/**
+ * Return the Jacobian of the function applied to the specified input,
+ * as a sparse matrix with the specified sparsity pattern, and the value
+ * of the function.
+ *
+ * <p>The functor must implement
+ *
+ * <code>
+ * Eigen::Matrix<var, Eigen::Dynamic, 1>
+ * operator()(const Eigen::Matrix<var, Eigen::Dynamic, 1>&)
+ * </code>
+ *
+ * <p>The rows are grouped such that no two rows of a group share a
+ * column of the pattern and one reverse pass is run per group. The
+ * pattern must hold every nonzero entry of the Jacobian, otherwise the
+ * entries of rows sharing a reverse pass are mixed up. The values held
+ * by the pattern are ignored.
+ *
+ * @tparam F Type of function
+ * @tparam EigSparse Type of the sparsity pattern
+ * @param[in] f Function
+ * @param[in] x Argument to function
+ * @param[in] pattern Sparse matrix with a nonzero entry in place of
+ * every nonzero entry of the Jacobian
+ * @param[out] fx Function applied to argument
+ * @param[out] J Jacobian of function at argument, with the nonzero
+ * entries of the pattern
+ * @throw std::invalid_argument if the size of the pattern does not
+ * match the size of the argument or the size of the value of the function
+ */
+template <typename F, typename EigSparse,
+          require_eigen_sparse_base_t<EigSparse>* = nullptr>
+void sparse_jacobian(const F& f,
+                     const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
+                     const EigSparse& pattern,
+                     Eigen::Matrix<double, Eigen::Dynamic, 1>& fx,
+                     Eigen::SparseMatrix<double>& J) {
+  static constexpr const char* function = "sparse_jacobian";
+  nested_rev_autodiff nested;
+
+  Eigen::Matrix<var, Eigen::Dynamic, 1> x_var(x);
+  Eigen::Matrix<var, Eigen::Dynamic, 1> fx_var = f(x_var);
+  fx = fx_var.val();
+  check_size_match(function, "columns of the pattern", pattern.cols(),
+                   "size of the argument", x.size());
+  check_size_match(function, "rows of the pattern", pattern.rows(),
+                   "size of the function value", fx.size());
+
+  std::vector<std::vector<int>> rows(pattern.rows());
+  for (Eigen::Index k = 0; k < pattern.outerSize(); ++k) {
+    for (typename EigSparse::InnerIterator it(pattern, k); it; ++it) {
+      rows[it.row()].push_back(it.col());
+    }
+  }
+  for (auto& row : rows) {
+    std::sort(row.begin(), row.end());
+    row.erase(std::unique(row.begin(), row.end()), row.end());
+  }
+  internal::colored_sparse_jacobian(nested, x_var, fx_var, rows, J);
+}
+
+}  // namespace math
+}  // namespace stan
+#endif
@@ -4,6 +4,7 @@
 #include <stan/math/prim/meta/is_eigen.hpp>
 #include <stan/math/prim/meta/is_var.hpp>
 #include <stan/math/prim/meta/plain_type.hpp>
+#include <stan/math/prim/fun/pin_data.hpp>
 #include <stan/math/rev/core/arena_allocator.hpp>
 #include <stan/math/rev/core/chainable_alloc.hpp>
 #include <stan/math/rev/core/var_value_fwd_declare.hpp>
@@ -35,18 +36,29 @@ struct arena_type_impl<std::vector<T, Alloc>> {
 template <typename T>
 struct arena_type_impl<
     T, require_eigen_t<T>,
-    std::enable_if_t<T::RowsAtCompileTime == Eigen::Dynamic
-                     || T::ColsAtCompileTime == Eigen::Dynamic>> {
+    std::enable_if_t<!is_pinned_data<T>::value
+                     && (T::RowsAtCompileTime == Eigen::Dynamic
+                         || T::ColsAtCompileTime == Eigen::Dynamic)>> {
   using type = math::arena_matrix<plain_type_t<T>>;
 };
 
 template <typename T>
 struct arena_type_impl<
     T, require_eigen_t<T>,
-    std::enable_if_t<T::RowsAtCompileTime != Eigen::Dynamic
+    std::enable_if_t<!is_pinned_data<T>::value
+                     && T::RowsAtCompileTime != Eigen::Dynamic
                      && T::ColsAtCompileTime != Eigen::Dynamic>> {
   using type = plain_type_t<T>;
 };
+
+/**
+ * Pinned data is shared by threads and read-only, so it is stored on
+ * the tape as a read-only map of the pinned memory.
+ */
+template <typename T>
+struct arena_type_impl<T, require_t<is_pinned_data<T>>> {
+  using type = math::arena_matrix<const typename T::PlainObject>;
+};
 }  // namespace internal
 
 /**
@@ -132,3 +132,200 @@ TEST(stack_alloc, in_stack_second_block) {
   EXPECT_FALSE(allocator.in_stack(x));
   EXPECT_FALSE(allocator.in_stack(y));
 }
+
+TEST(stack_alloc, bytes_used) {
+  stan::math::stack_alloc allocator;
+  EXPECT_EQ(0U, allocator.bytes_used());
+  allocator.alloc(3);
+  EXPECT_EQ(8U, allocator.bytes_used());
+  allocator.alloc_array<double>(4);
+  EXPECT_EQ(40U, allocator.bytes_used());
+  allocator.alloc(stan::math::internal::DEFAULT_INITIAL_NBYTES);
+  EXPECT_EQ(2 * stan::math::internal::DEFAULT_INITIAL_NBYTES,
+            allocator.bytes_used());
+  allocator.recover_all();
+  EXPECT_EQ(0U, allocator.bytes_used());
+}
+
+TEST(stack_alloc, reserve) {
+  stan::math::stack_alloc allocator;
+  allocator.alloc(16);
+  // enough room left in the first block, nothing changes
+  allocator.reserve(64);
+  EXPECT_EQ(16U, allocator.bytes_used());
+
+  const size_t len = 4 * stan::math::internal::DEFAULT_INITIAL_NBYTES;
+  allocator.reserve(len);
+  size_t allocated = allocator.bytes_allocated();
+  EXPECT_LE(len + stan::math::internal::DEFAULT_INITIAL_NBYTES, allocated);
+  char* first = allocator.alloc_array<char>(len / 2);
+  char* second = allocator.alloc_array<char>(len / 2 - 8);
+  // both allocations live in the reserved block
+  EXPECT_EQ(first + len / 2, second);
+  EXPECT_EQ(allocated, allocator.bytes_allocated());
+}
+
+TEST(stack_alloc, policy_initial_and_growth) {
+  stan::math::stack_alloc_policy policy;
+  policy.initial_nbytes_ = 1024;
+  policy.growth_factor_ = 4.0;
+  stan::math::stack_alloc allocator(policy);
+  EXPECT_EQ(1024U, allocator.bytes_allocated());
+  EXPECT_EQ(4.0, allocator.policy().growth_factor_);
+  allocator.alloc(1000);
+  allocator.alloc(100);
+  EXPECT_EQ(1024U + 4096U, allocator.bytes_allocated());
+  allocator.alloc(5000);
+  EXPECT_EQ(1024U + 4096U + 16384U, allocator.bytes_allocated());
+  allocator.free_all();
+  EXPECT_EQ(1024U, allocator.bytes_allocated());
+}
+
+TEST(stack_alloc, policy_invalid_growth) {
+  stan::math::stack_alloc_policy policy;
+  policy.growth_factor_ = 0.5;
+  EXPECT_THROW(stan::math::stack_alloc allocator(policy),
+               std::invalid_argument);
+  stan::math::stack_alloc allocator;
+  EXPECT_THROW(allocator.set_policy(policy), std::invalid_argument);
+}
+
+TEST(stack_alloc, policy_huge_pages_first_touch) {
+  stan::math::stack_alloc_policy policy;
+  policy.huge_pages_ = true;
+  policy.first_touch_ = true;
+  stan::math::stack_alloc allocator(policy);
+  EXPECT_EQ(stan::math::internal::DEFAULT_INITIAL_NBYTES,
+            allocator.bytes_allocated());
+  const size_t len = 3 * stan::math::internal::HUGE_PAGE_NBYTES + 17;
+  char* x = allocator.alloc_array<char>(len);
+  for (size_t i = 0; i < len; ++i) {
+    x[i] = 1;
+  }
+  EXPECT_TRUE(allocator.in_stack(x + len - 1));
+  size_t block_nbytes = allocator.bytes_allocated()
+                        - stan::math::internal::DEFAULT_INITIAL_NBYTES;
+#ifdef __linux__
+  EXPECT_EQ(0U, block_nbytes % stan::math::internal::HUGE_PAGE_NBYTES);
+#endif
+  EXPECT_LE(len, block_nbytes);
+  allocator.recover_all();
+  allocator.free_all();
+}
+
+TEST(stack_alloc, default_policy) {
+  stan::math::stack_alloc_policy old_policy
+      = stan::math::default_stack_alloc_policy();
+  stan::math::default_stack_alloc_policy().initial_nbytes_ = 4096;
+  {
+    stan::math::stack_alloc allocator;
+    EXPECT_EQ(4096U, allocator.bytes_allocated());
+    stan::math::stack_alloc allocator2(8192);
+    EXPECT_EQ(8192U, allocator2.bytes_allocated());
+  }
+  stan::math::default_stack_alloc_policy() = old_policy;
+}
+
+TEST(stack_alloc, release_after_recoveries) {
+  stan::math::stack_alloc_policy policy;
+  policy.initial_nbytes_ = 1024;
+  policy.release_after_recoveries_ = 2;
+  stan::math::stack_alloc allocator(policy);
+  allocator.alloc(4096);
+  EXPECT_EQ(1024U + 4096U, allocator.bytes_retained());
+  allocator.recover_all();
+  EXPECT_EQ(1024U + 4096U, allocator.bytes_retained());
+  allocator.alloc(100);
+  allocator.recover_all();
+  EXPECT_EQ(1024U + 4096U, allocator.bytes_retained());
+  allocator.recover_all();
+  EXPECT_EQ(1024U, allocator.bytes_retained());
+  EXPECT_EQ(1024U, allocator.bytes_allocated());
+
+  // a block in use is kept
+  allocator.alloc(4096);
+  for (int i = 0; i < 5; ++i) {
+    allocator.recover_all();
+    allocator.alloc(4096);
+  }
+  EXPECT_EQ(1024U + 4096U, allocator.bytes_retained());
+
+  // nested recovery does not release blocks
+  allocator.start_nested();
+  allocator.recover_nested();
+  EXPECT_EQ(1024U + 4096U, allocator.bytes_retained());
+}
+
+TEST(stack_alloc, max_retained_nbytes) {
+  stan::math::stack_alloc_policy policy;
+  policy.initial_nbytes_ = 1024;
+  stan::math::stack_alloc allocator(policy);
+  allocator.alloc(1000);
+  allocator.alloc(2000);
+  allocator.alloc(4000);
+  EXPECT_EQ(1024U + 2048U + 4096U, allocator.bytes_retained());
+  allocator.recover_all();
+  EXPECT_EQ(1024U + 2048U + 4096U, allocator.bytes_retained());
+
+  policy.max_retained_nbytes_ = 4000;
+  allocator.set_policy(policy);
+  allocator.recover_all();
+  EXPECT_EQ(1024U + 2048U, allocator.bytes_retained());
+
+  policy.max_retained_nbytes_ = 1;
+  allocator.set_policy(policy);
+  allocator.recover_all();
+  EXPECT_EQ(1024U, allocator.bytes_retained());
+
+  // memory is still usable after releasing blocks
+  char* x = allocator.alloc_array<char>(10000);
+  x[9999] = 1;
+  EXPECT_TRUE(allocator.in_stack(x + 9999));
+}
+
+TEST(stack_alloc, alloc_aligned_64) {
+  stan::math::stack_alloc allocator;
+  allocator.alloc(8);
+  for (size_t len : {1, 8, 24, 100, 1000}) {
+    void* x = allocator.alloc_aligned<64>(len);
+    EXPECT_TRUE(stan::math::is_aligned(static_cast<char*>(x), 64));
+    EXPECT_TRUE(allocator.in_stack(static_cast<char*>(x) + len - 1));
+    void* y = allocator.alloc(8);
+    EXPECT_LE(static_cast<char*>(x) + len, static_cast<char*>(y));
+  }
+  // allocations that do not fit the current block
+  const size_t len = 3 * stan::math::internal::DEFAULT_INITIAL_NBYTES;
+  double* z = allocator.alloc_array_aligned<double, 64>(len);
+  EXPECT_TRUE(stan::math::is_aligned(z, 64));
+  z[len - 1] = 1;
+  EXPECT_TRUE(allocator.in_stack(z + len - 1));
+  double* w = allocator.alloc_array_aligned<double, 64>(1);
+  EXPECT_TRUE(stan::math::is_aligned(w, 64));
+}
+
+TEST(stack_alloc, peak_bytes_used) {
+  stan::math::stack_alloc_policy policy;
+  policy.initial_nbytes_ = 1024;
+  stan::math::stack_alloc allocator(policy);
+  EXPECT_EQ(0U, allocator.peak_bytes_used());
+  allocator.alloc(512);
+  EXPECT_EQ(512U, allocator.peak_bytes_used());
+  allocator.start_nested();
+  allocator.alloc(4000);
+  const size_t nested_used = allocator.bytes_used();
+  EXPECT_EQ(1024U + 4000U, nested_used);
+  EXPECT_EQ(1024U + 4000U, allocator.bytes_allocated());
+  allocator.recover_nested();
+  EXPECT_EQ(512U, allocator.bytes_used());
+  EXPECT_EQ(1024U, allocator.bytes_allocated());
+  EXPECT_EQ(nested_used, allocator.peak_bytes_used());
+  allocator.recover_all();
+  EXPECT_EQ(0U, allocator.bytes_used());
+  EXPECT_EQ(nested_used, allocator.peak_bytes_used());
+  allocator.reset_peak_bytes_used();
+  EXPECT_EQ(0U, allocator.peak_bytes_used());
+  allocator.alloc(16);
+  EXPECT_EQ(16U, allocator.peak_bytes_used());
+  allocator.free_all();
+  EXPECT_EQ(1024U, allocator.bytes_retained());
+}
@@ -0,0 +1,32 @@
+#include <stan/math/prim.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <utility>
+
+TEST(MathFunctions, pin_data_copy) {
+  Eigen::MatrixXd a(2, 3);
+  a << 1, 2, 3, 4, 5, 6;
+  auto b = stan::math::pin_data(a);
+  EXPECT_MATRIX_EQ(a, b);
+  EXPECT_NE(a.data(), b.data());
+  EXPECT_TRUE(stan::is_eigen<decltype(b)>::value);
+  EXPECT_TRUE((std::is_same<stan::plain_type_t<decltype(b)>,
+                            Eigen::MatrixXd>::value));
+
+  auto c = b;
+  EXPECT_EQ(b.data(), c.data());
+  EXPECT_EQ(2, b.storage().use_count());
+
+  auto d = stan::math::pin_data(a.transpose() * 2.0);
+  EXPECT_MATRIX_EQ(a.transpose() * 2.0, d);
+}
+
+TEST(MathFunctions, pin_data_move) {
+  Eigen::VectorXd a(3);
+  a << 1, 2, 3;
+  const double* a_data = a.data();
+  auto b = stan::math::pin_data(std::move(a));
+  EXPECT_EQ(a_data, b.data());
+  EXPECT_EQ(3, b.size());
+  EXPECT_FLOAT_EQ(6.0, b.sum());
+}
@@ -0,0 +1,46 @@
+#include <stan/math/prim.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace checkpointed_loop_prim_test {
+struct step {
+  template <typename T>
+  Eigen::Matrix<T, Eigen::Dynamic, 1> operator()(
+      const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, int t, std::ostream* msgs,
+      double rate) const {
+    return x * rate
+           + Eigen::Matrix<T, Eigen::Dynamic, 1>::Constant(x.size(), t);
+  }
+};
+
+struct bad_step {
+  template <typename T>
+  Eigen::Matrix<T, Eigen::Dynamic, 1> operator()(
+      const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, int t,
+      std::ostream* msgs) const {
+    return Eigen::Matrix<T, Eigen::Dynamic, 1>::Zero(x.size() + 1);
+  }
+};
+}  // namespace checkpointed_loop_prim_test
+
+TEST(MathFunctions, checkpointed_loop) {
+  Eigen::VectorXd x0(2);
+  x0 << 1.0, 2.0;
+  Eigen::VectorXd expected = x0;
+  for (int t = 0; t < 5; ++t) {
+    expected = expected * 0.5 + Eigen::VectorXd::Constant(2, t);
+  }
+  EXPECT_MATRIX_FLOAT_EQ(
+      expected, stan::math::checkpointed_loop(
+                    checkpointed_loop_prim_test::step(), x0, 5, nullptr, 0.5));
+  EXPECT_MATRIX_FLOAT_EQ(
+      x0, stan::math::checkpointed_loop(checkpointed_loop_prim_test::step(),
+                                        x0, 0, nullptr, 0.5));
+  EXPECT_THROW(stan::math::checkpointed_loop(
+                   checkpointed_loop_prim_test::step(), x0, -1, nullptr, 0.5),
+               std::domain_error);
+  EXPECT_THROW(stan::math::checkpointed_loop(
+                   checkpointed_loop_prim_test::bad_step(), x0, 2, nullptr),
+               std::invalid_argument);
+}
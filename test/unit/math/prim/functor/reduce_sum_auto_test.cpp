@@ -0,0 +1,120 @@
+#include <stan/math.hpp>
+#include <test/unit/math/prim/functor/reduce_sum_util.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+/**
+ * Simulated wall time of a reduction over 1000 terms on 4 threads
+ * with the specified number of chunks.
+ */
+double simulated_time(size_t k) {
+  const double P = 4;
+  return 1.0 * std::ceil(k / P) / k + 0.001 * k / P + 0.01;
+}
+
+// reducer type keying tuners driven by simulated timings
+struct tuner_key {};
+}  // namespace
+
+TEST(StanMathPrim_reduce_sum_auto, tuner_converges) {
+  stan::math::grainsize_tuner tuner(1);
+  size_t calls = 0;
+  while (!tuner.converged()) {
+    const size_t k = tuner.next_num_chunks(1000, 4);
+    EXPECT_GE(k, 1);
+    EXPECT_LE(k, 512);
+    EXPECT_EQ(0, k & (k - 1));
+    tuner.record(k, 1000, 4, simulated_time(k));
+    ASSERT_LT(++calls, 10);
+  }
+  // the model is exact, so the minimum over powers of two is found
+  size_t best = 1;
+  for (size_t k = 1; k <= 512; k *= 2) {
+    if (simulated_time(k) < simulated_time(best)) {
+      best = k;
+    }
+  }
+  EXPECT_EQ(best, tuner.num_chunks());
+  EXPECT_EQ(best, tuner.next_num_chunks(1000, 4));
+  EXPECT_EQ(250, stan::math::grainsize_tuner::grainsize(1000, 4));
+}
+
+TEST(StanMathPrim_reduce_sum_auto, tuner_restarts) {
+  stan::math::grainsize_tuner tuner(2);
+  while (!tuner.converged()) {
+    const size_t k = tuner.next_num_chunks(1000, 4);
+    tuner.record(k, 1000, 4, simulated_time(k));
+  }
+  tuner.next_num_chunks(2000, 4);
+  EXPECT_FALSE(tuner.converged());
+  // timings of another problem size are ignored
+  tuner.record(1, 1000, 4, 0.0);
+  EXPECT_FALSE(tuner.converged());
+
+  stan::math::grainsize_tuner small;
+  EXPECT_EQ(1, small.next_num_chunks(1, 8));
+  small.record(1, 1, 8, 0.1);
+  small.record(1, 1, 8, 0.1);
+  EXPECT_EQ(1, small.next_num_chunks(1, 8));
+  EXPECT_TRUE(small.converged());
+}
+
+TEST(StanMathPrim_reduce_sum_auto, value) {
+  using stan::math::test::count_lpdf;
+  using stan::math::test::get_new_msg;
+  std::vector<int> data(1000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i % 20;
+  }
+  std::vector<int> idata;
+  std::vector<double> vlambda_d(1, 10.0);
+  const double ref = stan::math::poisson_lpmf(data, 10.0);
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_FLOAT_EQ(ref, stan::math::reduce_sum_auto<count_lpdf<double>>(
+                             data, get_new_msg(), vlambda_d, idata));
+  }
+  std::vector<int> empty;
+  EXPECT_EQ(0.0, stan::math::reduce_sum_auto<count_lpdf<double>>(
+                     empty, get_new_msg(), vlambda_d, idata));
+}
+
+TEST(StanMathPrim_reduce_sum_auto, call_sites_tuned_separately) {
+  using stan::math::test::count_lpdf;
+  using stan::math::test::get_new_msg;
+  std::vector<int> idata;
+  std::vector<double> vlambda_d(1, 10.0);
+  std::vector<int> data_50(50, 3);
+  std::vector<int> data_100(100, 3);
+  // two call sites sharing the reducer alternate
+  for (int i = 0; i < 50; ++i) {
+    const std::vector<int>& data = i % 2 == 0 ? data_50 : data_100;
+    EXPECT_FLOAT_EQ(stan::math::poisson_lpmf(data, 10.0),
+                    stan::math::reduce_sum_auto<count_lpdf<double>>(
+                        data, get_new_msg(), vlambda_d, idata));
+  }
+#ifdef STAN_THREADS
+  const size_t num_threads = tbb::this_task_arena::max_concurrency();
+  EXPECT_TRUE(stan::math::internal::reduce_sum_auto_tuner<count_lpdf<double>>(
+                  50, num_threads)
+                  .converged());
+  EXPECT_TRUE(stan::math::internal::reduce_sum_auto_tuner<count_lpdf<double>>(
+                  100, num_threads)
+                  .converged());
+#endif
+
+  using stan::math::internal::reduce_sum_auto_tuner;
+  auto& tuner_50 = reduce_sum_auto_tuner<tuner_key>(50, 8);
+  auto& tuner_100 = reduce_sum_auto_tuner<tuner_key>(100, 8);
+  EXPECT_NE(&tuner_50, &tuner_100);
+  EXPECT_EQ(&tuner_50, &reduce_sum_auto_tuner<tuner_key>(50, 8));
+  for (int i = 0; i < 40; ++i) {
+    auto& tuner = i % 2 == 0 ? tuner_50 : tuner_100;
+    const size_t num_terms = i % 2 == 0 ? 50 : 100;
+    const size_t k = tuner.next_num_chunks(num_terms, 8);
+    tuner.record(k, num_terms, 8, simulated_time(k));
+  }
+  EXPECT_TRUE(tuner_50.converged());
+  EXPECT_TRUE(tuner_100.converged());
+}
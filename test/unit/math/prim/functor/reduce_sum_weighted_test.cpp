@@ -0,0 +1,111 @@
+#include <stan/math.hpp>
+#include <test/unit/math/prim/functor/reduce_sum_util.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(StanMathPrim_reduce_sum_weighted, partition_by_cost) {
+  using stan::math::internal::partition_by_cost;
+  EXPECT_EQ(std::vector<size_t>({0, 2, 4}),
+            partition_by_cost({1, 1, 1, 1}, 2));
+  // an expensive term gets a chunk of its own
+  EXPECT_EQ(std::vector<size_t>({0, 1, 4}),
+            partition_by_cost({10, 1, 1, 1}, 2));
+  EXPECT_EQ(std::vector<size_t>({0, 3, 4}),
+            partition_by_cost({1, 1, 1, 10}, 2));
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}),
+            partition_by_cost({1, 1, 1}, 8));
+  EXPECT_EQ(std::vector<size_t>({0, 3}), partition_by_cost({1, 1, 1}, 1));
+  // all costs zero splits by count
+  EXPECT_EQ(std::vector<size_t>({0, 2, 4}),
+            partition_by_cost({0, 0, 0, 0}, 2));
+  EXPECT_EQ(std::vector<size_t>({0}), partition_by_cost({}, 4));
+}
+
+TEST(StanMathPrim_reduce_sum_weighted, term_cost_learner) {
+  stan::math::term_cost_learner learner(3);
+  // term 0 costs 9 seconds, the others 1 second each
+  std::vector<double> cost{9, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+  bool learning = false;
+  std::vector<size_t> bounds;
+  for (int call = 0; call < 3; ++call) {
+    bounds = learner.partition(cost.size(), 2, learning);
+    EXPECT_TRUE(learning);
+    EXPECT_FALSE(learner.frozen());
+    std::vector<double> chunk_seconds(bounds.size() - 1);
+    for (size_t c = 0; c + 1 < bounds.size(); ++c) {
+      for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+        chunk_seconds[c] += cost[i];
+      }
+    }
+    learner.record(bounds, chunk_seconds);
+  }
+  EXPECT_TRUE(learner.frozen());
+  bounds = learner.partition(cost.size(), 2, learning);
+  EXPECT_FALSE(learning);
+  // the first chunk no longer holds half of the terms
+  ASSERT_EQ(3, bounds.size());
+  EXPECT_LT(bounds[1], 5);
+  EXPECT_GT(learner.costs()[0], learner.costs()[9]);
+
+  // a new number of terms restarts the learning
+  learner.partition(4, 2, learning);
+  EXPECT_TRUE(learning);
+}
+
+TEST(StanMathPrim_reduce_sum_weighted, call_sites_learn_separately) {
+  using stan::math::internal::reduce_sum_cost_learner;
+  using stan::math::test::count_lpdf;
+  using stan::math::test::get_new_msg;
+  std::vector<int> data_50(50, 3);
+  std::vector<int> data_100(100, 3);
+  std::vector<int> idata;
+  std::vector<double> vlambda_d(1, 10.0);
+  // two call sites with the same reducer but different numbers of terms
+  for (int call = 0; call < 6; ++call) {
+    EXPECT_FLOAT_EQ(stan::math::poisson_lpmf(data_50, 10.0),
+                    stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                        data_50, 4, get_new_msg(), vlambda_d, idata));
+    EXPECT_FLOAT_EQ(stan::math::poisson_lpmf(data_100, 10.0),
+                    stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                        data_100, 4, get_new_msg(), vlambda_d, idata));
+  }
+#ifdef STAN_THREADS
+  EXPECT_TRUE(reduce_sum_cost_learner<count_lpdf<double>>(50).frozen());
+  EXPECT_TRUE(reduce_sum_cost_learner<count_lpdf<double>>(100).frozen());
+#endif
+  EXPECT_NE(&reduce_sum_cost_learner<count_lpdf<double>>(50),
+            &reduce_sum_cost_learner<count_lpdf<double>>(100));
+}
+
+TEST(StanMathPrim_reduce_sum_weighted, value) {
+  using stan::math::test::count_lpdf;
+  using stan::math::test::get_new_msg;
+  std::vector<int> data(1000);
+  std::vector<double> weights(1000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i % 20;
+    weights[i] = i < 10 ? 100.0 : 1.0;
+  }
+  std::vector<int> idata;
+  std::vector<double> vlambda_d(1, 10.0);
+  const double ref = stan::math::poisson_lpmf(data, 10.0);
+  EXPECT_FLOAT_EQ(ref, stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                           data, weights, 8, get_new_msg(), vlambda_d, idata));
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_FLOAT_EQ(ref, stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                             data, 8, get_new_msg(), vlambda_d, idata));
+  }
+
+  weights.pop_back();
+  EXPECT_THROW(stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                   data, weights, 8, get_new_msg(), vlambda_d, idata),
+               std::invalid_argument);
+  weights.push_back(-1.0);
+  EXPECT_THROW(stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                   data, weights, 8, get_new_msg(), vlambda_d, idata),
+               std::domain_error);
+  weights.back() = 1.0;
+  EXPECT_THROW(stan::math::reduce_sum_weighted<count_lpdf<double>>(
+                   data, weights, 0, get_new_msg(), vlambda_d, idata),
+               std::domain_error);
+}
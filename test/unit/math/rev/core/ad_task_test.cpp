@@ -0,0 +1,80 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <vector>
+
+TEST(AgradRevAdTask, runs_on_tape_of_its_own) {
+  using stan::math::ChainableStack;
+  using stan::math::var;
+  auto* thread_stack = ChainableStack::instance_;
+  const std::size_t num_varis = thread_stack->var_stack_.size();
+  EXPECT_FALSE(stan::math::in_ad_task());
+
+  const double adj = stan::math::run_ad_task([&] {
+    EXPECT_TRUE(stan::math::in_ad_task());
+    EXPECT_NE(ChainableStack::instance_, thread_stack);
+    var a = 2.0;
+    var b = a * a * a;
+    b.grad();
+    return a.adj();
+  });
+
+  EXPECT_FLOAT_EQ(adj, 12.0);
+  EXPECT_FALSE(stan::math::in_ad_task());
+  EXPECT_EQ(ChainableStack::instance_, thread_stack);
+  EXPECT_EQ(thread_stack->var_stack_.size(), num_varis);
+}
+
+TEST(AgradRevAdTask, nested_tasks) {
+  const int depth = stan::math::run_ad_task([] {
+    return stan::math::run_ad_task(
+        [] { return stan::math::internal::ad_task_depth(); });
+  });
+  EXPECT_EQ(depth, 2);
+  EXPECT_FALSE(stan::math::in_ad_task());
+}
+
+TEST(AgradRevAdTask, nested_parallel_regions) {
+  using stan::math::var;
+  const int num_outer = 16;
+  const int num_inner = 64;
+  std::vector<double> outer_grad(num_outer, 0.0);
+
+  stan::math::run_ad_parallel([&] {
+    tbb::parallel_for(tbb::blocked_range<int>(0, num_outer, 1),
+                      [&](const tbb::blocked_range<int>& r) {
+                        for (int i = r.begin(); i < r.end(); ++i) {
+                          outer_grad[i] = stan::math::run_ad_task([&] {
+                            std::vector<double> inner_grad(num_inner, 0.0);
+                            stan::math::run_ad_parallel([&] {
+                              tbb::parallel_for(
+                                  tbb::blocked_range<int>(0, num_inner, 1),
+                                  [&](const tbb::blocked_range<int>& s) {
+                                    for (int j = s.begin(); j < s.end(); ++j) {
+                                      inner_grad[j] = stan::math::run_ad_task(
+                                          [&] {
+                                            var x = i + j;
+                                            var y = x * x;
+                                            y.grad();
+                                            return x.adj();
+                                          });
+                                    }
+                                  });
+                            });
+                            var sum = 0.0;
+                            for (double g : inner_grad) {
+                              sum += g;
+                            }
+                            return sum.val();
+                          });
+                        }
+                      });
+  });
+
+  for (int i = 0; i < num_outer; ++i) {
+    // sum over j of 2 * (i + j)
+    EXPECT_FLOAT_EQ(outer_grad[i],
+                    2.0 * num_inner * i + num_inner * (num_inner - 1.0));
+  }
+}
@@ -128,6 +128,30 @@ inline void expect_sparse_dense_matrix_equal(
   }
 }
 
+TEST_F(AgradRev, arena_matrix_alignment_test) {
+  using Eigen::MatrixXd;
+  using Eigen::VectorXd;
+  using stan::math::arena_matrix;
+
+  // small allocations keep their 8 byte alignment
+  arena_matrix<VectorXd> a(3);
+  EXPECT_TRUE(stan::math::is_aligned(a.data(), 8));
+
+  arena_matrix<VectorXd> b(17);
+  EXPECT_TRUE(stan::math::is_aligned(b.data(), 64));
+  arena_matrix<MatrixXd> c(5, 7);
+  EXPECT_TRUE(stan::math::is_aligned(c.data(), 64));
+  arena_matrix<MatrixXd> d(MatrixXd::Ones(5, 7));
+  EXPECT_TRUE(stan::math::is_aligned(d.data(), 64));
+  d = 2 * c.setOnes();
+  EXPECT_TRUE(stan::math::is_aligned(d.data(), 64));
+  EXPECT_MATRIX_EQ(d, MatrixXd::Constant(5, 7, 2));
+
+  stan::math::var_value<MatrixXd> x(MatrixXd::Ones(5, 7));
+  EXPECT_TRUE(stan::math::is_aligned(x.val().data(), 64));
+  EXPECT_TRUE(stan::math::is_aligned(x.adj().data(), 64));
+}
+
 TEST_F(AgradRev, arena_sparse_matrix_constructors) {
   using eig_mat = Eigen::SparseMatrix<double>;
   using stan::math::arena_matrix;
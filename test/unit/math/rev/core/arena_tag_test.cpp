@@ -0,0 +1,82 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+
+TEST(AgradRev, arena_tag_disabled) {
+  stan::math::set_arena_tags(false);
+  stan::math::clear_arena_tags();
+  {
+    stan::math::arena_tag tag("disabled");
+    stan::math::var x = 1.0;
+    stan::math::arena_matrix<Eigen::VectorXd> y(Eigen::VectorXd::Ones(10));
+  }
+  EXPECT_TRUE(stan::math::arena_tags().empty());
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, arena_tag_nested_scopes) {
+  using stan::math::arena_tag;
+  using stan::math::var;
+  stan::math::recover_memory();
+  stan::math::set_arena_tags(true);
+  stan::math::clear_arena_tags();
+  for (int i = 0; i < 2; ++i) {
+    arena_tag outer("outer");
+    stan::math::ChainableStack::instance_->memalloc_.alloc(64);
+    {
+      arena_tag inner("inner");
+      stan::math::arena_matrix<Eigen::VectorXd> y(Eigen::VectorXd::Ones(100));
+    }
+  }
+  stan::math::set_arena_tags(false);
+  const auto& tags = stan::math::arena_tags();
+  ASSERT_EQ(1, tags.count("outer"));
+  ASSERT_EQ(1, tags.count("inner"));
+  ASSERT_EQ(1, tags.count("arena_matrix"));
+  const auto& outer = tags.at("outer");
+  const auto& inner = tags.at("inner");
+  const auto& matrix = tags.at("arena_matrix");
+  EXPECT_EQ(2, outer.count_);
+  EXPECT_EQ(2, inner.count_);
+  EXPECT_EQ(2, matrix.count_);
+  EXPECT_EQ(2 * 100 * sizeof(double), matrix.bytes_);
+  EXPECT_LE(matrix.bytes_, inner.bytes_);
+  EXPECT_EQ(inner.bytes_, inner.self_bytes_);
+  EXPECT_EQ(outer.bytes_, outer.self_bytes_ + inner.bytes_);
+  EXPECT_EQ(2 * 64, outer.self_bytes_);
+  EXPECT_LE(inner.max_bytes_, inner.bytes_);
+
+  stan::math::clear_arena_tags();
+  EXPECT_TRUE(stan::math::arena_tags().empty());
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, arena_tag_cholesky_decompose) {
+  stan::math::recover_memory();
+  stan::math::set_arena_tags(true);
+  stan::math::clear_arena_tags();
+  Eigen::Matrix<stan::math::var, -1, -1> A
+      = Eigen::MatrixXd::Identity(5, 5) * 2.0;
+  auto L = stan::math::cholesky_decompose(A);
+  stan::math::set_arena_tags(false);
+  ASSERT_EQ(1, stan::math::arena_tags().count("cholesky_decompose"));
+  EXPECT_LT(0, stan::math::arena_tags().at("cholesky_decompose").bytes_);
+  stan::math::clear_arena_tags();
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, arena_memory) {
+  stan::math::recover_memory();
+  stan::math::reset_arena_peak();
+  auto stats = stan::math::arena_memory();
+  EXPECT_EQ(0, stats.bytes_used_);
+  EXPECT_EQ(0, stats.peak_bytes_used_);
+  EXPECT_LE(stats.bytes_allocated_, stats.bytes_retained_);
+  stan::math::arena_matrix<Eigen::VectorXd> y(Eigen::VectorXd::Ones(1000));
+  stats = stan::math::arena_memory();
+  EXPECT_LE(1000 * sizeof(double), stats.bytes_used_);
+  EXPECT_LE(stats.bytes_used_, stats.bytes_allocated_);
+  stan::math::recover_memory();
+  stats = stan::math::arena_memory();
+  EXPECT_EQ(0, stats.bytes_used_);
+  EXPECT_LE(1000 * sizeof(double), stats.peak_bytes_used_);
+}
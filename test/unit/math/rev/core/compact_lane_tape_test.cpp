@@ -0,0 +1,115 @@
+#include <stan/math/rev.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+namespace compact_lane_tape_test {
+// built from linearizable varis only
+template <typename T>
+T fun(const std::vector<T>& x) {
+  using stan::math::value_of;
+  T lp = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    lp += x[i] * x[i] - 2.0 * x[i] + 1.5 - (3.0 - x[i]);
+    lp += 0.5 * x[i] * x[(i + 1) % x.size()];
+  }
+  const double e = std::exp(value_of(x[0]));
+  lp -= stan::math::precomputed_gradients(
+      e * value_of(x[1]), std::vector<T>{x[0], x[1]},
+      std::vector<double>{e * value_of(x[1]), e});
+  return lp;
+}
+
+/**
+ * Record `f` at every point on the current tape and return whether the
+ * compact tapes of the points could be merged.
+ */
+template <typename F>
+bool build_lanes(const F& f, const std::vector<std::vector<double>>& points,
+                 stan::math::compact_lane_tape& lanes) {
+  using stan::math::var;
+  const auto& stack = stan::math::ChainableStack::instance_->var_stack_;
+  std::vector<stan::math::compact_tape> tapes;
+  std::vector<stan::math::vari*> dependents;
+  std::vector<std::vector<stan::math::vari*>> inputs;
+  for (const auto& point : points) {
+    const size_t first = stack.size();
+    std::vector<var> x(point.begin(), point.end());
+    var fx = f(x);
+    tapes.emplace_back(stack.data() + first, stack.data() + stack.size());
+    dependents.push_back(fx.vi_);
+    inputs.emplace_back();
+    for (auto& xi : x) {
+      inputs.back().push_back(xi.vi_);
+    }
+  }
+  return lanes.build(tapes, dependents, inputs);
+}
+}  // namespace compact_lane_tape_test
+
+TEST(AgradRevCompactLaneTape, matches_grad) {
+  using stan::math::var;
+  std::vector<std::vector<double>> points{
+      {0.5, 1.5, -0.3}, {1.0, 2.0, 0.7}, {2.5, 0.5, -1.2}, {0.1, 3.0, 0.0}};
+  auto f = [](const auto& x) { return compact_lane_tape_test::fun(x); };
+
+  stan::math::nested_rev_autodiff nested;
+  stan::math::compact_lane_tape lanes;
+  ASSERT_TRUE(compact_lane_tape_test::build_lanes(f, points, lanes));
+  EXPECT_EQ(points.size(), lanes.num_lanes());
+  EXPECT_LT(0U, lanes.num_records());
+  Eigen::MatrixXd grad(3, points.size());
+  lanes.grad(grad);
+
+  for (size_t k = 0; k < points.size(); ++k) {
+    stan::math::nested_rev_autodiff nested_k;
+    std::vector<var> x(points[k].begin(), points[k].end());
+    var fx = f(x);
+    fx.grad();
+    for (size_t i = 0; i < x.size(); ++i) {
+      EXPECT_FLOAT_EQ(x[i].adj(), grad(i, k));
+    }
+  }
+}
+
+TEST(AgradRevCompactLaneTape, same_structure_other_operations) {
+  // the partials are kept per lane, so operations with the same operands
+  // are merged
+  std::vector<std::vector<double>> points{{1.0, 2.0}, {-1.0, 2.0}};
+  auto branch = [](const auto& x) {
+    return x[0] > 0 ? x[0] * x[1] : x[0] + x[1];
+  };
+  stan::math::nested_rev_autodiff nested;
+  stan::math::compact_lane_tape lanes;
+  ASSERT_TRUE(compact_lane_tape_test::build_lanes(branch, points, lanes));
+  Eigen::MatrixXd grad(2, 2);
+  lanes.grad(grad);
+  Eigen::MatrixXd expected(2, 2);
+  expected << 2.0, 1.0, 1.0, 1.0;
+  EXPECT_MATRIX_EQ(expected, grad);
+}
+
+TEST(AgradRevCompactLaneTape, different_tapes) {
+  std::vector<std::vector<double>> points{{1.0, 2.0}, {-1.0, 2.0}};
+  auto branch = [](const auto& x) {
+    return x[0] > 0 ? x[0] * x[1] : x[0] * x[1] * x[1];
+  };
+  stan::math::nested_rev_autodiff nested;
+  stan::math::compact_lane_tape lanes;
+  EXPECT_FALSE(compact_lane_tape_test::build_lanes(branch, points, lanes));
+
+  // same operations on different operands
+  auto swap = [](const auto& x) {
+    return x[0] > 0 ? x[0] * x[0] : x[1] * x[1];
+  };
+  EXPECT_FALSE(compact_lane_tape_test::build_lanes(swap, points, lanes));
+}
+
+TEST(AgradRevCompactLaneTape, opaque_varis) {
+  std::vector<std::vector<double>> points{{1.0, 2.0}, {3.0, 4.0}};
+  auto f = [](const auto& x) { return stan::math::log_sum_exp(x) * x[0]; };
+  stan::math::nested_rev_autodiff nested;
+  stan::math::compact_lane_tape lanes;
+  EXPECT_FALSE(compact_lane_tape_test::build_lanes(f, points, lanes));
+}
@@ -0,0 +1,267 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace compact_tape_test {
+template <typename T>
+T fun(const std::vector<T>& x) {
+  using stan::math::atan;
+  using stan::math::exp;
+  using stan::math::log;
+  T lp = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    lp += x[i] * x[i] - 2.0 * x[i] + 1.5 - (3.0 - x[i]);
+    lp += exp(x[i]) / (1.0 + x[i] * x[i]);
+  }
+  lp -= log(x[0] * x[1] + x[1]);
+  lp += atan(x[2] * x[3]);
+  return lp;
+}
+}  // namespace compact_tape_test
+
+TEST(AgradRevCompactTape, matches_grad) {
+  using stan::math::var;
+  std::vector<double> x_val{0.5, 1.5, -0.3, 2.0};
+  std::vector<double> expected;
+  {
+    stan::math::nested_rev_autodiff nested;
+    std::vector<var> x(x_val.begin(), x_val.end());
+    var f = compact_tape_test::fun(x);
+    f.grad();
+    for (auto& xi : x) {
+      expected.push_back(xi.adj());
+    }
+  }
+
+  stan::math::nested_rev_autodiff nested;
+  std::vector<var> x(x_val.begin(), x_val.end());
+  var f = compact_tape_test::fun(x);
+  stan::math::compact_tape tape;
+  EXPECT_LT(0U, tape.num_linear());
+  EXPECT_LT(0U, tape.num_opaque());
+  for (int n = 0; n < 3; ++n) {
+    nested.set_zero_all_adjoints();
+    tape.grad(f.vi_);
+    for (size_t i = 0; i < x.size(); ++i) {
+      EXPECT_FLOAT_EQ(expected[i], x[i].adj());
+    }
+  }
+}
+
+TEST(AgradRevCompactTape, linear_records) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = 3.0;
+  var c = a * b;
+  var d = c - a;
+  var e = 4.0 - d + 1.0;
+  // a stacked leaf has nothing to propagate
+  new stan::math::vari(1.0);
+  stan::math::compact_tape tape;
+  EXPECT_EQ(0U, tape.num_opaque());
+  EXPECT_EQ(4U, tape.num_linear());
+  EXPECT_EQ(1U, tape.runs().size());
+  EXPECT_EQ(1U, tape.num_leaves());
+  ASSERT_EQ(6U, tape.num_operands());
+  EXPECT_EQ(a.vi_, tape.operands()[0]);
+  EXPECT_FLOAT_EQ(3.0, tape.partials()[0]);
+  EXPECT_EQ(b.vi_, tape.operands()[1]);
+  EXPECT_FLOAT_EQ(2.0, tape.partials()[1]);
+
+  tape.grad(e.vi_);
+  // e = 5 - a * b + a
+  EXPECT_FLOAT_EQ(-2.0, a.adj());
+  EXPECT_FLOAT_EQ(-2.0, b.adj());
+}
+
+TEST(AgradRevCompactTape, runs) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = a * a;
+  var c = b * 2.0;
+  var d = stan::math::atan(c);
+  var e = stan::math::log1p_exp(d);
+  var f = e + a;
+  stan::math::compact_tape tape;
+  ASSERT_EQ(3U, tape.runs().size());
+  EXPECT_EQ(stan::math::compact_tape::run_kind::linear, tape.runs()[0].kind_);
+  EXPECT_EQ(stan::math::compact_tape::run_kind::opaque, tape.runs()[1].kind_);
+  EXPECT_EQ(stan::math::compact_tape::run_kind::linear, tape.runs()[2].kind_);
+  EXPECT_EQ(2U, tape.num_opaque());
+
+  tape.grad(f.vi_);
+  // f = log1p_exp(atan(2 a^2)) + a
+  EXPECT_FLOAT_EQ(stan::math::inv_logit(std::atan(8.0)) * 8.0 / 65.0 + 1.0,
+                  a.adj());
+}
+
+TEST(AgradRevCompactTape, linear_scalar_functions) {
+  using stan::math::var;
+  std::vector<double> expected;
+  auto f = [](const var& x, const var& y) {
+    using stan::math::cos;
+    using stan::math::exp;
+    using stan::math::expm1;
+    using stan::math::inv;
+    using stan::math::inv_logit;
+    using stan::math::lgamma;
+    using stan::math::log;
+    using stan::math::log1p;
+    using stan::math::sin;
+    using stan::math::sqrt;
+    using stan::math::square;
+    using stan::math::tanh;
+    return exp(x) + log(y) + sqrt(y) + square(x) + inv(y) + log1p(y)
+           + expm1(x) + inv_logit(x) + sin(x) * cos(y) + tanh(x) + lgamma(y)
+           - x / y + x / 2.0 + 3.0 / y + (-x);
+  };
+  {
+    stan::math::nested_rev_autodiff nested;
+    var x = 0.7;
+    var y = 1.3;
+    f(x, y).grad();
+    expected = {x.adj(), y.adj()};
+  }
+  stan::math::nested_rev_autodiff nested;
+  var x = 0.7;
+  var y = 1.3;
+  var fx = f(x, y);
+  stan::math::compact_tape tape;
+  EXPECT_EQ(0U, tape.num_opaque());
+  tape.grad(fx.vi_);
+  EXPECT_FLOAT_EQ(expected[0], x.adj());
+  EXPECT_FLOAT_EQ(expected[1], y.adj());
+}
+
+TEST(AgradRevCompactTape, grad_compact) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 1.5;
+  var b = 0.5;
+  var f = stan::math::precomputed_gradients(3.0, std::vector<var>{a, b},
+                                            std::vector<double>{2.0, -1.0})
+          * b;
+  stan::math::grad_compact(f.vi_);
+  EXPECT_FLOAT_EQ(1.0, a.adj());
+  EXPECT_FLOAT_EQ(-0.5 + 3.0, b.adj());
+}
+
+TEST(AgradRevCompactTape, prune) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = 3.0;
+  var zero = 0.0;
+  var f = a * b + a * zero;
+  // diagnostics that do not feed into f
+  var diag = a * a - b;
+  var diag2 = diag * 3.0;
+  stan::math::compact_tape tape;
+  EXPECT_EQ(6U, tape.num_linear());
+  auto stats = tape.prune(f.vi_);
+  EXPECT_EQ(3U, stats.num_linear_);
+  EXPECT_EQ(0U, stats.num_opaque_);
+  // two operands of a * a, two of the subtraction, one of diag * 3, and
+  // a in a * zero with a zero partial
+  EXPECT_EQ(6U, stats.num_operands_);
+  EXPECT_EQ(3U, tape.num_linear());
+  EXPECT_EQ(5U, tape.num_operands());
+  EXPECT_EQ(1U, tape.runs().size());
+
+  tape.grad(f.vi_);
+  EXPECT_FLOAT_EQ(3.0, a.adj());
+  EXPECT_FLOAT_EQ(2.0, b.adj());
+  EXPECT_FLOAT_EQ(2.0, zero.adj());
+  EXPECT_FLOAT_EQ(0.0, diag.adj());
+}
+
+TEST(AgradRevCompactTape, prune_opaque_barrier) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var dead = a * 5.0;
+  var f = atan(a) * a;
+  var diag = a * a;
+  stan::math::compact_tape tape;
+  auto stats = tape.prune(f.vi_);
+  // the opaque atan feeds into f, so the records before it are kept
+  EXPECT_EQ(1U, stats.num_linear_);
+  EXPECT_EQ(0U, stats.num_opaque_);
+  EXPECT_EQ(1U, tape.num_opaque());
+  tape.grad(f.vi_);
+  EXPECT_FLOAT_EQ(2.0 / 5.0 + std::atan(2.0), a.adj());
+}
+
+TEST(AgradRevCompactTape, prune_dead_opaque) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = 3.0;
+  var f = a * b;
+  // diagnostics with opaque varis that do not feed into f
+  var dead = a * 5.0;
+  var diag = stan::math::log1p_exp(stan::math::atan(dead) + b);
+  stan::math::compact_tape tape;
+  EXPECT_EQ(2U, tape.num_opaque());
+  auto stats = tape.prune(f.vi_);
+  EXPECT_EQ(2U, stats.num_opaque_);
+  EXPECT_EQ(2U, stats.num_linear_);
+  EXPECT_EQ(0U, tape.num_opaque());
+  EXPECT_EQ(1U, tape.num_linear());
+  tape.grad(f.vi_);
+  EXPECT_FLOAT_EQ(3.0, a.adj());
+  EXPECT_FLOAT_EQ(2.0, b.adj());
+  EXPECT_FLOAT_EQ(0.0, dead.adj());
+}
+
+TEST(AgradRevCompactTape, prune_keeps_unmarked_opaque) {
+  using stan::math::var;
+  using stan::math::vari;
+  struct unmarked_vari : public vari {
+    vari* avi_;
+    explicit unmarked_vari(vari* avi) : vari(avi->val_), avi_(avi) {}
+    void chain() { avi_->adj_ += adj_; }
+  };
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var f = a * 3.0;
+  var dead(new unmarked_vari(a.vi_));
+  EXPECT_FALSE(dead.vi_->reads_only_own_adjoint());
+  EXPECT_TRUE(atan(a).vi_->reads_only_own_adjoint());
+  EXPECT_TRUE(stan::math::log1p_exp(a).vi_->reads_only_own_adjoint());
+  stan::math::compact_tape tape;
+  auto stats = tape.prune(f.vi_);
+  // only the atan and log1p_exp varis are known to be dead
+  EXPECT_EQ(2U, stats.num_opaque_);
+  EXPECT_EQ(1U, tape.num_opaque());
+  tape.grad(f.vi_);
+  EXPECT_FLOAT_EQ(3.0, a.adj());
+}
+
+TEST(AgradRevCompactTape, prune_keeps_foreign_adjoint_readers) {
+  using stan::math::var;
+  using stan::math::vari;
+  stan::math::nested_rev_autodiff nested;
+  std::vector<double> x{1.0, 2.0, 4.0};
+  var sigma = 1.5;
+  var l = 0.8;
+  // the adjoint of the vari itself is never set, only the adjoints of
+  // its outputs, which are not on the chain stack
+  auto* cov = new stan::math::cov_exp_quad_vari<double, var, var>(x, sigma, l);
+  var f = var(cov->cov_lower_[0]) * 2.0 + var(cov->cov_diag_[1]);
+  f.grad();
+  const double sigma_adj = sigma.adj();
+  const double l_adj = l.adj();
+  EXPECT_NE(0.0, l_adj);
+
+  stan::math::compact_tape tape;
+  auto stats = tape.prune(f.vi_);
+  EXPECT_EQ(0U, stats.num_opaque_);
+  EXPECT_EQ(1U, tape.num_opaque());
+  nested.set_zero_all_adjoints();
+  tape.grad(f.vi_);
+  EXPECT_FLOAT_EQ(sigma_adj, sigma.adj());
+  EXPECT_FLOAT_EQ(l_adj, l.adj());
+}
@@ -0,0 +1,117 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace grad_parallel_test {
+template <typename T>
+std::vector<T> terms(const std::vector<T>& x) {
+  std::vector<T> y;
+  for (size_t i = 0; i < x.size(); ++i) {
+    y.push_back(x[i] * x[i] - 2.0 * x[i] + x[i] * x[(i + 1) % x.size()]);
+  }
+  return y;
+}
+}  // namespace grad_parallel_test
+
+template <typename F>
+void expect_grad_parallel(const F& f, size_t num_x) {
+  using stan::math::var;
+  std::vector<double> x_val(num_x);
+  for (size_t i = 0; i < num_x; ++i) {
+    x_val[i] = 0.01 * i - 3.0;
+  }
+  std::vector<double> expected;
+  {
+    stan::math::nested_rev_autodiff nested;
+    std::vector<var> x(x_val.begin(), x_val.end());
+    var lp = f(x);
+    lp.grad();
+    for (auto& xi : x) {
+      expected.push_back(xi.adj());
+    }
+  }
+
+  stan::math::nested_rev_autodiff nested;
+  std::vector<var> x(x_val.begin(), x_val.end());
+  var lp = f(x);
+  // an arena with several slots runs the parallel sweep on any machine
+  tbb::task_arena arena(4);
+  for (size_t grainsize : {1, 16, 100, 100000}) {
+    nested.set_zero_all_adjoints();
+    arena.execute([&] { stan::math::grad_parallel(lp.vi_, grainsize); });
+    for (size_t i = 0; i < num_x; ++i) {
+      EXPECT_NEAR(expected[i], x[i].adj(),
+                  1e-12 * std::max(1.0, std::fabs(expected[i])))
+          << grainsize;
+    }
+  }
+}
+
+TEST(AgradRevGradParallel, independent_terms) {
+  expect_grad_parallel(
+      [](const auto& x) {
+        auto y = grad_parallel_test::terms(x);
+        return stan::math::precomputed_gradients(
+            0.0, y, std::vector<double>(y.size(), 1.5));
+      },
+      1000);
+}
+
+TEST(AgradRevGradParallel, lpdf_sum) {
+  using stan::math::var;
+  expect_grad_parallel(
+      [](const std::vector<var>& x) {
+        std::vector<var> terms;
+        for (size_t i = 2; i < x.size(); ++i) {
+          terms.push_back(
+              stan::math::normal_lpdf(0.1 * i, x[0] + x[i], exp(x[1])));
+        }
+        return stan::math::sum(terms);
+      },
+      300);
+}
+
+TEST(AgradRevGradParallel, opaque_barriers) {
+  using stan::math::var;
+  expect_grad_parallel(
+      [](const std::vector<var>& x) {
+        std::vector<var> terms;
+        for (size_t i = 0; i < x.size(); ++i) {
+          var t = x[i] * x[(i + 1) % x.size()];
+          if (i % 50 == 0) {
+            // a reverse pass callback with operands that are not known
+            t = stan::math::log1p_exp(stan::math::atan(t) + x[0]);
+          }
+          terms.push_back(t);
+        }
+        return stan::math::sum(terms) * x[0];
+      },
+      300);
+}
+
+TEST(AgradRevGradParallel, accumulates_like_grad) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = 3.0;
+  var c = a * b - a;
+  a.vi_->adj_ = 10.0;
+  tbb::task_arena arena(4);
+  arena.execute([&] { stan::math::grad_parallel(c.vi_, 1); });
+  EXPECT_FLOAT_EQ(10.0 + 3.0 - 1.0, a.adj());
+  EXPECT_FLOAT_EQ(2.0, b.adj());
+  EXPECT_FLOAT_EQ(1.0, c.adj());
+}
+
+TEST(AgradRevGradParallel, serial) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = exp(a) * a;
+  tbb::task_arena arena(1);
+  arena.execute([&] { stan::math::grad_parallel(b.vi_, 1); });
+  EXPECT_FLOAT_EQ(std::exp(2.0) * 3.0, a.adj());
+}
@@ -0,0 +1,76 @@
+#include <stan/math/rev/core.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+struct AgradLocalPooled : public testing::Test {
+  void SetUp() {
+    // make sure memory's clean before starting each test
+    stan::math::recover_memory();
+  }
+};
+
+TEST_F(AgradLocalPooled, pooled_chainablestack_base) {
+  using stan::math::pooled_chainablestack;
+  using stan::math::var;
+
+  var x = 1.0;
+  {
+    pooled_chainablestack pooled_stack;
+    double cgrad_a = pooled_stack.execute([] {
+      var a = 2.0;
+      var b = 4.0;
+      var c = a * a + b;
+      c.grad();
+      return a.adj();
+    });
+    EXPECT_FLOAT_EQ(cgrad_a, 4.0);
+  }
+  // the pooled stack did not touch the thread's tape
+  EXPECT_EQ(0, x.adj());
+  EXPECT_EQ(1,
+            stan::math::ChainableStack::instance_->var_nochain_stack_.size());
+}
+
+TEST_F(AgradLocalPooled, pooled_chainablestack_reuse) {
+  using stan::math::pooled_chainablestack;
+  using stan::math::var;
+
+  const double* first_data = nullptr;
+  {
+    pooled_chainablestack pooled_stack;
+    first_data = pooled_stack.execute([] {
+      stan::math::arena_matrix<Eigen::VectorXd> a(Eigen::VectorXd::Ones(10));
+      return a.data();
+    });
+  }
+  const size_t pool_size = pooled_chainablestack::pool_size();
+  EXPECT_GE(pool_size, 1);
+  {
+    pooled_chainablestack pooled_stack;
+    EXPECT_EQ(pool_size - 1, pooled_chainablestack::pool_size());
+    pooled_stack.execute([&] {
+      // the memory of the tape was recovered when it went back to the pool
+      EXPECT_EQ(0, stan::math::ChainableStack::instance_->var_stack_.size());
+      EXPECT_EQ(
+          0, stan::math::ChainableStack::instance_->var_nochain_stack_.size());
+      // and is reused
+      stan::math::arena_matrix<Eigen::VectorXd> a(Eigen::VectorXd::Ones(10));
+      if (pool_size == 1) {
+        EXPECT_EQ(first_data, a.data());
+      }
+    });
+  }
+  EXPECT_EQ(pool_size, pooled_chainablestack::pool_size());
+}
+
+TEST_F(AgradLocalPooled, pooled_chainablestack_open_nested) {
+  using stan::math::pooled_chainablestack;
+
+  const size_t pool_size = pooled_chainablestack::pool_size();
+  {
+    std::vector<pooled_chainablestack> stacks(pool_size + 1);
+    // a tape with an open nested scope is not returned to the pool
+    stacks[0].execute([] { stan::math::start_nested(); });
+  }
+  EXPECT_EQ(pool_size, pooled_chainablestack::pool_size());
+}
@@ -1,7 +1,9 @@
 #include <stan/math/rev.hpp>
 #include <gtest/gtest.h>
 #include <chrono>
+#include <string>
 #include <thread>
+#include <vector>
 
 TEST(Profiling, double_basic) {
   using stan::math::profile;
@@ -117,10 +119,168 @@ TEST(Profiling, var_loop) {
   EXPECT_TRUE(profiles[key_t1].get_rev_time() > 0.0);
 }
 
-TEST(Profiling, duplicate_active_profile) {
+TEST(Profiling, reentered_profile) {
   using stan::math::profile;
   using stan::math::var;
+  stan::math::recover_memory();
+  stan::math::profile_map profiles;
+  var c = 1.0;
+  {
+    profile<var> outer("t1", profiles);
+    c = c * 2.0;
+    {
+      profile<var> inner("t1", profiles);
+      c = c * 3.0;
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  c.grad();
+  const auto& t1 = profiles[{"t1", std::this_thread::get_id()}];
+  // only the outermost pass is counted in the totals
+  EXPECT_FALSE(t1.is_active());
+  EXPECT_EQ(1, t1.get_num_AD_fwd_passes());
+  EXPECT_EQ(1, t1.get_num_rev_passes());
+  ASSERT_EQ(2, t1.get_calls().size());
+  const auto& root = t1.get_calls().at({});
+  const auto& nested = t1.get_calls().at({"t1"});
+  EXPECT_EQ(std::vector<std::string>({"t1", "t1"}), nested.get_path());
+  EXPECT_EQ(1, nested.get_num_fwd_passes());
+  EXPECT_EQ(1, nested.get_num_rev_passes());
+  EXPECT_FLOAT_EQ(root.get_fwd_time(), t1.get_fwd_time());
+  EXPECT_FLOAT_EQ(t1.get_fwd_time(), t1.get_fwd_self_time());
+  EXPECT_FLOAT_EQ(root.get_fwd_time() - nested.get_fwd_time(),
+                  root.get_fwd_self_time());
+  stan::math::recover_memory();
+}
+
+TEST(Profiling, nested_tree) {
+  using stan::math::profile;
+  using stan::math::var;
+  stan::math::recover_memory();
+  stan::math::profile_map profiles;
+  var c = 1.0;
+  for (int i = 0; i < 4; i++) {
+    profile<var> outer("outer", profiles);
+    var a = i;
+    c = c + a;
+    {
+      profile<var> inner("inner", profiles);
+      stan::math::arena_matrix<Eigen::VectorXd> x(100);
+      c = c * 2.0;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  c.grad();
+  stan::math::recover_memory();
+  const auto id = std::this_thread::get_id();
+  stan::math::profile_key outer_key = {"outer", id};
+  stan::math::profile_key inner_key = {"inner", id};
+  const auto& outer = profiles[outer_key];
+  const auto& inner = profiles[inner_key];
+  ASSERT_EQ(1, outer.get_calls().size());
+  EXPECT_EQ(std::vector<std::string>({"outer"}),
+            outer.get_calls().at({}).get_path());
+  ASSERT_EQ(1, inner.get_calls().size());
+  EXPECT_EQ(4, inner.get_calls().at({"outer"}).get_num_fwd_passes());
+  EXPECT_EQ(4, inner.get_num_AD_fwd_passes());
+  EXPECT_EQ(4, inner.get_num_rev_passes());
+  EXPECT_GT(outer.get_fwd_time(), inner.get_fwd_time());
+  EXPECT_FLOAT_EQ(outer.get_fwd_time() - inner.get_fwd_time(),
+                  outer.get_fwd_self_time());
+  EXPECT_FLOAT_EQ(inner.get_fwd_time(), inner.get_fwd_self_time());
+  EXPECT_FLOAT_EQ(outer.get_rev_time() - inner.get_rev_time(),
+                  outer.get_rev_self_time());
+  EXPECT_LE(4 * 100 * sizeof(double), inner.get_arena_bytes_used());
+  EXPECT_LE(inner.get_arena_bytes_used(), outer.get_arena_bytes_used());
+
+  EXPECT_EQ(4, inner.get_fwd_time_histogram().count());
+  EXPECT_GE(inner.get_fwd_time_quantile(0.5), 0.005);
+  EXPECT_LE(inner.get_fwd_time_quantile(0.5), inner.get_fwd_time_quantile(1));
+  EXPECT_LE(inner.get_fwd_time_quantile(0.99), 1.0);
+
+  // a profile used in two places has a node of the call tree per place
+  {
+    profile<var> other("other", profiles);
+    profile<var> inner("inner", profiles);
+  }
+  ASSERT_EQ(2, inner.get_calls().size());
+  EXPECT_EQ(1, inner.get_calls().at({"other"}).get_num_fwd_passes());
+  EXPECT_EQ(4, inner.get_calls().at({"outer"}).get_num_fwd_passes());
+  EXPECT_EQ(5, inner.get_num_AD_fwd_passes());
+  stan::math::recover_memory();
+  stan::math::profile_key none_key = {"none", id};
+  EXPECT_EQ(0.0, profiles[none_key].get_rev_time_quantile(0.5));
+}
+
+TEST(Profiling, latency_histogram) {
+  stan::math::latency_histogram hist;
+  for (int i = 1; i <= 100; ++i) {
+    hist.add(i * 1e-3);
+  }
+  EXPECT_EQ(100, hist.count());
+  EXPECT_GE(hist.quantile(0.5), 0.050);
+  EXPECT_LE(hist.quantile(0.5), 0.050 * 1.2);
+  EXPECT_GE(hist.quantile(0.99), 0.099);
+  EXPECT_LE(hist.quantile(0.99), 0.099 * 1.2);
+  hist.add(0.0);
+  hist.add(1e9);
+  EXPECT_EQ(1, hist.counts()[0]);
+  EXPECT_EQ(1, hist.counts()[stan::math::latency_histogram::NUM_BUCKETS - 1]);
+}
+
+TEST(Profiling, perf_counters) {
+  using stan::math::profile;
+  using stan::math::var;
+  stan::math::recover_memory();
   stan::math::profile_map profiles;
-  profile<var> t1("t1", profiles);
-  EXPECT_THROW(profile<var>("t1", profiles), std::runtime_error);
+  const stan::math::profile_key key{"perf", std::this_thread::get_id()};
+  stan::math::set_profile_perf_counters(true);
+  EXPECT_TRUE(stan::math::profile_perf_counters());
+  var z = 0.0;
+  {
+    profile<var> p("perf", profiles);
+    var x = 2.0;
+    for (int i = 0; i < 1000; ++i) {
+      z += stan::math::exp(x) * x;
+    }
+  }
+  z.grad();
+  stan::math::set_profile_perf_counters(false);
+  const auto& info = profiles[key];
+  const auto& fwd = info.get_fwd_perf_counts();
+  const auto& rev = info.get_rev_perf_counts();
+  if (stan::math::perf_counters_available()) {
+    EXPECT_GT(fwd.cycles_, 0);
+    EXPECT_GT(fwd.instructions_, 0);
+    EXPECT_GT(rev.instructions_, 0);
+    EXPECT_GT(fwd.ipc(), 0.0);
+  } else {
+    EXPECT_EQ(0, fwd.cycles_);
+    EXPECT_EQ(0, rev.instructions_);
+    EXPECT_EQ(0.0, fwd.ipc());
+    EXPECT_EQ(0.0, rev.cache_misses_per_kilo_instruction());
+  }
+  stan::math::recover_memory();
+}
+
+TEST(Profiling, perf_counts_arithmetic) {
+  stan::math::perf_counts begin;
+  begin.cycles_ = 100;
+  begin.instructions_ = 50;
+  stan::math::perf_counts end;
+  end.cycles_ = 300;
+  end.instructions_ = 450;
+  end.cache_misses_ = 2;
+  end.branch_misses_ = 4;
+  stan::math::perf_counts d = end.since(begin);
+  EXPECT_EQ(200, d.cycles_);
+  EXPECT_EQ(400, d.instructions_);
+  EXPECT_FLOAT_EQ(2.0, d.ipc());
+  EXPECT_FLOAT_EQ(5.0, d.cache_misses_per_kilo_instruction());
+  EXPECT_FLOAT_EQ(10.0, d.branch_misses_per_kilo_instruction());
+  EXPECT_EQ(0, begin.since(end).cycles_);
+  d += d;
+  EXPECT_EQ(400, d.cycles_);
 }
@@ -0,0 +1,132 @@
+#include <stan/math/rev/core.hpp>
+#include <stan/math/rev/fun/exp.hpp>
+#include <stan/math/rev/fun/log.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace recorded_tape_test {
+struct fun {
+  template <typename T>
+  T operator()(const Eigen::Matrix<T, Eigen::Dynamic, 1>& x) const {
+    T lp = 0;
+    for (int i = 0; i < x.size(); ++i) {
+      lp += x(i) * x(i) + stan::math::exp(x(i));
+    }
+    return lp;
+  }
+};
+
+struct unstable_fun {
+  template <typename T>
+  T operator()(const Eigen::Matrix<T, Eigen::Dynamic, 1>& x) const {
+    if (x(0) > 0) {
+      return x(0) * x(1);
+    }
+    return x(0) * x(1) + stan::math::log(x(1));
+  }
+};
+}  // namespace recorded_tape_test
+
+TEST(AgradRecordedTape, gradient) {
+  using stan::math::recorded_tape;
+  recorded_tape_test::fun f;
+  recorded_tape tape;
+  EXPECT_FALSE(tape.is_recorded());
+  for (int n = 0; n < 5; ++n) {
+    Eigen::VectorXd x(3);
+    x << 0.1 * n, -1.0 + n, 2.0;
+    double fx;
+    Eigen::VectorXd grad_fx;
+    tape.gradient(f, x, fx, grad_fx);
+    EXPECT_FLOAT_EQ(f(x), fx);
+    ASSERT_EQ(3, grad_fx.size());
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_FLOAT_EQ(2 * x(i) + std::exp(x(i)), grad_fx(i));
+    }
+  }
+  EXPECT_TRUE(tape.is_recorded());
+  EXPECT_EQ(5U, tape.num_evaluations());
+  EXPECT_EQ(0U, tape.num_rerecords());
+  EXPECT_LT(0U, tape.num_chain_nodes());
+  EXPECT_LT(0U, tape.arena_bytes());
+}
+
+TEST(AgradRecordedTape, tape_does_not_grow_on_replay) {
+  using stan::math::ChainableStack;
+  recorded_tape_test::fun f;
+  stan::math::recorded_tape tape;
+  Eigen::VectorXd x = Eigen::VectorXd::Constant(1000, 0.5);
+  double fx;
+  Eigen::VectorXd grad_fx;
+  tape.gradient(f, x, fx, grad_fx);
+  tape.gradient(f, x, fx, grad_fx);
+  const auto capacity = ChainableStack::instance_->var_stack_.capacity();
+  const size_t allocated
+      = ChainableStack::instance_->memalloc_.bytes_allocated();
+  x.setConstant(-0.5);
+  tape.gradient(f, x, fx, grad_fx);
+  EXPECT_EQ(capacity, ChainableStack::instance_->var_stack_.capacity());
+  EXPECT_EQ(allocated, ChainableStack::instance_->memalloc_.bytes_allocated());
+}
+
+TEST(AgradRecordedTape, rerecord) {
+  recorded_tape_test::unstable_fun f;
+  stan::math::recorded_tape tape;
+  Eigen::VectorXd x(2);
+  x << 1.0, 2.0;
+  double fx;
+  Eigen::VectorXd grad_fx;
+  tape.gradient(f, x, fx, grad_fx);
+  EXPECT_FLOAT_EQ(2.0, fx);
+  EXPECT_FLOAT_EQ(2.0, grad_fx(0));
+  EXPECT_FLOAT_EQ(1.0, grad_fx(1));
+  EXPECT_EQ(0U, tape.num_rerecords());
+
+  x << -1.0, 2.0;
+  tape.gradient(f, x, fx, grad_fx);
+  EXPECT_FLOAT_EQ(-2.0 + std::log(2.0), fx);
+  EXPECT_FLOAT_EQ(2.0, grad_fx(0));
+  EXPECT_FLOAT_EQ(-1.0 + 0.5, grad_fx(1));
+  EXPECT_EQ(1U, tape.num_rerecords());
+}
+
+TEST(AgradRecordedTape, replay) {
+  using stan::math::var;
+  recorded_tape_test::fun f;
+  stan::math::recorded_tape tape;
+  Eigen::VectorXd x(2);
+  x << 0.5, 1.5;
+  double fx;
+  Eigen::VectorXd grad_fx;
+  tape.gradient(f, x, fx, grad_fx);
+  Eigen::VectorXd replayed;
+  for (int n = 0; n < 3; ++n) {
+    tape.replay(replayed);
+    EXPECT_MATRIX_FLOAT_EQ(grad_fx, replayed);
+  }
+}
+
+TEST(AgradRecordedTape, nested_in_outer_tape) {
+  using stan::math::var;
+  var a = 2.0;
+  var b = a * a;
+  {
+    recorded_tape_test::fun f;
+    stan::math::recorded_tape tape;
+    Eigen::VectorXd x = Eigen::VectorXd::Ones(2);
+    double fx;
+    Eigen::VectorXd grad_fx;
+    tape.gradient(f, x, fx, grad_fx);
+    tape.gradient(f, x, fx, grad_fx);
+  }
+  b.grad();
+  EXPECT_FLOAT_EQ(4.0, a.adj());
+  stan::math::recover_memory();
+}
+
+TEST(AgradRecordedTape, replay_throws) {
+  stan::math::recorded_tape tape;
+  Eigen::VectorXd grad_x;
+  EXPECT_THROW(tape.replay(grad_x), std::logic_error);
+}
@@ -0,0 +1,55 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+
+TEST(AgradRev, reserve_autodiff) {
+  using stan::math::ChainableStack;
+  stan::math::recover_memory();
+  stan::math::reserve_autodiff(1 << 20, 1000);
+  auto& stack = *ChainableStack::instance_;
+  EXPECT_LE(1000, stack.var_stack_.capacity());
+  EXPECT_LE(1000, stack.var_nochain_stack_.capacity());
+  const size_t bytes_allocated = stack.memalloc_.bytes_allocated();
+
+  stan::math::var x = 1.0;
+  for (int i = 0; i < 500; ++i) {
+    x = x * 2.0 + 1.0;
+  }
+  stan::math::arena_matrix<Eigen::VectorXd> a(1000);
+  EXPECT_EQ(bytes_allocated, stack.memalloc_.bytes_allocated());
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, learned_autodiff_size) {
+  stan::math::recover_memory();
+  stan::math::reset_learned_autodiff_size();
+  EXPECT_EQ(0, stan::math::learned_autodiff_size().chain_nodes_);
+
+  {
+    stan::math::nested_rev_autodiff nested;
+    stan::math::var x = 1.0;
+    for (int i = 0; i < 100; ++i) {
+      x = x * 2.0;
+    }
+  }
+  auto size = stan::math::learned_autodiff_size();
+  EXPECT_EQ(100, size.chain_nodes_);
+  EXPECT_EQ(1, size.nochain_nodes_);
+  EXPECT_LT(0, size.arena_bytes_);
+
+  // smaller tapes do not lower the peak
+  stan::math::var y = 1.0;
+  y = y * 2.0;
+  stan::math::recover_memory();
+  EXPECT_EQ(100, stan::math::learned_autodiff_size().chain_nodes_);
+
+  stan::math::reserve_learned_autodiff_size(true);
+  {
+    stan::math::ScopedChainableStack scoped_stack;
+    scoped_stack.execute([] {
+      EXPECT_LE(100,
+                stan::math::ChainableStack::instance_->var_stack_.capacity());
+    });
+  }
+  stan::math::reserve_learned_autodiff_size(false);
+  stan::math::reset_learned_autodiff_size();
+}
@@ -0,0 +1,113 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+TEST(AgradRev, reverse_profile_counts) {
+  using stan::math::var;
+  var x = 2.0;
+  var y = 3.0;
+  var f = 0.0;
+  for (int i = 0; i < 10; ++i) {
+    f = f + x * y + stan::math::exp(x);
+  }
+  stan::math::reverse_profile prof;
+  stan::math::grad_profiled(f.vi_, prof);
+  EXPECT_FLOAT_EQ(10 * (3.0 + std::exp(2.0)), x.adj());
+  EXPECT_FLOAT_EQ(10 * 2.0, y.adj());
+
+  size_t calls = 0;
+  for (const auto& stats : prof.stats()) {
+    calls += stats.calls_;
+    EXPECT_EQ(stats.calls_, stats.sampled_calls_);
+    EXPECT_FALSE(stats.type_.empty());
+  }
+  EXPECT_EQ(stan::math::ChainableStack::instance_->var_stack_.size(), calls);
+
+  const auto stats = prof.stats();
+  for (size_t i = 1; i < stats.size(); ++i) {
+    EXPECT_GE(stats[i - 1].estimated_time(), stats[i].estimated_time());
+  }
+
+  bool found_multiply = false;
+  for (const auto& stats : prof.stats()) {
+    if (stats.type_.find("multiply_vv_vari") != std::string::npos) {
+      found_multiply = true;
+      EXPECT_EQ(10, stats.calls_);
+      EXPECT_FLOAT_EQ(10 * 3 * sizeof(double),
+                      stats.estimated_adjoint_bytes());
+    }
+  }
+  EXPECT_TRUE(found_multiply);
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, reverse_profile_sampling_and_json) {
+  using stan::math::var;
+  var x = 2.0;
+  var f = x;
+  for (int i = 0; i < 100; ++i) {
+    f = f * x;
+  }
+  stan::math::reverse_profile prof(10);
+  stan::math::grad_profiled(f.vi_, prof);
+  ASSERT_EQ(1, prof.stats().size());
+  EXPECT_EQ(100, prof.stats()[0].calls_);
+  EXPECT_EQ(10, prof.stats()[0].sampled_calls_);
+
+  std::stringstream json;
+  prof.write_json(json);
+  const std::string s = json.str();
+  EXPECT_EQ('{', s.front());
+  EXPECT_EQ('}', s.back());
+  EXPECT_NE(std::string::npos, s.find("\"sample_every\": 10"));
+  EXPECT_NE(std::string::npos, s.find("\"calls\": 100"));
+
+  prof.clear();
+  EXPECT_EQ(0, prof.stats().size());
+  EXPECT_EQ(0.0, prof.estimated_time());
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, reverse_profile_opaque_adjoint_bytes) {
+  using stan::math::var;
+  using stan::math::var_value;
+  var_value<Eigen::VectorXd> v(Eigen::VectorXd::Ones(4));
+  var x = 2.0;
+  var f = stan::math::precomputed_gradients(
+      1.0, std::vector<var>{x}, std::vector<double>{1.0}, std::make_tuple(v),
+      std::make_tuple(Eigen::VectorXd::Ones(4).eval()));
+  f = f + stan::math::atan(x);
+  stan::math::reverse_profile prof;
+  for (int pass = 0; pass < 2; ++pass) {
+    stan::math::grad_profiled(f.vi_, prof);
+  }
+  bool found_precomputed = false;
+  bool found_callback = false;
+  for (const auto& stats : prof.stats()) {
+    EXPECT_EQ(2, stats.calls_);
+    if (stats.type_.find("precomputed_gradients_vari") != std::string::npos) {
+      // its own adjoint, one scalar operand and four container elements
+      found_precomputed = true;
+      EXPECT_EQ(0, stats.sampled_opaque_calls_);
+      EXPECT_FLOAT_EQ(2 * 6 * sizeof(double),
+                      stats.estimated_adjoint_bytes());
+    } else if (stats.type_.find("callback_vari") != std::string::npos) {
+      found_callback = true;
+      EXPECT_EQ(2, stats.sampled_opaque_calls_);
+      EXPECT_EQ(0.0, stats.estimated_adjoint_bytes());
+    }
+  }
+  EXPECT_TRUE(found_precomputed);
+  EXPECT_TRUE(found_callback);
+
+  prof.clear();
+  stan::math::grad_profiled(f.vi_, prof);
+  size_t calls = 0;
+  for (const auto& stats : prof.stats()) {
+    EXPECT_EQ(1, stats.calls_);
+    calls += stats.calls_;
+  }
+  EXPECT_EQ(stan::math::ChainableStack::instance_->var_stack_.size(), calls);
+  stan::math::recover_memory();
+}
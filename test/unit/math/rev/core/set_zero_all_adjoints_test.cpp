@@ -0,0 +1,106 @@
+#include <stan/math.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+
+TEST(AgradRevZero, set_zero_all_adjoints_matrix) {
+  using stan::math::var_value;
+  auto& stack = *stan::math::ChainableStack::instance_;
+  var_value<Eigen::MatrixXd> outside(Eigen::MatrixXd::Ones(2, 3));
+  var_value<Eigen::VectorXd> chaining = new stan::math::vari_value<
+      Eigen::VectorXd>(Eigen::VectorXd::Ones(4), true);
+  outside.adj().setConstant(2.0);
+  chaining.adj().setConstant(2.0);
+
+  stan::math::start_nested();
+  var_value<Eigen::MatrixXd> inside(Eigen::MatrixXd::Ones(3, 3));
+  inside.adj().setConstant(3.0);
+  stan::math::set_zero_all_adjoints_nested();
+  EXPECT_MATRIX_EQ(Eigen::MatrixXd::Zero(3, 3), inside.adj());
+  EXPECT_MATRIX_EQ(Eigen::MatrixXd::Constant(2, 3, 2.0), outside.adj());
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Constant(4, 2.0), chaining.adj());
+  const size_t num_ranges = stack.zeroable_ranges_.size();
+  stan::math::recover_memory_nested();
+  EXPECT_EQ(num_ranges - 1, stack.zeroable_ranges_.size());
+
+  stan::math::set_zero_all_adjoints();
+  EXPECT_MATRIX_EQ(Eigen::MatrixXd::Zero(2, 3), outside.adj());
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Zero(4), chaining.adj());
+  stan::math::recover_memory();
+  EXPECT_EQ(0, stack.zeroable_ranges_.size());
+}
+
+TEST(AgradRevZero, set_zero_all_adjoints_matrix_ranges_merge) {
+  using stan::math::arena_matrix;
+  using stan::math::var_value;
+  using stan::math::vari_value;
+  auto& stack = *stan::math::ChainableStack::instance_;
+  arena_matrix<Eigen::VectorXd> adj(6);
+  adj.setConstant(1.0);
+  Eigen::VectorXd val = Eigen::VectorXd::Ones(3);
+  var_value<Eigen::VectorXd> a = new vari_value<Eigen::VectorXd>(
+      val, Eigen::Map<Eigen::VectorXd>(adj.data(), 3));
+  const size_t num_ranges = stack.zeroable_ranges_.size();
+
+  // a range directly following the last one is merged
+  var_value<Eigen::VectorXd> b = new vari_value<Eigen::VectorXd>(
+      val, Eigen::Map<Eigen::VectorXd>(adj.data() + 3, 3));
+  EXPECT_EQ(num_ranges, stack.zeroable_ranges_.size());
+  stan::math::set_zero_all_adjoints();
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Zero(6), adj);
+
+  // but not across the start of a nested scope
+  arena_matrix<Eigen::VectorXd> adj2(6);
+  adj2.setConstant(1.0);
+  var_value<Eigen::VectorXd> c = new vari_value<Eigen::VectorXd>(
+      val, Eigen::Map<Eigen::VectorXd>(adj2.data(), 3));
+  stan::math::start_nested();
+  var_value<Eigen::VectorXd> d = new vari_value<Eigen::VectorXd>(
+      val, Eigen::Map<Eigen::VectorXd>(adj2.data() + 3, 3));
+  stan::math::set_zero_all_adjoints_nested();
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Ones(3), c.adj());
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Zero(3), d.adj());
+  stan::math::recover_memory_nested();
+  stan::math::recover_memory();
+}
+
+TEST(AgradRevZero, set_zero_all_adjoints_precomputed_gradients_matrix) {
+  using stan::math::var;
+  using stan::math::var_value;
+  var_value<Eigen::MatrixXd> a(Eigen::MatrixXd::Ones(2, 2));
+  Eigen::MatrixXd G = Eigen::MatrixXd::Constant(2, 2, 3.0);
+  var f = stan::math::precomputed_gradients(1.0, std::vector<var>{},
+                                            std::vector<double>{},
+                                            std::make_tuple(a),
+                                            std::make_tuple(G));
+  f.grad();
+  EXPECT_MATRIX_EQ(G, a.adj());
+
+  // the adjoint is accumulated in place, so it is still zeroed
+  stan::math::set_zero_all_adjoints();
+  EXPECT_MATRIX_EQ(Eigen::MatrixXd::Zero(2, 2), a.adj());
+  f.grad();
+  EXPECT_MATRIX_EQ(G, a.adj());
+  stan::math::recover_memory();
+}
+
+TEST(AgradRevZero, set_zero_all_adjoints_moved_matrix_adjoint) {
+  using stan::math::var_value;
+  var_value<Eigen::VectorXd> a(Eigen::VectorXd::Ones(3));
+  var_value<Eigen::VectorXd> b(Eigen::VectorXd::Ones(3));
+  const double* registered = a.adj().data();
+  // assigning an expression moves the adjoint to new arena memory
+  a.adj() = a.adj() + Eigen::VectorXd::Constant(3, 2.0);
+  EXPECT_NE(registered, a.adj().data());
+  stan::math::set_zero_all_adjoints();
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Zero(3), a.adj());
+
+  stan::math::start_nested();
+  var_value<Eigen::VectorXd> c(Eigen::VectorXd::Ones(3));
+  c.adj() = c.adj() + Eigen::VectorXd::Constant(3, 2.0);
+  a.adj() = a.adj() + Eigen::VectorXd::Constant(3, 2.0);
+  stan::math::set_zero_all_adjoints_nested();
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Zero(3), c.adj());
+  EXPECT_MATRIX_EQ(Eigen::VectorXd::Constant(3, 2.0), a.adj());
+  stan::math::recover_memory_nested();
+  stan::math::recover_memory();
+}
@@ -0,0 +1,120 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace soa_tape_test {
+template <typename T>
+T fun(const std::vector<T>& x) {
+  T lp = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    lp += x[i] * x[i] - 2.0 * x[i] + 1.5 - (3.0 - x[i]);
+    lp += x[i] * x[(i + 1) % x.size()];
+  }
+  return lp;
+}
+}  // namespace soa_tape_test
+
+TEST(AgradRevSoaTape, matches_grad) {
+  using stan::math::var;
+  std::vector<double> x_val{0.5, 1.5, -0.3, 2.0};
+  std::vector<double> expected;
+  {
+    stan::math::nested_rev_autodiff nested;
+    std::vector<var> x(x_val.begin(), x_val.end());
+    var f = soa_tape_test::fun(x);
+    f.grad();
+    for (auto& xi : x) {
+      expected.push_back(xi.adj());
+    }
+  }
+
+  stan::math::nested_rev_autodiff nested;
+  std::vector<var> x(x_val.begin(), x_val.end());
+  var f = soa_tape_test::fun(x);
+  stan::math::soa_tape tape{stan::math::compact_tape()};
+  EXPECT_LT(0U, tape.num_records());
+  EXPECT_EQ(tape.num_nodes(), tape.adjoints().size());
+  for (int n = 0; n < 3; ++n) {
+    tape.grad(f.vi_);
+    for (size_t i = 0; i < x.size(); ++i) {
+      EXPECT_FLOAT_EQ(expected[i], tape.adjoint(x[i].vi_));
+      // the adjoints of the varis are untouched
+      EXPECT_FLOAT_EQ(0.0, x[i].adj());
+    }
+  }
+
+  tape.scatter_adjoints();
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_FLOAT_EQ(expected[i], x[i].adj());
+  }
+  tape.set_zero_adjoints();
+  EXPECT_FLOAT_EQ(0.0, tape.adjoint(x[0].vi_));
+  tape.gather_adjoints();
+  EXPECT_FLOAT_EQ(expected[0], tape.adjoint(x[0].vi_));
+}
+
+TEST(AgradRevSoaTape, layout) {
+  using stan::math::var;
+  stan::math::nested_rev_autodiff nested;
+  var a = 2.0;
+  var b = 3.0;
+  var c = a * b;
+  var d = c - a;
+  stan::math::soa_tape tape{stan::math::compact_tape()};
+  ASSERT_EQ(2U, tape.num_records());
+  ASSERT_EQ(4U, tape.num_nodes());
+  for (const var& v : {a, b, c, d}) {
+    EXPECT_EQ(v.vi_, tape.nodes()[tape.id(v.vi_)]);
+  }
+  EXPECT_EQ(std::vector<uint32_t>({tape.id(c.vi_), tape.id(d.vi_)}),
+            tape.out_ids());
+  EXPECT_EQ(std::vector<uint32_t>({0, 2, 4}), tape.record_begin());
+  EXPECT_EQ(std::vector<uint32_t>({tape.id(a.vi_), tape.id(b.vi_),
+                                   tape.id(c.vi_), tape.id(a.vi_)}),
+            tape.operand_ids());
+  EXPECT_EQ(std::vector<double>({3.0, 2.0, 1.0, -1.0}), tape.partials());
+
+  var e = 1.0;
+  EXPECT_THROW(tape.id(e.vi_), std::invalid_argument);
+}
+
+TEST(AgradRevSoaTape, opaque) {
+  using stan::math::var;
+  // sum() and dot_self() of an Eigen vector are reverse pass callbacks,
+  // the first reading only its own adjoint
+  auto fun = [](const std::vector<var>& x) {
+    Eigen::Matrix<var, Eigen::Dynamic, 1> v(x.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+      v(i) = x[i] * x[(i + 1) % x.size()];
+    }
+    var s = stan::math::sum(v);
+    var d = stan::math::dot_self(v);
+    return s * x[0] + d * s - exp(x[1]) + stan::math::dot_self(v * d);
+  };
+  std::vector<double> x_val{0.5, 1.5, -0.3, 2.0};
+  std::vector<double> expected;
+  {
+    stan::math::nested_rev_autodiff nested;
+    std::vector<var> x(x_val.begin(), x_val.end());
+    var f = fun(x);
+    f.grad();
+    for (auto& xi : x) {
+      expected.push_back(xi.adj());
+    }
+  }
+
+  stan::math::nested_rev_autodiff nested;
+  std::vector<var> x(x_val.begin(), x_val.end());
+  var f = fun(x);
+  stan::math::compact_tape compact;
+  ASSERT_LT(0U, compact.num_opaque());
+  stan::math::soa_tape tape{compact};
+  for (int n = 0; n < 2; ++n) {
+    tape.grad(f.vi_);
+    for (size_t i = 0; i < x.size(); ++i) {
+      EXPECT_FLOAT_EQ(expected[i], tape.adjoint(x[i].vi_));
+    }
+    stan::math::set_zero_all_adjoints_nested();
+  }
+}
@@ -0,0 +1,191 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct trace_sum_lpdf {
+  template <typename T>
+  inline auto operator()(const std::vector<T>& slice, int start, int end,
+                         std::ostream* msgs) const {
+    return stan::math::sum(slice);
+  }
+};
+
+/**
+ * Return the number of begin and end events of every region name.
+ */
+std::map<std::string, std::pair<int, int>> count_events(
+    const std::vector<stan::math::trace_event>& events) {
+  std::map<std::string, std::pair<int, int>> counts;
+  for (const auto& event : events) {
+    if (event.phase_ == 'B') {
+      ++counts[event.name_].first;
+    } else {
+      ++counts[event.name_].second;
+    }
+  }
+  return counts;
+}
+}  // namespace
+
+TEST(AgradRev, trace_not_recording) {
+  stan::math::stop_trace();
+  stan::math::start_trace();
+  stan::math::stop_trace();
+  EXPECT_FALSE(stan::math::is_tracing());
+  { stan::math::trace_region region("ignored", "test"); }
+  EXPECT_TRUE(stan::math::trace_events().empty());
+}
+
+TEST(AgradRev, trace_profile_and_grad) {
+  using stan::math::var;
+  stan::math::profile_map profiles;
+  stan::math::start_trace();
+  EXPECT_TRUE(stan::math::is_tracing());
+  var x = 2.0;
+  var y;
+  {
+    stan::math::profile<var> p("outer", profiles);
+    y = x * x;
+  }
+  y.grad();
+  stan::math::stop_trace();
+  EXPECT_FLOAT_EQ(4.0, x.adj());
+
+  const auto events = stan::math::trace_events();
+  auto counts = count_events(events);
+  EXPECT_EQ(1, counts["outer"].first);
+  EXPECT_EQ(1, counts["outer"].second);
+  EXPECT_EQ(1, counts["outer (reverse)"].first);
+  EXPECT_EQ(1, counts["outer (reverse)"].second);
+  EXPECT_EQ(1, counts["reverse pass"].first);
+  EXPECT_EQ(1, counts["reverse pass"].second);
+  for (size_t i = 1; i < events.size(); ++i) {
+    EXPECT_LE(events[i - 1].timestamp_, events[i].timestamp_);
+  }
+  EXPECT_EQ("reverse pass", events.front().name_ == "outer"
+                                ? events.back().name_
+                                : events.front().name_);
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, trace_reduce_sum_and_json) {
+  using stan::math::var;
+  std::vector<var> data(100, 1.0);
+  stan::math::start_trace();
+  var sum = stan::math::reduce_sum<trace_sum_lpdf>(data, 10, nullptr);
+  Eigen::VectorXd x = Eigen::VectorXd::Ones(3);
+  double fx;
+  Eigen::VectorXd grad_fx;
+  stan::math::gradient([](const auto& v) { return stan::math::sum(v); }, x,
+                       fx, grad_fx);
+  stan::math::stop_trace();
+  EXPECT_FLOAT_EQ(100.0, sum.val());
+
+  auto counts = count_events(stan::math::trace_events());
+  EXPECT_GE(counts["reduce_sum chunk"].first, 1);
+  EXPECT_EQ(counts["reduce_sum chunk"].first,
+            counts["reduce_sum chunk"].second);
+  EXPECT_EQ(1, counts["forward pass"].first);
+  EXPECT_EQ(1, counts["forward pass"].second);
+
+  std::stringstream json;
+  stan::math::write_trace(json);
+  const std::string s = json.str();
+  EXPECT_NE(std::string::npos, s.find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, s.find("\"cat\": \"reduce_sum\""));
+  EXPECT_NE(std::string::npos, s.find("\"args\": {\"begin\": "));
+  EXPECT_NE(std::string::npos, s.find("\"ph\": \"B\""));
+  EXPECT_NE(std::string::npos, s.find("\"ph\": \"E\""));
+
+  stan::math::start_trace();
+  stan::math::stop_trace();
+  EXPECT_TRUE(stan::math::trace_events().empty());
+  EXPECT_THROW(stan::math::write_trace(std::string("/nonexistent/dir/t.json")),
+               std::invalid_argument);
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, trace_regions_stay_balanced) {
+  {
+    stan::math::start_trace();
+    stan::math::trace_region region("stopped", "test");
+    stan::math::stop_trace();
+  }
+  auto counts = count_events(stan::math::trace_events());
+  EXPECT_EQ(1, counts["stopped"].first);
+  EXPECT_EQ(1, counts["stopped"].second);
+
+  {
+    stan::math::trace_region region("restarted", "test");
+    stan::math::start_trace();
+  }
+  stan::math::stop_trace();
+  EXPECT_TRUE(stan::math::trace_events().empty());
+}
+
+TEST(AgradRev, trace_profile_reverse_follows_forward) {
+  using stan::math::var;
+  stan::math::profile_map profiles;
+  var x = 2.0;
+  var y;
+
+  // forward pass recorded, reverse pass after the trace is stopped
+  stan::math::start_trace();
+  {
+    stan::math::profile<var> p("traced", profiles);
+    y = x * x;
+  }
+  stan::math::stop_trace();
+  y.grad();
+  auto counts = count_events(stan::math::trace_events());
+  EXPECT_EQ(1, counts["traced"].first);
+  EXPECT_EQ(1, counts["traced"].second);
+  EXPECT_EQ(1, counts["traced (reverse)"].first);
+  EXPECT_EQ(1, counts["traced (reverse)"].second);
+  stan::math::recover_memory();
+
+  // forward pass before the trace is started
+  x = 2.0;
+  {
+    stan::math::profile<var> p("untraced", profiles);
+    y = x * x;
+  }
+  stan::math::start_trace();
+  y.grad();
+  stan::math::stop_trace();
+  counts = count_events(stan::math::trace_events());
+  EXPECT_EQ(0, counts.count("untraced (reverse)"));
+  EXPECT_EQ(counts["reverse pass"].first, counts["reverse pass"].second);
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, trace_concurrent_recording) {
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&done] {
+      while (!done.load()) {
+        stan::math::trace_region region("worker", "test");
+      }
+    });
+  }
+  for (int i = 0; i < 50; ++i) {
+    stan::math::start_trace();
+    stan::math::trace_events();
+    std::stringstream json;
+    stan::math::write_trace(json);
+  }
+  stan::math::stop_trace();
+  done.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto counts = count_events(stan::math::trace_events());
+  EXPECT_EQ(counts["worker"].first, counts["worker"].second);
+}
@@ -60,3 +60,110 @@ TEST(AgradRev, to_arena_matrix_test) {
   EXPECT_EQ(b.size(), c.size());
   EXPECT_EQ(b.data(), c.data());
 }
+
+TEST(AgradRev, to_arena_pinned_data_test) {
+  using stan::math::arena_matrix;
+  Eigen::MatrixXd a(2, 2);
+  a << 1, 2, 3, 4;
+  auto pinned = stan::math::pin_data(a);
+  auto b = stan::math::to_arena(pinned);
+  EXPECT_TRUE(
+      (std::is_same<decltype(b), arena_matrix<const Eigen::MatrixXd>>::value));
+  EXPECT_TRUE((std::is_same<stan::arena_t<decltype(pinned)>,
+                            arena_matrix<const Eigen::MatrixXd>>::value));
+  EXPECT_TRUE((std::is_same<decltype(b.data()), const double*>::value));
+  EXPECT_EQ(pinned.data(), b.data());
+  EXPECT_MATRIX_EQ(a, b);
+
+  arena_matrix<const Eigen::MatrixXd> c;
+  c = pinned;
+  EXPECT_EQ(pinned.data(), c.data());
+
+  // writable arena matrices get a copy of the pinned data
+  arena_matrix<Eigen::MatrixXd> d(pinned);
+  EXPECT_NE(pinned.data(), d.data());
+  EXPECT_MATRIX_EQ(a, d);
+  d(0, 0) = 10;
+  EXPECT_FLOAT_EQ(1, pinned(0, 0));
+  arena_matrix<Eigen::MatrixXd> e;
+  e = pinned;
+  EXPECT_NE(pinned.data(), e.data());
+  EXPECT_MATRIX_EQ(a, e);
+  stan::arena_t<Eigen::MatrixXd> f = pinned;
+  EXPECT_NE(pinned.data(), f.data());
+  EXPECT_NE(pinned.data(), stan::math::to_arena(a).data());
+
+  // the idiom rev functions use to store the values of data arguments
+  using stan::math::promote_scalar_t;
+  EXPECT_TRUE((std::is_same<promote_scalar_t<double, decltype(pinned)>,
+                            decltype(pinned)>::value));
+  EXPECT_TRUE((std::is_same<promote_scalar_t<stan::math::var, decltype(pinned)>,
+                            Eigen::Matrix<stan::math::var, -1, -1>>::value));
+  stan::arena_t<promote_scalar_t<double, decltype(pinned)>> g
+      = stan::math::value_of(pinned);
+  EXPECT_EQ(pinned.data(), g.data());
+
+  stan::math::var_value<Eigen::MatrixXd> x = a;
+  auto y = stan::math::sum(stan::math::multiply(x, pinned));
+  y.grad();
+  EXPECT_FLOAT_EQ((a * a).sum(), y.val());
+  EXPECT_MATRIX_EQ(a, pinned);
+  stan::math::recover_memory();
+}
+
+TEST(AgradRev, to_arena_pinned_data_rev_function_test) {
+  Eigen::MatrixXd a = Eigen::MatrixXd::Random(20, 20);
+  auto pinned = stan::math::pin_data(a);
+  const auto& mem = stan::math::ChainableStack::instance_->memalloc_;
+  stan::math::var_value<Eigen::MatrixXd> x = a;
+  Eigen::Matrix<stan::math::var, -1, -1> x_scalar = a;
+
+  // multiply stores the data argument on the arena unless it is pinned
+  size_t start = mem.bytes_used();
+  auto y_pinned = stan::math::multiply(x, pinned);
+  const size_t bytes_pinned = mem.bytes_used() - start;
+  start = mem.bytes_used();
+  auto y_copied = stan::math::multiply(x, a);
+  const size_t bytes_copied = mem.bytes_used() - start;
+  EXPECT_LE(bytes_pinned + a.size() * sizeof(double), bytes_copied);
+
+  start = mem.bytes_used();
+  auto z_pinned = stan::math::multiply(x_scalar, pinned);
+  const size_t bytes_scalar_pinned = mem.bytes_used() - start;
+  start = mem.bytes_used();
+  auto z_copied = stan::math::multiply(x_scalar, a);
+  const size_t bytes_scalar_copied = mem.bytes_used() - start;
+  EXPECT_LE(bytes_scalar_pinned + a.size() * sizeof(double),
+            bytes_scalar_copied);
+
+  stan::math::var lp = stan::math::sum(y_pinned) + stan::math::sum(z_pinned);
+  lp.grad();
+  Eigen::MatrixXd expected_adj
+      = Eigen::MatrixXd::Ones(20, 20) * a.transpose();
+  EXPECT_MATRIX_FLOAT_EQ(expected_adj, x.adj());
+  EXPECT_MATRIX_FLOAT_EQ(expected_adj, x_scalar.adj());
+  EXPECT_MATRIX_FLOAT_EQ(y_copied.val(), y_pinned.val());
+  EXPECT_MATRIX_FLOAT_EQ(z_copied.val(), z_pinned.val());
+  stan::math::recover_memory();
+}
+
+struct pinned_dot_functor {
+  const stan::math::pinned_data<Eigen::MatrixXd>& data_;
+  template <typename T>
+  T operator()(const Eigen::Matrix<T, Eigen::Dynamic, 1>& x) const {
+    return stan::math::sum(stan::math::multiply(data_, x));
+  }
+};
+
+TEST(AgradRev, to_arena_pinned_data_shared_test) {
+  Eigen::MatrixXd a = Eigen::MatrixXd::Random(5, 3);
+  auto pinned = stan::math::pin_data(a);
+  Eigen::MatrixXd x = Eigen::MatrixXd::Random(3, 64);
+  Eigen::VectorXd fx;
+  Eigen::MatrixXd grad_fx;
+  stan::math::gradient_batch(pinned_dot_functor{pinned}, x, fx, grad_fx);
+  for (int k = 0; k < x.cols(); ++k) {
+    EXPECT_FLOAT_EQ((a * x.col(k)).sum(), fx(k));
+    EXPECT_MATRIX_FLOAT_EQ(a.colwise().sum().transpose(), grad_fx.col(k));
+  }
+}
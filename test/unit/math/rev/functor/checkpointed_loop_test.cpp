@@ -0,0 +1,116 @@
+#include <stan/math/rev.hpp>
+#include <test/unit/math/rev/util.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace checkpointed_loop_test {
+struct step {
+  template <typename T, typename T_theta>
+  Eigen::Matrix<stan::return_type_t<T, T_theta>, Eigen::Dynamic, 1> operator()(
+      const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, int t, std::ostream* msgs,
+      const Eigen::Matrix<T_theta, Eigen::Dynamic, 1>& theta,
+      const std::vector<double>& data) const {
+    const Eigen::Index n = x.size();
+    Eigen::Matrix<stan::return_type_t<T, T_theta>, Eigen::Dynamic, 1> y(n);
+    for (Eigen::Index i = 0; i < n; ++i) {
+      y(i) = x(i) + 0.1 * theta(0) * sin(x((i + 1) % n))
+             + 0.01 * t * theta(1) * data[i];
+    }
+    return y;
+  }
+};
+
+template <typename T, typename T_theta>
+Eigen::Matrix<stan::return_type_t<T, T_theta>, Eigen::Dynamic, 1> taped_loop(
+    const Eigen::Matrix<T, Eigen::Dynamic, 1>& x0, int num_steps,
+    const Eigen::Matrix<T_theta, Eigen::Dynamic, 1>& theta,
+    const std::vector<double>& data) {
+  Eigen::Matrix<stan::return_type_t<T, T_theta>, Eigen::Dynamic, 1> x = x0;
+  for (int t = 0; t < num_steps; ++t) {
+    x = step()(x, t, nullptr, theta, data);
+  }
+  return x;
+}
+}  // namespace checkpointed_loop_test
+
+TEST_F(AgradRev, checkpointed_loop_gradient) {
+  using stan::math::var;
+  using stan::math::vector_v;
+  Eigen::VectorXd x0_val(3);
+  x0_val << 0.5, -1.0, 2.0;
+  Eigen::VectorXd theta_val(2);
+  theta_val << 1.3, -0.7;
+  std::vector<double> data{1.0, 2.0, 3.0};
+
+  for (int num_steps : {0, 1, 2, 7, 37}) {
+    vector_v x0 = x0_val;
+    vector_v theta = theta_val;
+    vector_v expected
+        = checkpointed_loop_test::taped_loop(x0, num_steps, theta, data);
+    vector_v x0_c = x0_val;
+    vector_v theta_c = theta_val;
+    size_t stack_size
+        = stan::math::ChainableStack::instance_->var_stack_.size();
+    vector_v result = stan::math::checkpointed_loop(
+        checkpointed_loop_test::step(), x0_c, num_steps, nullptr, theta_c,
+        data);
+    // a single callback is put on the tape
+    EXPECT_EQ(stack_size + 1,
+              stan::math::ChainableStack::instance_->var_stack_.size());
+    EXPECT_MATRIX_FLOAT_EQ(expected.val(), result.val());
+
+    for (Eigen::Index i = 0; i < result.size(); ++i) {
+      stan::math::set_zero_all_adjoints();
+      expected(i).grad();
+      Eigen::VectorXd x0_adj = x0.adj();
+      Eigen::VectorXd theta_adj = theta.adj();
+      stan::math::set_zero_all_adjoints();
+      result(i).grad();
+      EXPECT_MATRIX_FLOAT_EQ(x0_adj, x0_c.adj());
+      EXPECT_MATRIX_FLOAT_EQ(theta_adj, theta_c.adj());
+    }
+    stan::math::recover_memory();
+  }
+}
+
+TEST_F(AgradRev, checkpointed_loop_data_state) {
+  using stan::math::var;
+  using stan::math::vector_v;
+  Eigen::VectorXd x0(3);
+  x0 << 0.5, -1.0, 2.0;
+  Eigen::VectorXd theta_val(2);
+  theta_val << 1.3, -0.7;
+  std::vector<double> data{1.0, 2.0, 3.0};
+
+  vector_v theta = theta_val;
+  vector_v expected = checkpointed_loop_test::taped_loop(x0, 10, theta, data);
+  vector_v theta_c = theta_val;
+  vector_v result = stan::math::checkpointed_loop(
+      checkpointed_loop_test::step(), x0, 10, nullptr, theta_c, data);
+  var lp = sum(expected);
+  var lp_c = sum(result);
+  EXPECT_FLOAT_EQ(lp.val(), lp_c.val());
+  lp.grad();
+  Eigen::VectorXd theta_adj = theta.adj();
+  stan::math::set_zero_all_adjoints();
+  lp_c.grad();
+  EXPECT_MATRIX_FLOAT_EQ(theta_adj, theta_c.adj());
+}
+
+TEST_F(AgradRev, checkpointed_loop_errors) {
+  using stan::math::vector_v;
+  Eigen::VectorXd x0_val(3);
+  x0_val << 0.5, -1.0, 2.0;
+  vector_v theta = Eigen::VectorXd::Ones(2);
+  std::vector<double> data{1.0, 2.0, 3.0};
+  EXPECT_THROW(stan::math::checkpointed_loop(checkpointed_loop_test::step(),
+                                             x0_val, -1, nullptr, theta, data),
+               std::domain_error);
+  Eigen::VectorXd theta_d = Eigen::VectorXd::Ones(2);
+  EXPECT_MATRIX_FLOAT_EQ(
+      checkpointed_loop_test::taped_loop(x0_val, 4, theta_d, data),
+      stan::math::checkpointed_loop(checkpointed_loop_test::step(), x0_val, 4,
+                                    nullptr, theta_d, data));
+}
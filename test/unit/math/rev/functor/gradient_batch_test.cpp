@@ -0,0 +1,144 @@
+#include <stan/math/rev.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using Eigen::Dynamic;
+using Eigen::Matrix;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+// fun1(x, y) = (x^2 * y) + (3 * y^2)
+struct batch_fun1 {
+  template <typename T>
+  inline T operator()(const Matrix<T, Dynamic, 1>& x) const {
+    return x(0) * x(0) * x(1) + 3.0 * x(1) * x(1);
+  }
+};
+
+// branches on the value of its argument, so the tapes differ
+struct batch_branch_fun {
+  template <typename T>
+  inline T operator()(const Matrix<T, Dynamic, 1>& x) const {
+    if (x(0) > 0) {
+      return x(0) * x(1);
+    }
+    return stan::math::exp(x(1)) - x(0);
+  }
+};
+
+// records a vari which is not linearizable
+struct batch_opaque_fun {
+  template <typename T>
+  inline T operator()(const Matrix<T, Dynamic, 1>& x) const {
+    return stan::math::dot_self(x) + x(0);
+  }
+};
+
+// records a vari which is not linearizable for some of its arguments
+struct batch_mixed_fun {
+  template <typename T>
+  inline T operator()(const Matrix<T, Dynamic, 1>& x) const {
+    if (x(0) > 0) {
+      return x(0) * x(1);
+    }
+    return stan::math::dot_self(x) - x(1);
+  }
+};
+
+struct batch_throw_fun {
+  template <typename T>
+  inline T operator()(const Matrix<T, Dynamic, 1>& x) const {
+    if (x(0) < 0) {
+      throw std::domain_error("negative");
+    }
+    return stan::math::log(x(0));
+  }
+};
+
+TEST(RevFunctor, gradient_batch) {
+  batch_fun1 f;
+  MatrixXd x(2, 5);
+  x << 5, 1, -2, 0.5, 3, 7, 2, 4, -1.5, 0;
+  for (int lanes : {1, 2, 10}) {
+    VectorXd fx;
+    MatrixXd grad_fx;
+    stan::math::gradient_batch(f, x, fx, grad_fx, lanes);
+    ASSERT_EQ(5, fx.size());
+    ASSERT_EQ(2, grad_fx.rows());
+    ASSERT_EQ(5, grad_fx.cols());
+    for (int k = 0; k < x.cols(); ++k) {
+      double fx_k;
+      VectorXd grad_fx_k;
+      stan::math::gradient(f, VectorXd(x.col(k)), fx_k, grad_fx_k);
+      EXPECT_FLOAT_EQ(fx_k, fx(k));
+      EXPECT_FLOAT_EQ(grad_fx_k(0), grad_fx(0, k));
+      EXPECT_FLOAT_EQ(grad_fx_k(1), grad_fx(1, k));
+    }
+  }
+  EXPECT_EQ(0, stan::math::ChainableStack::instance_->var_stack_.size());
+}
+
+TEST(RevFunctor, gradient_batch_empty) {
+  batch_fun1 f;
+  MatrixXd x(2, 0);
+  VectorXd fx;
+  MatrixXd grad_fx;
+  stan::math::gradient_batch(f, x, fx, grad_fx);
+  EXPECT_EQ(0, fx.size());
+  EXPECT_EQ(2, grad_fx.rows());
+  EXPECT_EQ(0, grad_fx.cols());
+}
+
+TEST(RevFunctor, gradient_batch_keeps_outer_tape) {
+  stan::math::var a = 2.0;
+  stan::math::var b = a * a;
+  batch_fun1 f;
+  MatrixXd x = MatrixXd::Ones(2, 3);
+  VectorXd fx;
+  MatrixXd grad_fx;
+  stan::math::gradient_batch(f, x, fx, grad_fx);
+  b.grad();
+  EXPECT_FLOAT_EQ(4.0, a.adj());
+  stan::math::recover_memory();
+}
+
+TEST(RevFunctor, gradient_batch_throws) {
+  batch_throw_fun f;
+  MatrixXd x(1, 3);
+  x << 1, -1, 2;
+  VectorXd fx;
+  MatrixXd grad_fx;
+  EXPECT_THROW(stan::math::gradient_batch(f, x, fx, grad_fx),
+               std::domain_error);
+  EXPECT_THROW(stan::math::gradient_batch(f, x, fx, grad_fx, 0),
+               std::domain_error);
+  x(1) = 4;
+  stan::math::gradient_batch(f, x, fx, grad_fx);
+  EXPECT_FLOAT_EQ(0.25, grad_fx(0, 1));
+}
+
+template <typename F>
+void expect_gradient_batch(const F& f, const MatrixXd& x, int lanes) {
+  VectorXd fx;
+  MatrixXd grad_fx;
+  stan::math::gradient_batch(f, x, fx, grad_fx, lanes);
+  for (int k = 0; k < x.cols(); ++k) {
+    double fx_k;
+    VectorXd grad_fx_k;
+    stan::math::gradient(f, VectorXd(x.col(k)), fx_k, grad_fx_k);
+    EXPECT_FLOAT_EQ(fx_k, fx(k));
+    for (int i = 0; i < x.rows(); ++i) {
+      EXPECT_FLOAT_EQ(grad_fx_k(i), grad_fx(i, k));
+    }
+  }
+}
+
+TEST(RevFunctor, gradient_batch_falls_back_per_lane) {
+  MatrixXd x(2, 7);
+  x << 1, -1, 2, -3, 0.5, 4, -0.5, 2, 1, -1, 0.5, 3, -2, 1.5;
+  for (int lanes : {1, 3, 8}) {
+    expect_gradient_batch(batch_branch_fun(), x, lanes);
+    expect_gradient_batch(batch_opaque_fun(), x, lanes);
+    expect_gradient_batch(batch_mixed_fun(), x, lanes);
+  }
+}
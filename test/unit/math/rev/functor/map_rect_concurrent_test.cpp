@@ -11,10 +11,58 @@
 #include <test/unit/math/prim/functor/hard_work.hpp>
 #include <test/unit/math/prim/functor/utils_threads.hpp>
 
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+
 #include <iostream>
 #include <vector>
 
+// the terms of a job, summed by reduce_sum
+struct job_terms_lpdf {
+  template <typename T1, typename T2>
+  inline auto operator()(const std::vector<double>& slice, std::size_t start,
+                         std::size_t end, std::ostream* msgs, const T1& mu,
+                         const T2& sigma) const {
+    stan::return_type_t<T1, T2> lp = 0;
+    for (double y : slice) {
+      lp -= 0.5 * (y - mu) * (y - mu) / (sigma * sigma);
+    }
+    return lp;
+  }
+};
+
+// a job whose log density is a reduce_sum over its data
+struct reduce_sum_job {
+  template <typename T1, typename T2>
+  Eigen::Matrix<stan::return_type_t<T1, T2>, Eigen::Dynamic, 1> operator()(
+      const Eigen::Matrix<T1, Eigen::Dynamic, 1>& eta,
+      const Eigen::Matrix<T2, Eigen::Dynamic, 1>& theta,
+      const std::vector<double>& x_r, const std::vector<int>& x_i,
+      std::ostream* msgs = nullptr) const {
+    Eigen::Matrix<stan::return_type_t<T1, T2>, Eigen::Dynamic, 1> res(1);
+    res(0) = stan::math::reduce_sum<job_terms_lpdf>(x_r, 2, msgs,
+                                                    eta(0) + theta(0), eta(1));
+    return res;
+  }
+};
+
+// a job returning whether it runs as an AD task
+struct ad_task_probe_job {
+  template <typename T1, typename T2>
+  Eigen::Matrix<stan::return_type_t<T1, T2>, Eigen::Dynamic, 1> operator()(
+      const Eigen::Matrix<T1, Eigen::Dynamic, 1>& eta,
+      const Eigen::Matrix<T2, Eigen::Dynamic, 1>& theta,
+      const std::vector<double>& x_r, const std::vector<int>& x_i,
+      std::ostream* msgs = nullptr) const {
+    Eigen::Matrix<stan::return_type_t<T1, T2>, Eigen::Dynamic, 1> res(1);
+    res(0) = eta(0) * 0.0 + static_cast<double>(stan::math::in_ad_task());
+    return res;
+  }
+};
+
 STAN_REGISTER_MAP_RECT(0, hard_work)
+STAN_REGISTER_MAP_RECT(1, reduce_sum_job)
+STAN_REGISTER_MAP_RECT(2, ad_task_probe_job)
 
 struct map_rect_con : public ::testing::Test {
   Eigen::VectorXd shared_params_d;
@@ -163,3 +211,121 @@ TEST_F(map_rect_con, concurrent_eval_ok_vv) {
     }
   }
 }
+
+TEST_F(map_rect_con, concurrent_vjp_aliased_params) {
+  using stan::math::var;
+  using stan::math::vector_v;
+  // the job specific parameters share their vars with the shared ones
+  vector_v shared_params_v = stan::math::to_var(shared_params_d);
+  std::vector<vector_v> job_params_v(N, shared_params_v);
+
+  vector_v res = stan::math::map_rect<0, hard_work>(shared_params_v,
+                                                    job_params_v, x_r, x_i);
+  var lp = 0;
+  for (int i = 0; i < res.size(); ++i) {
+    lp += (i + 1.0) * res(i);
+  }
+
+  vector_v shared_ref = stan::math::to_var(shared_params_d);
+  var lp_ref = 0;
+  int i = 0;
+  for (std::size_t n = 0; n < N; ++n) {
+    vector_v res_n = hard_work()(shared_ref, shared_ref, x_r[n], x_i[n]);
+    for (int m = 0; m < res_n.size(); ++m) {
+      lp_ref += (++i) * res_n(m);
+    }
+  }
+  EXPECT_FLOAT_EQ(lp.val(), lp_ref.val());
+
+  // the reverse pass can be repeated
+  for (int pass = 0; pass < 2; ++pass) {
+    stan::math::set_zero_all_adjoints();
+    lp.grad();
+    const double adj0 = shared_params_v(0).adj();
+    const double adj1 = shared_params_v(1).adj();
+    stan::math::set_zero_all_adjoints();
+    lp_ref.grad();
+    EXPECT_FLOAT_EQ(adj0, shared_ref(0).adj());
+    EXPECT_FLOAT_EQ(adj1, shared_ref(1).adj());
+  }
+
+  // the tapes of the jobs are returned to the pool with the tape
+  stan::math::recover_memory();
+  EXPECT_GT(stan::math::pooled_chainablestack::pool_size(), 0);
+}
+
+TEST_F(map_rect_con, concurrent_nested_reduce_sum_task_arena) {
+  using stan::math::var;
+  using stan::math::vector_v;
+  const int num_jobs = 24;
+  const int num_terms = 30;
+  std::vector<std::vector<double>> y(num_jobs);
+  std::vector<std::vector<int>> y_i(num_jobs);
+  Eigen::VectorXd eta_d(2);
+  eta_d << 0.5, 1.5;
+  for (int n = 0; n < num_jobs; ++n) {
+    for (int j = 0; j < num_terms; ++j) {
+      y[n].push_back(0.1 * n - 0.05 * j);
+    }
+  }
+
+  vector_v eta_ref = stan::math::to_var(eta_d);
+  std::vector<vector_v> theta_ref;
+  var lp_ref = 0;
+  for (int n = 0; n < num_jobs; ++n) {
+    theta_ref.push_back(stan::math::to_var(Eigen::VectorXd::Constant(1, n)
+                                               .eval()));
+    lp_ref += job_terms_lpdf()(y[n], 0, num_terms - 1, nullptr,
+                               eta_ref(0) + theta_ref[n](0), eta_ref(1));
+  }
+  lp_ref.grad();
+  const double lp_ref_val = lp_ref.val();
+  const Eigen::VectorXd eta_ref_adj = eta_ref.adj();
+  std::vector<double> theta_ref_adj;
+  for (int n = 0; n < num_jobs; ++n) {
+    theta_ref_adj.push_back(theta_ref[n](0).adj());
+  }
+
+  // an explicit arena with several threads, so that threads waiting for
+  // the reduce_sum of a job run other jobs even on one core
+  tbb::global_control parallelism(
+      tbb::global_control::max_allowed_parallelism, 8);
+  tbb::task_arena arena(8);
+  arena.execute([&] {
+    for (int pass = 0; pass < 5; ++pass) {
+      vector_v eta = stan::math::to_var(eta_d);
+      std::vector<vector_v> theta;
+      for (int n = 0; n < num_jobs; ++n) {
+        theta.push_back(
+            stan::math::to_var(Eigen::VectorXd::Constant(1, n).eval()));
+      }
+      var lp = stan::math::sum(
+          stan::math::map_rect<1, reduce_sum_job>(eta, theta, y, y_i));
+      EXPECT_FLOAT_EQ(lp_ref_val, lp.val());
+      stan::math::set_zero_all_adjoints();
+      lp.grad();
+      EXPECT_FLOAT_EQ(eta_ref_adj(0), eta(0).adj());
+      EXPECT_FLOAT_EQ(eta_ref_adj(1), eta(1).adj());
+      for (int n = 0; n < num_jobs; ++n) {
+        EXPECT_FLOAT_EQ(theta_ref_adj[n], theta[n](0).adj());
+      }
+    }
+  });
+  stan::math::recover_memory();
+}
+
+TEST_F(map_rect_con, concurrent_double_jobs_skip_ad_tasks) {
+  Eigen::VectorXd res_d = stan::math::map_rect<2, ad_task_probe_job>(
+      shared_params_d, job_params_d, x_r, x_i);
+  stan::math::vector_v shared_params_v = stan::math::to_var(shared_params_d);
+  stan::math::vector_v res_v = stan::math::map_rect<2, ad_task_probe_job>(
+      shared_params_v, job_params_d, x_r, x_i);
+  ASSERT_EQ(N, res_d.size());
+  ASSERT_EQ(N, res_v.size());
+  for (std::size_t i = 0; i < N; ++i) {
+    // only jobs with vars run as AD tasks on tapes of their own
+    EXPECT_FLOAT_EQ(0.0, res_d(i));
+    EXPECT_FLOAT_EQ(1.0, res_v(i).val());
+  }
+  stan::math::recover_memory();
+}
@@ -0,0 +1,35 @@
+#include <stan/math.hpp>
+#include <test/unit/math/prim/functor/reduce_sum_util.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(StanMathRev_reduce_sum_auto, grad) {
+  using stan::math::var;
+  using stan::math::test::count_lpdf;
+  using stan::math::test::get_new_msg;
+  std::vector<int> data(1000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i % 20;
+  }
+  std::vector<int> idata;
+  for (int i = 0; i < 12; ++i) {
+    var lambda_v = 10.0;
+    std::vector<var> vlambda_v(1, lambda_v);
+    var poisson_lpdf = stan::math::reduce_sum_auto<count_lpdf<var>>(
+        data, get_new_msg(), vlambda_v, idata);
+    var lambda_ref = 10.0;
+    var poisson_lpdf_ref = stan::math::poisson_lpmf(data, lambda_ref);
+    EXPECT_FLOAT_EQ(value_of(poisson_lpdf), value_of(poisson_lpdf_ref));
+    stan::math::grad(poisson_lpdf.vi_);
+    const double lambda_adj = lambda_v.adj();
+    stan::math::set_zero_all_adjoints();
+    stan::math::grad(poisson_lpdf_ref.vi_);
+    EXPECT_FLOAT_EQ(lambda_ref.adj(), lambda_adj);
+    stan::math::recover_memory();
+  }
+#ifdef STAN_THREADS
+  EXPECT_TRUE(stan::math::internal::reduce_sum_auto_tuner<count_lpdf<var>>(
+                  data.size(), tbb::this_task_arena::max_concurrency())
+                  .converged());
+#endif
+}
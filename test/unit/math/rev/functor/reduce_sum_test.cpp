@@ -1,6 +1,8 @@
 #include <stan/math.hpp>
 #include <test/unit/math/prim/functor/reduce_sum_util.hpp>
 #include <gtest/gtest.h>
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
 #include <algorithm>
 #include <sstream>
 #include <tuple>
@@ -428,3 +430,150 @@ TEST(StanMathRev_reduce_sum, linked_args) {
 
   stan::math::recover_memory();
 }
+
+struct var_matrix_lpdf {
+  template <typename T1, typename T2, typename T3>
+  inline auto operator()(const std::vector<int>& rows, std::size_t start,
+                         std::size_t end, std::ostream* msgs, const T1& x,
+                         const T2& beta, const T3& sigma) const {
+    stan::math::var lp = 0;
+    for (int i : rows) {
+      lp += stan::math::square(stan::math::multiply(x.row(i), beta) / sigma);
+    }
+    return lp;
+  }
+};
+
+TEST(StanMathRev_reduce_sum, var_matrix_shared_arg) {
+  using stan::math::var;
+  using stan::math::var_value;
+  using stan::math::test::get_new_msg;
+  const int N = 1000;
+  const int K = 5;
+  Eigen::MatrixXd x = Eigen::MatrixXd::Random(N, K);
+  Eigen::VectorXd beta_d = Eigen::VectorXd::Random(K);
+  std::vector<int> rows(N);
+  for (int i = 0; i < N; ++i) {
+    rows[i] = i;
+  }
+
+  var_value<Eigen::VectorXd> beta_ref = beta_d;
+  var sigma_ref = 2.0;
+  var lp_ref = var_matrix_lpdf()(rows, 0, N - 1, nullptr, x, beta_ref,
+                                 sigma_ref);
+  stan::math::grad(lp_ref.vi_);
+  const Eigen::VectorXd beta_ref_adj = beta_ref.adj();
+  const double sigma_ref_adj = sigma_ref.adj();
+
+  for (int deterministic = 0; deterministic < 2; ++deterministic) {
+    stan::math::set_zero_all_adjoints();
+    var_value<Eigen::VectorXd> beta = beta_d;
+    var sigma = 2.0;
+    var lp = deterministic
+                 ? stan::math::reduce_sum_static<var_matrix_lpdf>(
+                     rows, 10, get_new_msg(), Eigen::MatrixXd(x), beta, sigma)
+                 : stan::math::reduce_sum<var_matrix_lpdf>(
+                     rows, 10, get_new_msg(), Eigen::MatrixXd(x), beta, sigma);
+    EXPECT_FLOAT_EQ(lp.val(), lp_ref.val());
+    stan::math::grad(lp.vi_);
+    for (int k = 0; k < K; ++k) {
+      EXPECT_FLOAT_EQ(beta.adj()(k), beta_ref_adj(k));
+    }
+    EXPECT_FLOAT_EQ(sigma.adj(), sigma_ref_adj);
+  }
+
+  stan::math::recover_memory();
+}
+
+// the terms of a group
+template <bool Static>
+struct nested_group_lpdf {
+  template <typename T1, typename T2>
+  inline auto operator()(const std::vector<T1>& slice, std::size_t start,
+                         std::size_t end, std::ostream* msgs,
+                         const T2& mu) const {
+    stan::return_type_t<T1, T2> lp = 0;
+    for (const auto& y : slice) {
+      lp -= 0.5 * (y - mu) * (y - mu);
+    }
+    return lp;
+  }
+};
+
+// the groups, each summed by an inner reduce_sum
+template <bool Static>
+struct nested_groups_lpdf {
+  template <typename T1, typename T2>
+  inline auto operator()(const std::vector<std::vector<T1>>& slice,
+                         std::size_t start, std::size_t end,
+                         std::ostream* msgs,
+                         const std::vector<T2>& mu) const {
+    stan::return_type_t<T1, T2> lp = 0;
+    for (std::size_t i = 0; i < slice.size(); ++i) {
+      lp += Static ? stan::math::reduce_sum_static<nested_group_lpdf<Static>>(
+                slice[i], 3, msgs, mu[start + i])
+                   : stan::math::reduce_sum<nested_group_lpdf<Static>>(
+                       slice[i], 3, msgs, mu[start + i]);
+    }
+    return lp;
+  }
+};
+
+template <bool Static>
+void expect_nested_reduce_sum_gradient() {
+  using stan::math::var;
+  const int num_groups = 16;
+  const int group_size = 40;
+  std::vector<std::vector<var>> y(num_groups);
+  std::vector<var> mu;
+  for (int g = 0; g < num_groups; ++g) {
+    mu.emplace_back(0.05 * g);
+    for (int j = 0; j < group_size; ++j) {
+      y[g].emplace_back(0.1 * g + 0.01 * j);
+    }
+  }
+
+  var lp_ref = 0;
+  for (int g = 0; g < num_groups; ++g) {
+    lp_ref += nested_group_lpdf<Static>()(y[g], 0, group_size - 1, nullptr,
+                                          mu[g]);
+  }
+  stan::math::grad(lp_ref.vi_);
+  std::vector<double> mu_ref_adj;
+  std::vector<double> y_ref_adj;
+  for (int g = 0; g < num_groups; ++g) {
+    mu_ref_adj.push_back(mu[g].adj());
+    for (int j = 0; j < group_size; ++j) {
+      y_ref_adj.push_back(y[g][j].adj());
+    }
+  }
+
+  for (int n = 0; n < 5; ++n) {
+    stan::math::set_zero_all_adjoints();
+    var lp = Static ? stan::math::reduce_sum_static<nested_groups_lpdf<Static>>(
+                 y, 1, nullptr, mu)
+                    : stan::math::reduce_sum<nested_groups_lpdf<Static>>(
+                        y, 1, nullptr, mu);
+    EXPECT_FLOAT_EQ(lp_ref.val(), lp.val());
+    stan::math::grad(lp.vi_);
+    for (int g = 0; g < num_groups; ++g) {
+      EXPECT_FLOAT_EQ(mu_ref_adj[g], mu[g].adj());
+      for (int j = 0; j < group_size; ++j) {
+        EXPECT_FLOAT_EQ(y_ref_adj[g * group_size + j], y[g][j].adj());
+      }
+    }
+  }
+  stan::math::recover_memory();
+}
+
+TEST(StanMathRev_reduce_sum, nested_reduce_sum_gradient_task_arena) {
+  // an explicit arena with several threads, so that threads waiting for
+  // an inner reduce_sum steal chunks of other groups even on one core
+  tbb::global_control parallelism(
+      tbb::global_control::max_allowed_parallelism, 8);
+  tbb::task_arena arena(8);
+  arena.execute([] {
+    expect_nested_reduce_sum_gradient<false>();
+    expect_nested_reduce_sum_gradient<true>();
+  });
+}
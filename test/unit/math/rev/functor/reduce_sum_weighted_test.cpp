@@ -0,0 +1,33 @@
+#include <stan/math.hpp>
+#include <test/unit/math/prim/functor/reduce_sum_util.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(StanMathRev_reduce_sum_weighted, grad) {
+  using stan::math::var;
+  using stan::math::test::count_lpdf;
+  using stan::math::test::get_new_msg;
+  std::vector<int> data(1000);
+  std::vector<double> weights(1000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i % 20;
+    weights[i] = 1.0 + i % 7;
+  }
+  std::vector<int> idata;
+  var lambda_ref = 10.0;
+  var poisson_lpdf_ref = stan::math::poisson_lpmf(data, lambda_ref);
+  stan::math::grad(poisson_lpdf_ref.vi_);
+  for (int i = 0; i < 6; ++i) {
+    stan::math::nested_rev_autodiff nested;
+    var lambda_v = 10.0;
+    std::vector<var> vlambda_v(1, lambda_v);
+    var lpdf = i == 0 ? stan::math::reduce_sum_weighted<count_lpdf<var>>(
+                   data, weights, 16, get_new_msg(), vlambda_v, idata)
+                      : stan::math::reduce_sum_weighted<count_lpdf<var>>(
+                          data, 16, get_new_msg(), vlambda_v, idata);
+    EXPECT_FLOAT_EQ(poisson_lpdf_ref.val(), lpdf.val());
+    stan::math::grad(lpdf.vi_);
+    EXPECT_FLOAT_EQ(lambda_ref.adj(), lambda_v.adj());
+  }
+  stan::math::recover_memory();
+}
@@ -0,0 +1,127 @@
+#include <stan/math/rev.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+using Eigen::Dynamic;
+using Eigen::Matrix;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+// f_i(x) = x_{i - 1} * x_i^2 + sin(x_{i + 1}), a tridiagonal Jacobian
+struct tridiagonal_fun {
+  template <typename T>
+  inline Matrix<T, Dynamic, 1> operator()(
+      const Matrix<T, Dynamic, 1>& x) const {
+    const int N = x.size();
+    Matrix<T, Dynamic, 1> y(N);
+    for (int i = 0; i < N; ++i) {
+      y(i) = x(i) * x(i);
+      if (i > 0) {
+        y(i) *= x(i - 1);
+      }
+      if (i + 1 < N) {
+        y(i) += stan::math::sin(x(i + 1));
+      }
+    }
+    return y;
+  }
+};
+
+// uses a reverse pass callback, which is traced conservatively
+struct callback_fun {
+  template <typename T>
+  inline Matrix<T, Dynamic, 1> operator()(
+      const Matrix<T, Dynamic, 1>& x) const {
+    Matrix<T, Dynamic, 1> y(3);
+    y(0) = stan::math::log_sum_exp(x.head(2));
+    y(1) = x(2) * 3.0;
+    y(2) = 0.0;
+    return y;
+  }
+};
+
+TEST(RevFunctor, sparse_jacobian_traced) {
+  tridiagonal_fun f;
+  VectorXd x = VectorXd::LinSpaced(50, 0.1, 2.0);
+  VectorXd fx;
+  Eigen::SparseMatrix<double> J;
+  stan::math::sparse_jacobian(f, x, fx, J);
+
+  VectorXd fx_dense;
+  MatrixXd J_dense;
+  stan::math::jacobian(f, x, fx_dense, J_dense);
+  EXPECT_MATRIX_FLOAT_EQ(fx_dense, fx);
+  EXPECT_MATRIX_FLOAT_EQ(J_dense, MatrixXd(J));
+  EXPECT_EQ(3 * 50 - 2, J.nonZeros());
+  EXPECT_TRUE(stan::math::empty_nested());
+}
+
+TEST(RevFunctor, sparse_jacobian_coloring) {
+  std::vector<std::vector<int>> pattern(50);
+  for (int i = 0; i < 50; ++i) {
+    for (int j = std::max(i - 1, 0); j <= std::min(i + 1, 49); ++j) {
+      pattern[i].push_back(j);
+    }
+  }
+  pattern[10].clear();
+  auto groups = stan::math::internal::color_jacobian_rows(pattern, 50);
+  EXPECT_EQ(3, groups.size());
+  std::vector<int> num_groups(50, 0);
+  for (const auto& group : groups) {
+    std::vector<bool> used(50, false);
+    for (int i : group) {
+      ++num_groups[i];
+      for (int j : pattern[i]) {
+        EXPECT_FALSE(used[j]);
+        used[j] = true;
+      }
+    }
+  }
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(i == 10 ? 0 : 1, num_groups[i]);
+  }
+}
+
+TEST(RevFunctor, sparse_jacobian_opaque) {
+  callback_fun f;
+  VectorXd x(3);
+  x << 0.5, -1.0, 2.0;
+  VectorXd fx;
+  Eigen::SparseMatrix<double> J;
+  stan::math::sparse_jacobian(f, x, fx, J);
+
+  VectorXd fx_dense;
+  MatrixXd J_dense;
+  stan::math::jacobian(f, x, fx_dense, J_dense);
+  EXPECT_MATRIX_FLOAT_EQ(fx_dense, fx);
+  EXPECT_MATRIX_FLOAT_EQ(J_dense, MatrixXd(J));
+  // the result of the callback and the constant after it depend on all
+  // inputs, the row traced through linear varis only keeps its pattern
+  EXPECT_EQ(7, J.nonZeros());
+  EXPECT_TRUE(stan::math::empty_nested());
+}
+
+TEST(RevFunctor, sparse_jacobian_pattern) {
+  callback_fun f;
+  VectorXd x(3);
+  x << 0.5, -1.0, 2.0;
+  Eigen::SparseMatrix<double> pattern(3, 3);
+  pattern.insert(0, 0) = 1;
+  pattern.insert(0, 1) = 1;
+  pattern.insert(1, 2) = 1;
+  VectorXd fx;
+  Eigen::SparseMatrix<double> J;
+  stan::math::sparse_jacobian(f, x, pattern, fx, J);
+
+  VectorXd fx_dense;
+  MatrixXd J_dense;
+  stan::math::jacobian(f, x, fx_dense, J_dense);
+  EXPECT_MATRIX_FLOAT_EQ(J_dense, MatrixXd(J));
+  EXPECT_EQ(3, J.nonZeros());
+
+  Eigen::SparseMatrix<double> bad_pattern(2, 3);
+  EXPECT_THROW(stan::math::sparse_jacobian(f, x, bad_pattern, fx, J),
+               std::invalid_argument);
+}